@@ -26,7 +26,8 @@ public class ItemManager : ModuleRules
 			new string[]
 			{
 				"Core",
-				"NetCore"
+				"NetCore",
+				"GameplayTags"
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -37,6 +38,8 @@ public class ItemManager : ModuleRules
 			{
 				"CoreUObject",
 				"Engine",
+				"ItemManagerCore",
+				"DeveloperSettings",
 				"Slate",
 				"SlateCore",
 				// ... add private dependencies that you statically link with here ...	
@@ -4,6 +4,95 @@
 #include "ItemCollectable.h"
 
 #include "ItemManagerComponent.h"
+#include "ItemManagerSubsystem.h"
+#include "ItemManagerSettings.h"
+#include "ItemManagerStats.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Collectable Tick"), STAT_ItemCollectableTick, STATGROUP_ItemManager);
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice ItemCollectableTickCostCommand(
+	TEXT("ItemManager.Collectables.TickCost"),
+	TEXT("Spawn collectables and measure their tick cost per 1000 collectables. Usage: ItemManager.Collectables.TickCost <ItemClassPath> [NumCollectables] [NumFrames] [Display: Grounded|Animated|Physics|None]"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		if (!World || Args.Num() < 1)
+		{
+			Ar.Log(TEXT("Usage: ItemManager.Collectables.TickCost <ItemClassPath> [NumCollectables] [NumFrames] [Display: Grounded|Animated|Physics|None]"));
+			return;
+		}
+
+		FItemCollectableData ItemCollectableData;
+		ItemCollectableData.Item = FSoftClassPath(Args[0]).TryLoadClass<AItemParent>();
+		ItemCollectableData.ItemDisplay = EItemDisplay::ID_Animated;
+
+		if (!ItemCollectableData.Item)
+		{
+			Ar.Logf(TEXT("Failed to load item class %s"), *Args[0]);
+			return;
+		}
+
+		const int32 NumCollectables = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 1000;
+		const int32 NumFrames = Args.Num() > 2 ? FMath::Max(FCString::Atoi(*Args[2]), 1) : 100;
+
+		if (Args.Num() > 3)
+		{
+			const UEnum* ItemDisplayEnum = StaticEnum<EItemDisplay>();
+			const int64 ItemDisplay = ItemDisplayEnum->GetValueByNameString(TEXT("ID_") + Args[3]);
+			ItemCollectableData.ItemDisplay = ItemDisplay != INDEX_NONE ? static_cast<EItemDisplay>(ItemDisplay) : ItemCollectableData.ItemDisplay;
+		}
+
+		TArray<AItemCollectable*> Collectables;
+		Collectables.Reserve(NumCollectables);
+
+		const double SpawnStartTime = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < NumCollectables; Index++)
+		{
+			const FTransform Transform(FVector((Index % 100) * 200.f, (Index / 100) * 200.f, 0.f));
+			AItemCollectable* ItemCollectable = World->SpawnActorDeferred<AItemCollectable>(AItemCollectable::StaticClass(), Transform);
+
+			if (ItemCollectable)
+			{
+				ItemCollectable->Init(ItemCollectableData);
+				ItemCollectable->FinishSpawning(Transform);
+				Collectables.Add(ItemCollectable);
+			}
+		}
+		const double SpawnSeconds = FPlatformTime::Seconds() - SpawnStartTime;
+
+		// tick what the engine would tick, mesh ticks are only counted
+		int32 NumTickingActors = 0;
+		int32 NumTickingMeshes = 0;
+
+		const double TickStartTime = FPlatformTime::Seconds();
+		for (int32 Frame = 0; Frame < NumFrames; Frame++)
+		{
+			for (AItemCollectable* ItemCollectable : Collectables)
+			{
+				if (ItemCollectable->IsActorTickEnabled())
+				{
+					ItemCollectable->Tick(1.f / 60.f);
+					NumTickingActors += Frame == 0 ? 1 : 0;
+				}
+
+				if (Frame == 0 && ItemCollectable->GetSkeletalMesh() && ItemCollectable->GetSkeletalMesh()->IsComponentTickEnabled())
+				{
+					NumTickingMeshes++;
+				}
+			}
+		}
+		const double TickSeconds = FPlatformTime::Seconds() - TickStartTime;
+
+		for (AItemCollectable* ItemCollectable : Collectables)
+		{
+			ItemCollectable->Destroy();
+		}
+
+		const double Scale = 1000.0 / Collectables.Num();
+		Ar.Logf(TEXT("Server mode: %s, %d collectables, %d ticking actors, %d ticking meshes"), UItemManagerSubsystem::IsServerModeEnabled() ? TEXT("on") : TEXT("off"), Collectables.Num(), NumTickingActors, NumTickingMeshes);
+		Ar.Logf(TEXT("Spawn: %.3f ms per 1k collectables"), SpawnSeconds * 1000.0 * Scale);
+		Ar.Logf(TEXT("Tick:  %.3f ms per 1k collectables per frame"), TickSeconds * 1000.0 * Scale / NumFrames);
+	}));
 
 // Sets default values
 AItemCollectable::AItemCollectable()
@@ -11,13 +100,8 @@ AItemCollectable::AItemCollectable()
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 
-	FString OutlineMaterialPath = TEXT("/ItemManager/Materials/M_Outline_Inst.M_Outline_Inst");
-
-	UMaterialInstance* MaterialInstance = Cast<UMaterialInstance>(StaticLoadObject(UMaterialInstance::StaticClass(), nullptr, *OutlineMaterialPath));
-	if (MaterialInstance)
-	{
-		OutlineMaterial = MaterialInstance;
-	}
+	// static pickups of a level are clustered with it, marked once instead of one by one
+	bCanBeInCluster = true;
 
 	SceneComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Scene Root"));
 	RootComponent = SceneComponent;
@@ -41,9 +125,19 @@ void AItemCollectable::BeginPlay()
 	TriggerBoxComponent->OnComponentBeginOverlap.AddDynamic(this, &AItemCollectable::OnTriggerBeginOverlap);
 	TriggerBoxComponent->OnComponentEndOverlap.AddDynamic(this, &AItemCollectable::OnTriggerEndOverlap);
 
-	if(!OutlineMaterial)
+	if (UItemManagerSubsystem::IsServerModeEnabled())
 	{
-		UE_LOG(ItemManager, Error, TEXT("Cannot load OutlineMaterial"));
+		// only the trigger box and the physics of the mesh matter for authority
+		SetActorTickEnabled(false);
+
+		if (SkeletalMesh && ItemDisplay != EItemDisplay::ID_Physics)
+		{
+			SkeletalMesh->SetComponentTickEnabled(false);
+		}
+	}
+	else if(bEnableOutline && !OutlineMaterial && !UItemManagerSettings::Get()->HasOutlineMaterial())
+	{
+		UE_LOG(ItemManager, Error, TEXT("No outline material, set one in the Item Manager project settings"));
 	}
 
 	if (bEnableCollisions && !SkeletalMesh || !SkeletalMesh->GetPhysicsAsset())
@@ -52,12 +146,41 @@ void AItemCollectable::BeginPlay()
 	}
 }
 
+void AItemCollectable::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// item managers drop it now instead of at the next garbage collection
+	if (UItemManagerSubsystem* ItemManagerSubsystem = GetWorld()->GetSubsystem<UItemManagerSubsystem>())
+	{
+		ItemManagerSubsystem->UnregisterItemCollectable(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AItemCollectable::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+
+	// the instance state is allocated apart from the actor
+	if (const UScriptStruct* InstanceStateStruct = InstanceState.GetScriptStruct())
+	{
+		CumulativeResourceSize.AddDedicatedSystemMemoryBytes(InstanceStateStruct->GetStructureSize());
+	}
+}
+
 void AItemCollectable::OnConstruction(const FTransform& Transform)
 {
 	Super::OnConstruction(Transform);
 
 	TriggerBoxComponent->SetBoxExtent(Size);
-	SetupMesh();
+
+	// the baked mesh and placement are saved with the level
+	const bool bIsPlacementBaked = IsPlacementBaked();
+	if (!bIsPlacementBaked)
+	{
+		bHasBakedPlacement = false;
+		SetupMesh();
+	}
 
 	if (bCacheInvertGroundRotation != GroundTypeProperties.bInvertGroundRotation)
 	{
@@ -66,7 +189,7 @@ void AItemCollectable::OnConstruction(const FTransform& Transform)
 	}
 
 	//	Place mesh to the ground
-	if(ItemDisplay == EItemDisplay::ID_Grounded)
+	if(ItemDisplay == EItemDisplay::ID_Grounded && !bIsPlacementBaked)
 	{
 		PlaceMeshToTheGround();
 	}
@@ -88,33 +211,36 @@ void AItemCollectable::OnConstruction(const FTransform& Transform)
 
 void AItemCollectable::SetTransparency(bool Value)
 {
-	SkeletalMesh->SetRenderCustomDepth(Value);
+	if (!UItemManagerSubsystem::IsServerModeEnabled())
+	{
+		SkeletalMesh->SetRenderCustomDepth(Value);
+	}
 }
 
 void AItemCollectable::EnableTransparency()
 {
 	bEnableTransparency = true;
-	SkeletalMesh->SetRenderCustomDepth(true);
+	SetTransparency(true);
 }
 
 void AItemCollectable::DisableTransparency()
 {
 	bEnableTransparency = false;
-	SkeletalMesh->SetRenderCustomDepth(false);
+	SetTransparency(false);
 }
 
 void AItemCollectable::OnTriggerBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
 	UItemManagerComponent* ItemManagerComponent = Cast<UItemManagerComponent>(OtherActor->GetComponentByClass(UItemManagerComponent::StaticClass()));
-	SetItemInstance();
+	const AItemParent* ItemDefaults = GetItemDefaults();
 
-	if(ItemManagerComponent && ItemInstance && ItemInstance->CanBeCollected())
+	if(ItemManagerComponent && ItemDefaults && ItemDefaults->CanBeCollected())
 	{
 
-		// Add outline material
-		if (bEnableOutline && SkeletalMesh && OutlineMaterial)
+		// Add outline material, the one of the project settings is shared by every collectable
+		if (bEnableOutline && SkeletalMesh && !UItemManagerSubsystem::IsServerModeEnabled())
 		{
-			UMaterialInterface* OutlineMaterialInterface = Cast<UMaterialInterface>(OutlineMaterial);
+			UMaterialInterface* OutlineMaterialInterface = OutlineMaterial ? OutlineMaterial : UItemManagerSettings::Get()->GetOutlineMaterial();
 			SkeletalMesh->SetOverlayMaterial(OutlineMaterialInterface);
 		}
 
@@ -135,7 +261,7 @@ void AItemCollectable::OnTriggerEndOverlap(UPrimitiveComponent* OverlappedCompon
 		ItemManagerComponent->OnPickableEndOverlap(this);
 	}
 
-	if (SkeletalMesh)
+	if (SkeletalMesh && !UItemManagerSubsystem::IsServerModeEnabled())
 	{
 		SkeletalMesh->SetOverlayMaterial(nullptr);
 	}
@@ -201,30 +327,63 @@ void AItemCollectable::PlaceMeshToTheGround()
 	}
 }
 
-void AItemCollectable::SetItemInstance()
+void AItemCollectable::BakePlacement()
 {
-	if (Item)
+	bHasBakedPlacement = false;
+
+	SetupMesh();
+
+	if (ItemDisplay == EItemDisplay::ID_Grounded)
 	{
-		ItemClass = Item.Get();
+		PlaceMeshToTheGround();
+	}
+
+	BakedPlacementHash = GetPlacementHash();
+	BakedActorTransform = GetActorTransform();
+	bHasBakedPlacement = true;
+}
+
+bool AItemCollectable::IsPlacementBaked() const
+{
+	return bHasBakedPlacement && BakedPlacementHash == GetPlacementHash() && GetActorTransform().Equals(BakedActorTransform);
+}
+
+uint32 AItemCollectable::GetPlacementHash() const
+{
+	// only what SetupMesh and PlaceMeshToTheGround read, paths are stable between sessions
+	uint32 Hash = GetTypeHash(GetPathNameSafe(Item.Get()));
 
-		if (ItemClass)
+	if (Item)
+	{
+		if (USkeletalMeshComponent* ItemMesh = Item.GetDefaultObject()->GetSkeletalMesh())
 		{
-			ItemInstance = NewObject<AItemParent>(this, ItemClass);
-		}
-		else {
-			UE_LOG(LogTemp, Warning, TEXT("Could not get class"));
+			Hash = HashCombine(Hash, GetTypeHash(GetPathNameSafe(ItemMesh->GetSkeletalMeshAsset())));
 		}
 	}
+
+	Hash = HashCombine(Hash, GetTypeHash(ItemDisplay));
+	Hash = HashCombine(Hash, GetTypeHash(GroundTypeProperties.GroundRotationType));
+	Hash = HashCombine(Hash, GetTypeHash(GroundTypeProperties.UseItemWidthInstead));
+	Hash = HashCombine(Hash, GetTypeHash(GroundTypeProperties.MaxHeight));
+	Hash = HashCombine(Hash, GetTypeHash(GroundTypeProperties.AdjustedRotator.Euler()));
+	Hash = HashCombine(Hash, GetTypeHash(GroundTypeProperties.bInvertGroundRotation));
+
+	return Hash;
 }
 
 void AItemCollectable::SetupMesh()
 {
+	// the mesh is only needed on the server for collisions and physics
+	if (UItemManagerSubsystem::IsServerModeEnabled() && !bEnableCollisions && ItemDisplay != EItemDisplay::ID_Physics)
+	{
+		return;
+	}
 
-	SetItemInstance();
+	AItemParent* ItemDefaults = GetItemDefaults();
 
-	if (ItemInstance && ItemInstance->GetSkeletalMesh() && ItemInstance->GetSkeletalMesh())
+	if (ItemDefaults && ItemDefaults->GetSkeletalMesh())
 	{
-		SkeletalMesh->SetSkeletalMeshAsset(ItemInstance->GetSkeletalMesh()->GetSkeletalMeshAsset());
+		SkeletalMesh->SetSkeletalMeshAsset(ItemDefaults->GetSkeletalMesh()->GetSkeletalMeshAsset());
 
 		if (SkeletalMesh->GetSkeletalMeshAsset())
 		{
@@ -259,7 +418,7 @@ void AItemCollectable::AnimatedMesh(float DeltaTime)
 	}
 }
 
-void AItemCollectable::Init(FItemCollectableData ItemCollectableData)
+void AItemCollectable::Init(const FItemCollectableData& ItemCollectableData)
 {
 	Item = ItemCollectableData.Item;
 	Size = ItemCollectableData.Size;
@@ -289,6 +448,8 @@ void AItemCollectable::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+	SCOPE_CYCLE_COUNTER(STAT_ItemCollectableTick);
+
 	if (ItemDisplay == EItemDisplay::ID_Animated)
 	{
 		AnimatedMesh(DeltaTime);
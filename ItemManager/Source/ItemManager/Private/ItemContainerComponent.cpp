@@ -0,0 +1,429 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+
+#include "ItemContainerComponent.h"
+#include "ItemManagerSubsystem.h"
+#include "ItemManagerStats.h"
+#include "utils/ItemConfigRegistry.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Container Transferred Items"), STAT_ItemContainerTransferredItems, STATGROUP_ItemManager);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Container Spilled Items"), STAT_ItemContainerSpilledItems, STATGROUP_ItemManager);
+
+namespace ItemContainer
+{
+    static constexpr uint32 Magic = 0x49434e54; // 'ICNT'
+    static constexpr uint32 Version = 2;
+
+    void SerializeItemCollectableData(FArchive& Ar, FItemCollectableData& Data)
+    {
+        FSoftObjectPath OutlineMaterialPath(Data.OutlineMaterial);
+        uint8 ItemDisplay = static_cast<uint8>(Data.ItemDisplay);
+        uint8 GroundRotationType = static_cast<uint8>(Data.GroundTypeProperties.GroundRotationType);
+
+        Ar << Data.Size;
+        Ar << ItemDisplay;
+        Ar << GroundRotationType;
+        Ar << Data.GroundTypeProperties.UseItemWidthInstead;
+        Ar << Data.GroundTypeProperties.MaxHeight;
+        Ar << Data.GroundTypeProperties.AdjustedRotator;
+        Ar << Data.GroundTypeProperties.bInvertGroundRotation;
+        Ar << Data.AnimatedItemProperties.Height;
+        Ar << Data.AnimatedItemProperties.HeightSpeed;
+        Ar << Data.AnimatedItemProperties.RotationSpeed;
+        Ar << Data.bEnableCollisions;
+        Ar << Data.bEnableTransparency;
+        Ar << Data.bEnableOutline;
+        Ar << OutlineMaterialPath;
+
+        if (Ar.IsLoading())
+        {
+            Data.ItemDisplay = static_cast<EItemDisplay>(ItemDisplay);
+            Data.GroundTypeProperties.GroundRotationType = static_cast<EGroundedType>(GroundRotationType);
+            Data.OutlineMaterial = Cast<UMaterialInstance>(OutlineMaterialPath.TryLoad());
+        }
+    }
+
+    // written as a blob, a state whose struct no longer exists is skipped
+    void SerializeInstanceState(FArchive& Ar, FInstancedStruct& InstanceState)
+    {
+        FSoftObjectPath StructPath(InstanceState.GetScriptStruct());
+        TArray<uint8> Bytes;
+
+        if (Ar.IsSaving() && InstanceState.IsValid())
+        {
+            FMemoryWriter Writer(Bytes);
+            Writer.ArIsSaveGame = true;
+            FObjectAndNameAsStringProxyArchive ProxyWriter(Writer, true);
+            InstanceState.GetScriptStruct()->SerializeItem(ProxyWriter, InstanceState.GetMutableMemory(), nullptr);
+        }
+
+        Ar << StructPath;
+        Ar << Bytes;
+
+        if (Ar.IsLoading())
+        {
+            InstanceState.Reset();
+
+            UScriptStruct* InstanceStateStruct = StructPath.IsValid() ? Cast<UScriptStruct>(StructPath.TryLoad()) : nullptr;
+
+            if (InstanceStateStruct)
+            {
+                InstanceState.InitializeAs(InstanceStateStruct);
+
+                FMemoryReader Reader(Bytes);
+                Reader.ArIsSaveGame = true;
+                FObjectAndNameAsStringProxyArchive ProxyReader(Reader, true);
+                InstanceStateStruct->SerializeItem(ProxyReader, InstanceState.GetMutableMemory(), nullptr);
+            }
+            else if (StructPath.IsValid())
+            {
+                UE_LOG(ItemManager, Warning, TEXT("Item container: failed to load instance state %s"), *StructPath.ToString());
+            }
+        }
+    }
+}
+
+UItemContainerComponent::UItemContainerComponent()
+{
+    PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UItemContainerComponent::Serialize(FArchive& Ar)
+{
+    Super::Serialize(Ar);
+
+    if (Ar.IsSaveGame())
+    {
+        SerializeItems(Ar);
+    }
+}
+
+void UItemContainerComponent::SerializeItems(FArchive& Ar)
+{
+    uint32 Magic = ItemContainer::Magic;
+    uint32 Version = ItemContainer::Version;
+
+    Ar << Magic;
+    Ar << Version;
+
+    if (Ar.IsLoading() && (Magic != ItemContainer::Magic || Version > ItemContainer::Version))
+    {
+        Ar.SetError();
+        return;
+    }
+
+    Ar << bAreItemsGenerated;
+
+    int32 NumItems = Items.Num();
+    Ar << NumItems;
+
+    if (Ar.IsLoading())
+    {
+        if (NumItems < 0)
+        {
+            Ar.SetError();
+            return;
+        }
+
+        Items.Reset(NumItems);
+    }
+
+    for (int32 ItemIndex = 0; ItemIndex < NumItems && !Ar.IsError(); ItemIndex++)
+    {
+        FSoftClassPath ItemPath = Ar.IsSaving() ? FSoftClassPath(Items[ItemIndex].Item.Get()) : FSoftClassPath();
+        Ar << ItemPath;
+
+        // only collectables differing from the item defaults are written in full
+        bool bHasCustomCollectableData = Ar.IsSaving() && Items[ItemIndex].ItemCollectableData.Get() != &FItemConfigRegistry::Get().GetItemCollectableData(Items[ItemIndex].Item).Get();
+        Ar << bHasCustomCollectableData;
+
+        FItemCollectableData ItemCollectableData = Ar.IsSaving() ? Items[ItemIndex].GetItemCollectableData() : FItemCollectableData();
+        if (bHasCustomCollectableData)
+        {
+            ItemContainer::SerializeItemCollectableData(Ar, ItemCollectableData);
+        }
+
+        FInstancedStruct InstanceState = Ar.IsSaving() ? Items[ItemIndex].InstanceState : FInstancedStruct();
+        if (Version >= 2)
+        {
+            ItemContainer::SerializeInstanceState(Ar, InstanceState);
+        }
+
+        if (Ar.IsLoading())
+        {
+            TSubclassOf<AItemParent> Item = ItemPath.TryLoadClass<AItemParent>();
+
+            if (!Item)
+            {
+                UE_LOG(ItemManager, Warning, TEXT("Item container of %s: failed to load item %s"), *GetNameSafe(GetOwner()), *ItemPath.ToString());
+                continue;
+            }
+
+            ItemCollectableData.Item = Item;
+
+            FItemObject& ItemObject = Items.AddDefaulted_GetRef();
+            ItemObject.Item = Item;
+            ItemObject.Actor = nullptr;
+            ItemObject.ItemInfos = FItemConfigRegistry::Get().GetItemInfos(Item);
+            ItemObject.ItemCollectableData = bHasCustomCollectableData ? FItemConfigRegistry::Get().Intern(ItemCollectableData) : FItemConfigRegistry::Get().GetItemCollectableData(Item);
+            ItemObject.InstanceState = MoveTemp(InstanceState);
+        }
+    }
+}
+
+void UItemContainerComponent::GenerateItems()
+{
+    if (bAreItemsGenerated)
+    {
+        return;
+    }
+
+    bAreItemsGenerated = true;
+
+    TArray<TSharedRef<const FItemCollectableData>> Loot;
+
+    for (const TSubclassOf<AItemParent>& Item : DefaultItems)
+    {
+        if (Item)
+        {
+            Loot.Add(FItemConfigRegistry::Get().GetItemCollectableData(Item));
+        }
+    }
+
+    if (LootTable)
+    {
+        LootTable->GenerateLoot(LootSeed, LootContextTags, Loot);
+    }
+
+    Items.Reserve(Items.Num() + Loot.Num());
+
+    for (const TSharedRef<const FItemCollectableData>& ItemCollectableData : Loot)
+    {
+        if (MaxItems > 0 && Items.Num() >= MaxItems)
+        {
+            break;
+        }
+
+        FItemObject& ItemObject = Items.AddDefaulted_GetRef();
+        ItemObject.Item = ItemCollectableData->Item;
+        ItemObject.Actor = nullptr;
+        ItemObject.ItemInfos = FItemConfigRegistry::Get().GetItemInfos(ItemCollectableData->Item);
+        ItemObject.ItemCollectableData = ItemCollectableData;
+    }
+}
+
+TArray<FItemObject> UItemContainerComponent::GetItems()
+{
+    GenerateItems();
+    return Items;
+}
+
+int32 UItemContainerComponent::GetNumItems()
+{
+    GenerateItems();
+    return Items.Num();
+}
+
+bool UItemContainerComponent::AddItem(TSubclassOf<AItemParent> Item)
+{
+    GenerateItems();
+
+    if (!IsValid(Item) || (MaxItems > 0 && Items.Num() >= MaxItems))
+    {
+        return false;
+    }
+
+    FItemObject& ItemObject = Items.AddDefaulted_GetRef();
+    ItemObject.Item = Item;
+    ItemObject.Actor = nullptr;
+    ItemObject.ItemInfos = FItemConfigRegistry::Get().GetItemInfos(Item);
+    ItemObject.ItemCollectableData = FItemConfigRegistry::Get().GetItemCollectableData(Item);
+
+    OnContainerChanged.Broadcast();
+    return true;
+}
+
+FItemBatchResult UItemContainerComponent::TransferToManager(UItemManagerComponent* Manager, const TArray<int32>& ItemIndices, bool bEquipFirstItem)
+{
+    FItemBatchResult Result;
+
+    GenerateItems();
+
+    TArray<int32> SortedIndices;
+    SortedIndices.Reserve(ItemIndices.Num());
+
+    for (int32 EntryIndex = 0; EntryIndex < ItemIndices.Num(); EntryIndex++)
+    {
+        if (!Items.IsValidIndex(ItemIndices[EntryIndex]) || SortedIndices.Contains(ItemIndices[EntryIndex]))
+        {
+            Result.Error = 1;
+            Result.FailedEntry = EntryIndex;
+            return Result;
+        }
+
+        SortedIndices.Add(ItemIndices[EntryIndex]);
+    }
+
+    if (!IsValid(Manager))
+    {
+        Result.Error = 1;
+        return Result;
+    }
+
+    TArray<FItemObject> TransferredItems;
+    TransferredItems.Reserve(ItemIndices.Num());
+
+    for (const int32 ItemIndex : ItemIndices)
+    {
+        TransferredItems.Add(Items[ItemIndex]);
+    }
+
+    // the manager validates the whole set, nothing leaves the container if it refuses
+    Result = Manager->AddItemObjects(TransferredItems, bEquipFirstItem);
+
+    if (Result.Error != 0)
+    {
+        return Result;
+    }
+
+    SortedIndices.Sort(TGreater<int32>());
+    for (const int32 ItemIndex : SortedIndices)
+    {
+        Items.RemoveAt(ItemIndex, 1, EAllowShrinking::No);
+    }
+
+    INC_DWORD_STAT_BY(STAT_ItemContainerTransferredItems, TransferredItems.Num());
+    OnContainerChanged.Broadcast();
+
+    return Result;
+}
+
+FItemBatchResult UItemContainerComponent::TransferAllToManager(UItemManagerComponent* Manager)
+{
+    GenerateItems();
+
+    TArray<int32> ItemIndices;
+    ItemIndices.Reserve(Items.Num());
+
+    for (int32 ItemIndex = 0; ItemIndex < Items.Num(); ItemIndex++)
+    {
+        ItemIndices.Add(ItemIndex);
+    }
+
+    return TransferToManager(Manager, ItemIndices);
+}
+
+FItemBatchResult UItemContainerComponent::TransferFromManager(UItemManagerComponent* Manager, const TArray<FItemSlotHandle>& Slots)
+{
+    FItemBatchResult Result;
+
+    GenerateItems();
+
+    if (!IsValid(Manager))
+    {
+        Result.Error = 1;
+        return Result;
+    }
+
+    if (MaxItems > 0 && Items.Num() + Slots.Num() > MaxItems)
+    {
+        Result.Error = 2;
+        Result.FailedEntry = FMath::Max(MaxItems - Items.Num(), 0);
+        return Result;
+    }
+
+    // non droppable items (e.g. the empty item) cannot leave the manager
+    for (int32 EntryIndex = 0; EntryIndex < Slots.Num(); EntryIndex++)
+    {
+        FItemObject ItemObject;
+
+        if (!Manager->GetItemFromHandle(Slots[EntryIndex], ItemObject) || !ItemObject.GetItemInfos().bIsDropable)
+        {
+            Result.Error = 1;
+            Result.FailedEntry = EntryIndex;
+            return Result;
+        }
+    }
+
+    TArray<FItemObject> TransferredItems;
+    Result = Manager->RemoveItemObjects(Slots, TransferredItems);
+
+    if (Result.Error != 0)
+    {
+        return Result;
+    }
+
+    Items.Append(MoveTemp(TransferredItems));
+
+    INC_DWORD_STAT_BY(STAT_ItemContainerTransferredItems, Slots.Num());
+    OnContainerChanged.Broadcast();
+
+    return Result;
+}
+
+int32 UItemContainerComponent::SpillToGround(float Radius)
+{
+    GenerateItems();
+
+    UItemManagerSubsystem* ItemManagerSubsystem = GetWorld()->GetSubsystem<UItemManagerSubsystem>();
+
+    if (!ItemManagerSubsystem || !IsValid(GetOwner()) || Items.Num() <= 0)
+    {
+        return 0;
+    }
+
+    FItemLootBatch Batch;
+    Batch.DrawOffsets.Add(0);
+
+    for (const FItemObject& ItemObject : Items)
+    {
+        Batch.Loot.Add(ItemObject.GetItemCollectableDataRef());
+        Batch.InstanceStates.Add(ItemObject.InstanceState);
+    }
+
+    Batch.DrawOffsets.Add(Batch.Loot.Num());
+
+    // collectables are spawned by the scheduler, within its frame budget
+    ItemManagerSubsystem->SpawnLootBatch(Batch, { GetOwner()->GetActorTransform() }, Radius);
+
+    int32 const NumSpilledItems = Items.Num();
+    Items.Empty();
+
+    INC_DWORD_STAT_BY(STAT_ItemContainerSpilledItems, NumSpilledItems);
+    OnContainerChanged.Broadcast();
+
+    return NumSpilledItems;
+}
+
+void UItemContainerComponent::SaveItems(TArray<uint8>& OutData)
+{
+    OutData.Reset();
+
+    FMemoryWriter Writer(OutData);
+    Writer.ArIsSaveGame = true;
+    SerializeItems(Writer);
+}
+
+bool UItemContainerComponent::LoadItems(const TArray<uint8>& Data)
+{
+    FMemoryReader Reader(Data);
+    Reader.ArIsSaveGame = true;
+
+    TArray<FItemObject> PreviousItems = Items;
+    bool const bPreviousAreItemsGenerated = bAreItemsGenerated;
+
+    SerializeItems(Reader);
+
+    if (Reader.IsError())
+    {
+        Items = MoveTemp(PreviousItems);
+        bAreItemsGenerated = bPreviousAreItemsGenerated;
+        return false;
+    }
+
+    OnContainerChanged.Broadcast();
+    return true;
+}
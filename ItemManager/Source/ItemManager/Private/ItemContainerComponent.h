@@ -0,0 +1,86 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "ItemManagerComponent.h"
+#include "ItemLootTable.h"
+#include "ItemContainerComponent.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnContainerChangedDelegate);
+
+/**
+ * World storage (chests, lockers) holding item records only.
+ * Items are moved to and from item managers without spawning any actor, ItemCollectables are only spawned when spilling.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent, DisplayName = "Item Container", ToolTip = "Item Container Component"), Category = "Item Manager")
+class UItemContainerComponent : public UActorComponent
+{
+    GENERATED_BODY()
+
+public:
+
+    UItemContainerComponent();
+
+    // Items are saved with the actor when serialized for a save game
+    virtual void Serialize(FArchive& Ar) override;
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Items", ToolTip = "Get the items of the container. The default items and loot are generated on the first access."), Category = "Item Container")
+    TArray<FItemObject> GetItems();
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Num Items"), Category = "Item Container")
+    int32 GetNumItems();
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Add Item", ToolTip = "Add an item to the container. Return false if the container is full or the item is invalid."), Category = "Item Container")
+    bool AddItem(TSubclassOf<AItemParent> Item);
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Transfer To Manager", ToolTip = "Move items of the container to the item manager, all or none of them. No actor is spawned."), Category = "Item Container")
+    FItemBatchResult TransferToManager(UItemManagerComponent* Manager, const TArray<int32>& ItemIndices, bool bEquipFirstItem = false);
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Transfer All To Manager", ToolTip = "Move every item of the container to the item manager, all or none of them. No actor is spawned."), Category = "Item Container")
+    FItemBatchResult TransferAllToManager(UItemManagerComponent* Manager);
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Transfer From Manager", ToolTip = "Move droppable items of the item manager to the container, all or none of them. No ItemCollectable is spawned."), Category = "Item Container")
+    FItemBatchResult TransferFromManager(UItemManagerComponent* Manager, const TArray<FItemSlotHandle>& Slots);
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Spill To Ground", ToolTip = "Spawn an ItemCollectable for every item around the owner and empty the container. Return the number of items spilled."), Category = "Item Container")
+    int32 SpillToGround(float Radius = 100.f);
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Save Items", ToolTip = "Write the items of the container to a byte array"), Category = "Item Container")
+    void SaveItems(TArray<uint8>& OutData);
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Load Items", ToolTip = "Replace the items of the container by the ones saved with Save Items. Return false if the data is invalid."), Category = "Item Container")
+    bool LoadItems(const TArray<uint8>& Data);
+
+    UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Container Changed", ToolTip = "Called when items are added, removed or loaded"), Category = "Item Container")
+    FOnContainerChangedDelegate OnContainerChanged;
+
+protected:
+
+    UPROPERTY(EditAnywhere, meta = (DisplayName = "Default Items", ToolTip = "Items of the container when first opened"), Category = "Item Container")
+    TArray<TSubclassOf<AItemParent>> DefaultItems;
+
+    UPROPERTY(EditAnywhere, meta = (DisplayName = "Loot Table", ToolTip = "If set, drawn once and added to the default items when first opened"), Category = "Item Container")
+    TObjectPtr<UItemLootTable> LootTable;
+
+    UPROPERTY(EditAnywhere, meta = (DisplayName = "Loot Seed", ToolTip = "Seed of the loot table draw. The same seed always gives the same items."), Category = "Item Container")
+    int32 LootSeed{ 0 };
+
+    UPROPERTY(EditAnywhere, meta = (DisplayName = "Loot Context Tags"), Category = "Item Container")
+    FGameplayTagContainer LootContextTags;
+
+    UPROPERTY(EditAnywhere, meta = (DisplayName = "Max Items", ToolTip = "If set to 0, the container is unlimited"), Category = "Item Container")
+    int32 MaxItems{ 0 };
+
+private:
+
+    // same records as the item managers, without actor nor slot id
+    TArray<FItemObject> Items;
+
+    // default items and loot are only generated when someone looks into the container
+    bool bAreItemsGenerated = false;
+
+    void GenerateItems();
+    void SerializeItems(FArchive& Ar);
+};
@@ -0,0 +1,361 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+
+#include "ItemLootTable.h"
+#include "ItemManagerComponent.h"
+#include "ItemManagerStats.h"
+#include "utils/ItemConfigRegistry.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+
+DECLARE_CYCLE_STAT(TEXT("Loot Compile"), STAT_ItemLootCompile, STATGROUP_ItemManager);
+DECLARE_CYCLE_STAT(TEXT("Loot Generate"), STAT_ItemLootGenerate, STATGROUP_ItemManager);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Loot Draws"), STAT_ItemLootDraws, STATGROUP_ItemManager);
+
+// draws per parallel task, small enough to balance nested tables, big enough to amortize the task
+static constexpr int32 LootBatchChunkSize = 256;
+
+static int32 GetLootDrawSeed(int32 Seed, int32 DrawIndex)
+{
+    return static_cast<int32>(HashCombine(GetTypeHash(Seed), GetTypeHash(DrawIndex)));
+}
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice ItemLootBenchmarkCommand(
+    TEXT("ItemManager.Loot.Benchmark"),
+    TEXT("Draw a loot table many times and log the draws per second. Usage: ItemManager.Loot.Benchmark <LootTablePath> [NumDraws] [Seed]"),
+    FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+    {
+        if (Args.Num() < 1)
+        {
+            Ar.Log(TEXT("Usage: ItemManager.Loot.Benchmark <LootTablePath> [NumDraws] [Seed]"));
+            return;
+        }
+
+        UItemLootTable* LootTable = LoadObject<UItemLootTable>(nullptr, *Args[0]);
+        if (!LootTable)
+        {
+            Ar.Logf(TEXT("Failed to load loot table %s"), *Args[0]);
+            return;
+        }
+
+        const int32 NumDraws = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 100000;
+        const int32 Seed = Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 0;
+        const FGameplayTagContainer ContextTags;
+
+        double StartTime = FPlatformTime::Seconds();
+        const TSharedRef<const FItemLootSampler> Sampler = LootTable->GetSampler(ContextTags);
+        const double CompileSeconds = FPlatformTime::Seconds() - StartTime;
+
+        TArray<TSharedRef<const FItemCollectableData>> Loot;
+        Loot.Reserve(NumDraws);
+
+        StartTime = FPlatformTime::Seconds();
+        for (int32 DrawIndex = 0; DrawIndex < NumDraws; DrawIndex++)
+        {
+            Sampler->Draw(FRandomStream(GetLootDrawSeed(Seed, DrawIndex)), Loot);
+        }
+        const double SerialSeconds = FPlatformTime::Seconds() - StartTime;
+
+        FItemLootBatch Batch;
+        StartTime = FPlatformTime::Seconds();
+        LootTable->GenerateLootBatch(Seed, NumDraws, ContextTags, Batch);
+        const double BatchSeconds = FPlatformTime::Seconds() - StartTime;
+
+        Ar.Logf(TEXT("%s: compiled in %.3f ms, %d draws, %d items"), *LootTable->GetName(), CompileSeconds * 1000.0, NumDraws, Batch.Loot.Num());
+        Ar.Logf(TEXT("Serial: %.3f ms, %.0f draws/s"), SerialSeconds * 1000.0, NumDraws / FMath::Max(SerialSeconds, UE_DOUBLE_SMALL_NUMBER));
+        Ar.Logf(TEXT("Batch:  %.3f ms, %.0f draws/s"), BatchSeconds * 1000.0, NumDraws / FMath::Max(BatchSeconds, UE_DOUBLE_SMALL_NUMBER));
+        bool bIsDeterministic = Loot.Num() == Batch.Loot.Num();
+        for (int32 Index = 0; bIsDeterministic && Index < Loot.Num(); Index++)
+        {
+            bIsDeterministic = Loot[Index] == Batch.Loot[Index];
+        }
+
+        Ar.Logf(TEXT("Serial and batch loot match: %s"), bIsDeterministic ? TEXT("yes") : TEXT("NO"));
+    }));
+
+void FItemLootAliasTable::Build(const TArray<float>& Weights)
+{
+    const int32 NumWeights = Weights.Num();
+
+    Probabilities.Reset();
+    Aliases.Reset();
+
+    double TotalWeight = 0.0;
+    for (const float Weight : Weights)
+    {
+        TotalWeight += FMath::Max(Weight, 0.f);
+    }
+
+    if (NumWeights <= 0 || TotalWeight <= 0.0)
+    {
+        return;
+    }
+
+    Probabilities.SetNumUninitialized(NumWeights);
+    Aliases.SetNumUninitialized(NumWeights);
+
+    // scaled so that the average column is 1
+    TArray<double> Scaled;
+    Scaled.SetNumUninitialized(NumWeights);
+
+    TArray<int32> Small;
+    TArray<int32> Large;
+
+    for (int32 Index = 0; Index < NumWeights; Index++)
+    {
+        Scaled[Index] = FMath::Max(Weights[Index], 0.f) * NumWeights / TotalWeight;
+        Aliases[Index] = Index;
+
+        if (Scaled[Index] < 1.0)
+        {
+            Small.Add(Index);
+        }
+        else
+        {
+            Large.Add(Index);
+        }
+    }
+
+    while (Small.Num() > 0 && Large.Num() > 0)
+    {
+        const int32 SmallIndex = Small.Pop(EAllowShrinking::No);
+        const int32 LargeIndex = Large.Pop(EAllowShrinking::No);
+
+        Probabilities[SmallIndex] = static_cast<float>(Scaled[SmallIndex]);
+        Aliases[SmallIndex] = LargeIndex;
+
+        Scaled[LargeIndex] = (Scaled[LargeIndex] + Scaled[SmallIndex]) - 1.0;
+
+        if (Scaled[LargeIndex] < 1.0)
+        {
+            Small.Add(LargeIndex);
+        }
+        else
+        {
+            Large.Add(LargeIndex);
+        }
+    }
+
+    // what is left is 1 up to rounding errors
+    for (const int32 Index : Large)
+    {
+        Probabilities[Index] = 1.f;
+    }
+
+    for (const int32 Index : Small)
+    {
+        Probabilities[Index] = 1.f;
+    }
+}
+
+int32 FItemLootAliasTable::Sample(const FRandomStream& RandomStream) const
+{
+    const int32 Column = RandomStream.RandHelper(Probabilities.Num());
+    return RandomStream.GetFraction() < Probabilities[Column] ? Column : Aliases[Column];
+}
+
+void FItemLootSampler::Draw(const FRandomStream& RandomStream, TArray<TSharedRef<const FItemCollectableData>>& OutLoot) const
+{
+    if (AliasTable.IsEmpty())
+    {
+        return;
+    }
+
+    const int32 NumRolls = RandomStream.RandRange(MinRolls, MaxRolls);
+
+    for (int32 Roll = 0; Roll < NumRolls; Roll++)
+    {
+        const FCompiledEntry& Entry = Entries[AliasTable.Sample(RandomStream)];
+        const int32 Quantity = RandomStream.RandRange(Entry.MinQuantity, Entry.MaxQuantity);
+
+        if (Entry.NestedSampler.IsValid())
+        {
+            for (int32 Index = 0; Index < Quantity; Index++)
+            {
+                Entry.NestedSampler->Draw(RandomStream, OutLoot);
+            }
+        }
+        else if (Entry.ItemCollectableData.IsValid())
+        {
+            for (int32 Index = 0; Index < Quantity; Index++)
+            {
+                OutLoot.Add(Entry.ItemCollectableData.ToSharedRef());
+            }
+        }
+    }
+}
+
+TSharedRef<const FItemLootSampler> UItemLootTable::GetSampler(const FGameplayTagContainer& ContextTags)
+{
+    check(IsInGameThread());
+
+    for (const TPair<FGameplayTagContainer, TSharedRef<const FItemLootSampler>>& Sampler : Samplers)
+    {
+        if (Sampler.Key == ContextTags)
+        {
+            return Sampler.Value;
+        }
+    }
+
+    if (bIsCompiling)
+    {
+        UE_LOG(ItemManager, Warning, TEXT("Loot table %s nests itself, the nested entry is ignored"), *GetName());
+        return MakeShared<FItemLootSampler>();
+    }
+
+    TSharedRef<const FItemLootSampler> Sampler = Compile(ContextTags);
+    Samplers.Emplace(ContextTags, Sampler);
+    return Sampler;
+}
+
+TSharedRef<const FItemLootSampler> UItemLootTable::Compile(const FGameplayTagContainer& ContextTags)
+{
+    SCOPE_CYCLE_COUNTER(STAT_ItemLootCompile);
+
+    TSharedRef<FItemLootSampler> Sampler = MakeShared<FItemLootSampler>();
+    Sampler->MinRolls = FMath::Max(MinRolls, 0);
+    Sampler->MaxRolls = FMath::Max(MaxRolls, Sampler->MinRolls);
+
+    TGuardValue<bool> CompilingGuard(bIsCompiling, true);
+
+    TArray<float> Weights;
+
+    for (const FItemLootEntry& Entry : Entries)
+    {
+        // conditions are resolved once here, the draws never look at the tags
+        if (Entry.Weight <= 0.f || (!Entry.Condition.IsEmpty() && !Entry.Condition.Matches(ContextTags)))
+        {
+            continue;
+        }
+
+        FItemLootSampler::FCompiledEntry& CompiledEntry = Sampler->Entries.AddDefaulted_GetRef();
+        CompiledEntry.MinQuantity = FMath::Max(Entry.MinQuantity, 0);
+        CompiledEntry.MaxQuantity = FMath::Max(Entry.MaxQuantity, CompiledEntry.MinQuantity);
+
+        if (Entry.NestedTable)
+        {
+            CompiledEntry.NestedSampler = Entry.NestedTable->GetSampler(ContextTags);
+        }
+        else if (Entry.Item)
+        {
+            CompiledEntry.ItemCollectableData = FItemConfigRegistry::Get().GetItemCollectableData(Entry.Item);
+        }
+
+        Weights.Add(Entry.Weight);
+    }
+
+    Sampler->AliasTable.Build(Weights);
+
+    return Sampler;
+}
+
+void UItemLootTable::GenerateLoot(int32 Seed, const FGameplayTagContainer& ContextTags, TArray<TSharedRef<const FItemCollectableData>>& OutLoot)
+{
+    SCOPE_CYCLE_COUNTER(STAT_ItemLootGenerate);
+
+    GetSampler(ContextTags)->Draw(FRandomStream(Seed), OutLoot);
+
+    INC_DWORD_STAT(STAT_ItemLootDraws);
+}
+
+void UItemLootTable::GenerateLootBatch(int32 Seed, int32 NumDraws, const FGameplayTagContainer& ContextTags, FItemLootBatch& OutBatch)
+{
+    SCOPE_CYCLE_COUNTER(STAT_ItemLootGenerate);
+
+    OutBatch.Loot.Reset();
+    OutBatch.DrawOffsets.Reset();
+
+    if (NumDraws <= 0)
+    {
+        return;
+    }
+
+    const TSharedRef<const FItemLootSampler> Sampler = GetSampler(ContextTags);
+    const int32 NumChunks = FMath::DivideAndRoundUp(NumDraws, LootBatchChunkSize);
+
+    struct FLootChunk
+    {
+        TArray<TSharedRef<const FItemCollectableData>> Loot;
+        TArray<int32> DrawOffsets;
+    };
+
+    TArray<FLootChunk> Chunks;
+    Chunks.SetNum(NumChunks);
+
+    // every draw has its own seed, the result does not depend on how the chunks are scheduled
+    ParallelFor(NumChunks, [&Chunks, &Sampler, Seed, NumDraws](int32 ChunkIndex)
+    {
+        FLootChunk& Chunk = Chunks[ChunkIndex];
+        const int32 FirstDraw = ChunkIndex * LootBatchChunkSize;
+        const int32 LastDraw = FMath::Min(FirstDraw + LootBatchChunkSize, NumDraws);
+
+        Chunk.Loot.Reserve(LastDraw - FirstDraw);
+        Chunk.DrawOffsets.Reserve(LastDraw - FirstDraw);
+
+        for (int32 DrawIndex = FirstDraw; DrawIndex < LastDraw; DrawIndex++)
+        {
+            Chunk.DrawOffsets.Add(Chunk.Loot.Num());
+            Sampler->Draw(FRandomStream(GetLootDrawSeed(Seed, DrawIndex)), Chunk.Loot);
+        }
+    });
+
+    int32 NumLoot = 0;
+    for (const FLootChunk& Chunk : Chunks)
+    {
+        NumLoot += Chunk.Loot.Num();
+    }
+
+    OutBatch.Loot.Reserve(NumLoot);
+    OutBatch.DrawOffsets.Reserve(NumDraws + 1);
+
+    for (FLootChunk& Chunk : Chunks)
+    {
+        const int32 ChunkOffset = OutBatch.Loot.Num();
+
+        for (const int32 DrawOffset : Chunk.DrawOffsets)
+        {
+            OutBatch.DrawOffsets.Add(ChunkOffset + DrawOffset);
+        }
+
+        OutBatch.Loot.Append(MoveTemp(Chunk.Loot));
+    }
+
+    OutBatch.DrawOffsets.Add(OutBatch.Loot.Num());
+
+    INC_DWORD_STAT_BY(STAT_ItemLootDraws, NumDraws);
+}
+
+TArray<TSubclassOf<AItemParent>> UItemLootTable::GenerateLootItems(int32 Seed, FGameplayTagContainer ContextTags)
+{
+    TArray<TSharedRef<const FItemCollectableData>> Loot;
+    GenerateLoot(Seed, ContextTags, Loot);
+
+    TArray<TSubclassOf<AItemParent>> Items;
+    Items.Reserve(Loot.Num());
+
+    for (const TSharedRef<const FItemCollectableData>& ItemCollectableData : Loot)
+    {
+        Items.Add(ItemCollectableData->Item);
+    }
+
+    return Items;
+}
+
+void UItemLootTable::InvalidateSamplers()
+{
+    Samplers.Empty();
+}
+
+#if WITH_EDITOR
+void UItemLootTable::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+    Super::PostEditChangeProperty(PropertyChangedEvent);
+
+    // tables nesting this one keep their own compiled copy, drop them all
+    for (TObjectIterator<UItemLootTable> It; It; ++It)
+    {
+        It->InvalidateSamplers();
+    }
+}
+#endif
@@ -1,17 +1,47 @@
 // Copyright Ryckbosch Arthur 2024. All Rights Reserved.
 
 #include "ItemManager.h"
+#include "ItemManagerSettings.h"
+#include "ItemParent.h"
+#include "utils/ItemConfigRegistry.h"
+#include "Misc/CoreDelegates.h"
+#include "UObject/UObjectGlobals.h"
 
 #define LOCTEXT_NAMESPACE "FItemManagerModule"
 
 void FItemManagerModule::StartupModule()
 {
-	
+	// the asset manager is not there yet, the shared assets are only requested once the engine is up
+	PostEngineInitHandle = FCoreDelegates::OnPostEngineInit.AddLambda([]()
+	{
+		UItemManagerSettings::Get()->RequestSharedAssetsPreload();
+	});
+
+#if WITH_EDITOR
+	// the configs of item classes are cached by FItemConfigRegistry, read them again once edited
+	ObjectsReinstancedHandle = FCoreUObjectDelegates::OnObjectsReinstanced.AddLambda([](const TMap<UObject*, UObject*>&)
+	{
+		FItemConfigRegistry::Get().InvalidateClassRecords();
+	});
+
+	ObjectPropertyChangedHandle = FCoreUObjectDelegates::OnObjectPropertyChanged.AddLambda([](UObject* Object, FPropertyChangedEvent&)
+	{
+		if (Object && Object->HasAnyFlags(RF_ClassDefaultObject) && Object->IsA<AItemParent>())
+		{
+			FItemConfigRegistry::Get().InvalidateClassRecords(Object->GetClass());
+		}
+	});
+#endif
 }
 
 void FItemManagerModule::ShutdownModule()
 {
+	FCoreDelegates::OnPostEngineInit.Remove(PostEngineInitHandle);
 
+#if WITH_EDITOR
+	FCoreUObjectDelegates::OnObjectsReinstanced.Remove(ObjectsReinstancedHandle);
+	FCoreUObjectDelegates::OnObjectPropertyChanged.Remove(ObjectPropertyChangedHandle);
+#endif
 }
 
 #undef LOCTEXT_NAMESPACE
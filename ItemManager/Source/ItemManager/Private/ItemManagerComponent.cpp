@@ -2,61 +2,160 @@
 
 
 #include "ItemManagerComponent.h"
+#include "ItemManagerSubsystem.h"
+#include "ItemManagerStats.h"
+#include "Algo/BinarySearch.h"
+#include "Algo/Reverse.h"
+#include "Templates/UnrealTemplate.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/ScopeRWLock.h"
+#include "Serialization/CustomVersion.h"
 
 DEFINE_LOG_CATEGORY(ItemManager);
 
-void UItemManagerComponent::SwitchItem(int newItemIndex)
+DECLARE_DWORD_COUNTER_STAT(TEXT("Residency Hits"), STAT_ItemResidencyHits, STATGROUP_ItemManager);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Residency Misses"), STAT_ItemResidencyMisses, STATGROUP_ItemManager);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Residency Evictions"), STAT_ItemResidencyEvictions, STATGROUP_ItemManager);
+DECLARE_CYCLE_STAT(TEXT("Inventory Query"), STAT_ItemInventoryQuery, STATGROUP_ItemManager);
+DECLARE_CYCLE_STAT(TEXT("Significance Update"), STAT_ItemSignificanceUpdate, STATGROUP_ItemManager);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Virtual Managers"), STAT_ItemVirtualManagers, STATGROUP_ItemManager);
+DECLARE_CYCLE_STAT(TEXT("Held Use"), STAT_ItemHeldUse, STATGROUP_ItemManager);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Item Uses"), STAT_ItemUses, STATGROUP_ItemManager);
+DECLARE_CYCLE_STAT(TEXT("Inventory Snapshot Publish"), STAT_ItemSnapshotPublish, STATGROUP_ItemManager);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Inventory Snapshots Published"), STAT_ItemSnapshotsPublished, STATGROUP_ItemManager);
+
+struct FItemObjectCustomVersion
 {
-    float Delay;
-    float OldItemDespawnDelay;
-    float NewItemSpawnDelay;
+    enum Type
+    {
+        BeforeCustomVersionWasAdded = 0,
+        // item infos and collectable data differing from the item defaults are written after the properties
+        ConfigRecords,
+
+        VersionPlusOne,
+        LatestVersion = VersionPlusOne - 1
+    };
+
+    static const FGuid GUID;
+};
 
-    if (newItemIndex < 0 || newItemIndex >= Items.Num())
+const FGuid FItemObjectCustomVersion::GUID(0x6A1C27E4, 0x3B954F0D, 0x9E52C1A8, 0x47D03F96);
+static FCustomVersionRegistration GRegisterItemObjectCustomVersion(FItemObjectCustomVersion::GUID, FItemObjectCustomVersion::LatestVersion, TEXT("ItemObjectVer"));
+
+template<typename RecordType>
+static void SerializeConfigRecord(FArchive& Ar, TSharedPtr<const RecordType>& Record)
+{
+    if (Ar.IsSaving())
     {
-        UE_LOG(ItemManager, Warning, TEXT("Invalid item index at %d"), newItemIndex);
-        OnFailedtoSwitchItem.Broadcast(1);
-        return;
+        // saving reads the shared record only
+        RecordType::StaticStruct()->SerializeItem(Ar, const_cast<RecordType*>(Record.Get()), nullptr);
+    }
+    else
+    {
+        RecordType Value;
+        RecordType::StaticStruct()->SerializeItem(Ar, &Value, nullptr);
+        Record = FItemConfigRegistry::Get().Intern(Value);
+    }
+}
+
+bool FItemObject::Serialize(FArchive& Ar)
+{
+    Ar.UsingCustomVersion(FItemObjectCustomVersion::GUID);
+
+    UScriptStruct* const Struct = FItemObject::StaticStruct();
+    Struct->SerializeTaggedProperties(Ar, reinterpret_cast<uint8*>(this), Struct, nullptr);
+
+    // the records are immutable and the registry references their objects
+    if (Ar.IsObjectReferenceCollector())
+    {
+        return true;
+    }
+
+    FItemConfigRegistry& Registry = FItemConfigRegistry::Get();
+
+    bool bHasCustomItemInfos = Ar.IsSaving() && ItemInfos.IsValid() && (!Item || ItemInfos.Get() != &Registry.GetItemInfos(Item).Get());
+    bool bHasCustomCollectableData = Ar.IsSaving() && ItemCollectableData.IsValid() && (!Item || ItemCollectableData.Get() != &Registry.GetItemCollectableData(Item).Get());
+
+    if (Ar.IsSaving() || Ar.CustomVer(FItemObjectCustomVersion::GUID) >= FItemObjectCustomVersion::ConfigRecords)
+    {
+        Ar << bHasCustomItemInfos;
+        Ar << bHasCustomCollectableData;
+
+        if (bHasCustomItemInfos)
+        {
+            SerializeConfigRecord(Ar, ItemInfos);
+        }
+
+        if (bHasCustomCollectableData)
+        {
+            SerializeConfigRecord(Ar, ItemCollectableData);
+        }
     }
 
-    if (CurrentItemIndex == newItemIndex && ItemState != EItemState::IS_None)
-    { 
-        UE_LOG(ItemManager, Warning, TEXT("Attempt to switch to the same item"));
-        OnFailedtoSwitchItem.Broadcast(2);
-        return; 
+    if (Ar.IsLoading())
+    {
+        if (!bHasCustomItemInfos)
+        {
+            ItemInfos = Item ? Registry.GetItemInfos(Item).ToSharedPtr() : nullptr;
+        }
+
+        if (!bHasCustomCollectableData)
+        {
+            ItemCollectableData = Item ? Registry.GetItemCollectableData(Item).ToSharedPtr() : nullptr;
+        }
     }
 
-    if (bIsSwitchingItem)
+    return true;
+}
+
+static bool ItemNameLess(const FString& A, const FString& B)
+{
+    return A.Compare(B, ESearchCase::CaseSensitive) < 0;
+}
+
+void UItemManagerComponent::SwitchItem(int newItemIndex)
+{
+    FItemSwitchTransition Transition;
+    EItemSwitchError const SwitchError = InventoryCore.BeginSwitch(newItemIndex, Transition);
+
+    if (SwitchError != EItemSwitchError::SE_None)
     {
-        UE_LOG(ItemManager, Warning, TEXT("Item is switching, cannot switch at the moment."));
-        OnFailedtoSwitchItem.Broadcast(3);
-        return; 
+        switch (SwitchError)
+        {
+        case EItemSwitchError::SE_InvalidIndex: UE_LOG(ItemManager, Warning, TEXT("Invalid item index at %d"), newItemIndex); break;
+        case EItemSwitchError::SE_SameItem:     UE_LOG(ItemManager, Warning, TEXT("Attempt to switch to the same item")); break;
+        default:                                UE_LOG(ItemManager, Warning, TEXT("Item is switching, cannot switch at the moment.")); break;
+        }
+
+        OnFailedtoSwitchItem.Broadcast(static_cast<int>(SwitchError));
+        BroadcastItemEvent(EItemManagerEvent::IE_FailedToSwitch, GetCurrentItemIndex(), static_cast<int32>(SwitchError));
+        return;
     }
 
-    bIsSwitchingItem = true;
-    OldItemDespawnDelay = Items[CurrentItemIndex].ItemInfos.TimeBeforeDespawn;
-    NewItemSpawnDelay = Items[newItemIndex].ItemInfos.TimeBeforeSpawn + OldItemDespawnDelay;
-    Delay = OldItemDespawnDelay > NewItemSpawnDelay ? OldItemDespawnDelay : NewItemSpawnDelay;
+    // a held use stops with the item it was using
+    EndUseItem();
 
-    ActivateSwitching(NewItemSpawnDelay);
+    ActivateSwitching(Transition.SpawnDelay);
 
     
     // destroy current item
-    DestroyItemLambda(OldItemDespawnDelay);
-    
-    CurrentItemIndex = newItemIndex;
-    
-    ItemState = EItemState::IS_Switching;
+    DestroyItemLambda(Transition.DespawnDelay, Transition.OldIndex);
 
+    RecordItemChange(EItemChangeType::IC_StateChanged, Transition.OldIndex);
+    RecordItemChange(EItemChangeType::IC_StateChanged, newItemIndex);
 
-    SpawnItemLambda(NewItemSpawnDelay);
+
+    SpawnItemLambda(Transition.SpawnDelay);
 
 
 	UE_LOG(ItemManager, Display, TEXT("New item index is %d"), newItemIndex);
 
 	OnitemSwitchedDelegate.Broadcast(Items[newItemIndex]);
+	BroadcastItemEvent(EItemManagerEvent::IE_Switched, newItemIndex);
 }
 
-FItemCollectableData UItemManagerComponent::SetItemCollectableData(AItemCollectable* ItemCollectable)
+TSharedRef<const FItemCollectableData> UItemManagerComponent::SetItemCollectableData(AItemCollectable* ItemCollectable)
 {
     FItemCollectableData ItemCollectableData;
 
@@ -73,21 +172,29 @@ FItemCollectableData UItemManagerComponent::SetItemCollectableData(AItemCollecta
         ItemCollectableData.Size = ItemCollectable->GetTriggerBoxSize();
     }
 
-    return ItemCollectableData;
+    // collectables of the same kind share the same record
+    return FItemConfigRegistry::Get().Intern(ItemCollectableData);
 }
 
 void UItemManagerComponent::CollectItem()
 {
+    RecordTraceOp(EItemTraceOp::TO_CollectItem);
+    TGuardValue<int32> TraceGuard(TraceCallDepth, TraceCallDepth + 1);
+
     if(IsValid(CurrentItemCollectable) && AddItem(CurrentItemCollectable->GetItem()) == 0)
     {
         Items[Items.Num() - 1].ItemCollectableData = SetItemCollectableData(CurrentItemCollectable);
 
+        // ammo, durability... of this instance, picked up with it
+        Items[Items.Num() - 1].InstanceState = CurrentItemCollectable->GetInstanceState();
+
         // Remove ItemCollectable from ItemsCollectables
         ItemsCollectable.Remove(CurrentItemCollectable);
 
         CurrentItemCollectable->Destroy();
         UE_LOG(ItemManager, Display, TEXT("Item has been collected"));
         OnItemCollectedDelegate.Broadcast();
+        BroadcastItemEvent(EItemManagerEvent::IE_Collected, Items.Num() - 1);
 
         // auto switch
         if(Items[Items.Num() - 1].Item.GetDefaultObject()->EquipWhenPickedUp())
@@ -101,6 +208,7 @@ void UItemManagerComponent::CollectItem()
     {
         UE_LOG(ItemManager, Warning, TEXT("Can't collect item"));
         CannotCollectItemDelegate.Broadcast();
+        BroadcastItemEvent(EItemManagerEvent::IE_CannotCollect, INDEX_NONE, 0, CurrentItemCollectable);
     }
 }
 
@@ -110,7 +218,16 @@ void UItemManagerComponent::OnPickableBeginOverlap(AItemCollectable* ItemCollect
     if(CurrentItemCollectable == nullptr && IsValid(ItemCollectable))
     {
         CurrentItemCollectable = ItemCollectable;
+
+        // spawned ahead within the scheduler budget, collecting it will only take it from the pool
+        const AItemParent* ItemDefaults = ItemCollectable->GetItem() ? ItemCollectable->GetItem().GetDefaultObject() : nullptr;
+        if (ItemDefaults && ItemDefaults->EquipWhenPickedUp() && !bIsVirtual && CachedSubsystem.IsValid())
+        {
+            CachedSubsystem->PrewarmItemActors(ItemCollectable->GetItem(), 1);
+        }
+
         OnBeginOverlapDelegate.Broadcast(ItemCollectable);
+        BroadcastItemEvent(EItemManagerEvent::IE_BeginOverlap, INDEX_NONE, 0, ItemCollectable);
     }
     
 }
@@ -135,25 +252,11 @@ void UItemManagerComponent::OnPickableEndOverlap(AItemCollectable* ItemCollectab
     {
         CurrentItemCollectable = nullptr;
         OnEndOverlapDelegate.Broadcast(ItemCollectable);
+        BroadcastItemEvent(EItemManagerEvent::IE_EndOverlap, INDEX_NONE, 0, ItemCollectable);
     }
 
 }
 
-AItemParent* UItemManagerComponent::GetItemInstance(TSubclassOf<AItemParent> Item)
-{
-    if (Item)
-    {
-        UClass* ItemClass = Item.Get();
-
-        if (ItemClass)
-        {
-            return NewObject<AItemParent>(this, ItemClass);
-        }
-    }
-
-    return nullptr;
-}
-
 void UItemManagerComponent::PickupItem(AItemParent* item)
 {
     
@@ -168,10 +271,7 @@ void UItemManagerComponent::SpawnItemLambda(float delay)
     }
     else
     {
-        GetWorld()->GetTimerManager().SetTimer(SpawnItemTimerHandle, [this]()
-        {
-            SpawnItem();
-        }, delay, false);
+        SetItemTimer(SpawnItemTimerHandle, EItemTimerType::IT_SpawnItem, delay);
     }
     
 
@@ -182,17 +282,31 @@ void UItemManagerComponent::SpawnItem()
 
     FString FriendlyName = "";
 
-    if(Items.IsValidIndex(CurrentItemIndex))
+    if(Items.IsValidIndex(InventoryCore.GetCurrentIndex()))
     {
-        FriendlyName = Items[CurrentItemIndex].ItemInfos.FriendlyName;
+        FriendlyName = Items[InventoryCore.GetCurrentIndex()].GetItemInfos().FriendlyName;
     }
   
 
-    if (IsValid(GetOwner()) && Items.IsValidIndex(CurrentItemIndex) && !Items[CurrentItemIndex].Actor) // if the actor does not exist in world, spawn it.
+    if (bIsVirtual)
+    {
+        // a virtual manager only switches its data, the actor is spawned when leaving the virtual mode
+    }
+    else if (IsEmptyItem(InventoryCore.GetCurrentIndex()))
     {
-        Items[CurrentItemIndex].Actor = GetWorld()->SpawnActor<AItemParent>(Items[CurrentItemIndex].Item, Items[CurrentItemIndex].ItemInfos.SpawnRelativeTransform);
+        // empty hands, nothing to spawn nor attach
+    }
+    else if (IsValid(GetOwner()) && Items.IsValidIndex(InventoryCore.GetCurrentIndex()) && !Items[InventoryCore.GetCurrentIndex()].Actor) // if the actor does not exist in world, spawn it.
+    {
+        Items[InventoryCore.GetCurrentIndex()].Actor = SpawnSlotActor(InventoryCore.GetCurrentIndex());
+
+        if (IsResidencyEnabled())
+        {
+            ResidencyStats.Misses++;
+            INC_DWORD_STAT(STAT_ItemResidencyMisses);
+        }
 
-        if (IsValid(Items[CurrentItemIndex].Actor))    
+        if (IsValid(Items[InventoryCore.GetCurrentIndex()].Actor))    
         {
             UE_LOG(ItemManager, Display, TEXT("The Item (%s) successfully spawned"), *FriendlyName);
         }
@@ -205,6 +319,11 @@ void UItemManagerComponent::SpawnItem()
     else
     {
         UE_LOG(ItemManager, Display, TEXT("The Item (%s) alreay exist !"), *FriendlyName);
+
+        if (Items.IsValidIndex(InventoryCore.GetCurrentIndex()) && IsValid(Items[InventoryCore.GetCurrentIndex()].Actor))
+        {
+            ActivateResidentItem(Items[InventoryCore.GetCurrentIndex()].Actor);
+        }
     }
 
     if (!IsValid(CharacterMesh))
@@ -212,19 +331,49 @@ void UItemManagerComponent::SpawnItem()
         CharacterMesh = GetOwner()->FindComponentByClass<USkeletalMeshComponent>();
     }
 
-    if(CharacterMesh && Items[CurrentItemIndex].Actor)
+    if (Items.IsValidIndex(InventoryCore.GetCurrentIndex()) && IsValid(Items[InventoryCore.GetCurrentIndex()].Actor))
     {
-        Items[CurrentItemIndex].Actor->AttachToComponent(CharacterMesh, EnumAttachmentRulesToStuct(Items[CurrentItemIndex].ItemInfos.ItemAttachSocket.AttachementRules), Items[CurrentItemIndex].ItemInfos.ItemAttachSocket.ItemSocket);
+        // holstered or resident actors wake up in the state they were before
+        Items[InventoryCore.GetCurrentIndex()].Actor->ExitHolsteredDormancy();
     }
 
-    ItemState = EItemState::IS_Idle;
-    OnItemSpawnedDelegate.Broadcast(Items[CurrentItemIndex]);
+    if(CharacterMesh && Items.IsValidIndex(InventoryCore.GetCurrentIndex()) && Items[InventoryCore.GetCurrentIndex()].Actor)
+    {
+        Items[InventoryCore.GetCurrentIndex()].Actor->AttachToComponent(CharacterMesh, EnumAttachmentRulesToStuct(Items[InventoryCore.GetCurrentIndex()].GetItemInfos().ItemAttachSocket.AttachementRules), Items[InventoryCore.GetCurrentIndex()].GetItemInfos().ItemAttachSocket.ItemSocket);
+    }
+
+    InventoryCore.MarkSpawned();
+    RecordItemChange(EItemChangeType::IC_StateChanged, InventoryCore.GetCurrentIndex());
+    OnItemSpawnedDelegate.Broadcast(Items[InventoryCore.GetCurrentIndex()]);
+    BroadcastItemEvent(EItemManagerEvent::IE_Spawned, InventoryCore.GetCurrentIndex());
+}
+
+AItemParent* UItemManagerComponent::SpawnSlotActor(int ItemIndex)
+{
+    // a pooled actor of the same class is reused when there is one
+    return CachedSubsystem.IsValid()
+        ? CachedSubsystem->SpawnItemActor(Items[ItemIndex].Item, Items[ItemIndex].GetItemInfos().SpawnRelativeTransform)
+        : GetWorld()->SpawnActor<AItemParent>(Items[ItemIndex].Item, Items[ItemIndex].GetItemInfos().SpawnRelativeTransform);
 }
 
-void UItemManagerComponent::DestroyItemLambda(float delay)
+void UItemManagerComponent::HolsterItemActor(int ItemIndex)
 {
-    int OldItemIndex = CurrentItemIndex;
+    if(!IsValid(CharacterMesh))
+    {
+        CharacterMesh = GetOwner()->FindComponentByClass<USkeletalMeshComponent>();
+    }
+
+    if(CharacterMesh)
+    {
+        Items[ItemIndex].Actor->AttachToComponent(CharacterMesh, EnumAttachmentRulesToStuct(Items[ItemIndex].GetItemInfos().ItemDetachSocket.AttachementRules), Items[ItemIndex].GetItemInfos().ItemDetachSocket.ItemSocket);
+    }
 
+    // holstered actors stay visible but stop ticking, skinning and colliding
+    Items[ItemIndex].Actor->EnterHolsteredDormancy();
+}
+
+void UItemManagerComponent::DestroyItemLambda(float delay, int OldItemIndex)
+{
     // avoid a non called lambda
     if(delay <= 0.0f)
     {
@@ -232,10 +381,8 @@ void UItemManagerComponent::DestroyItemLambda(float delay)
     }
     else
     {
-        GetWorld()->GetTimerManager().SetTimer(DestroyItemTimerHandle, [this, OldItemIndex]()
-        {
-            DestroyItem(OldItemIndex);
-        }, delay, false);
+        PendingDestroyItemIndex = OldItemIndex;
+        SetItemTimer(DestroyItemTimerHandle, EItemTimerType::IT_DestroyItem, delay, OldItemIndex);
     }
 
 
@@ -243,290 +390,1632 @@ void UItemManagerComponent::DestroyItemLambda(float delay)
 
 void UItemManagerComponent::DestroyItem(int OldItemIndex)
 {
-    if (IsValid(Items[OldItemIndex].Actor))
+    if (IsEmptyItem(OldItemIndex) && !Items[OldItemIndex].Actor)
     {
+        // reported as a despawn, like any item despawning when switched
+        RecordItemChange(EItemChangeType::IC_StateChanged, OldItemIndex);
+        OnItemDespawnedDelegate.Broadcast(Items[OldItemIndex]);
+        BroadcastItemEvent(EItemManagerEvent::IE_Despawned, OldItemIndex);
+    }
+    else if (Items.IsValidIndex(OldItemIndex) && IsValid(Items[OldItemIndex].Actor))
+    {
+        RecordItemChange(EItemChangeType::IC_StateChanged, OldItemIndex);
+
         if(Items[OldItemIndex].Actor->IsItemDespawnWhenSwitched())
         {
             OnItemDespawnedDelegate.Broadcast(Items[OldItemIndex]);
+            BroadcastItemEvent(EItemManagerEvent::IE_Despawned, OldItemIndex);
+
+            if (IsResidencyEnabled())
+            {
+                // the actor is kept hidden and dormant, switching back to it will be instant
+                MakeItemResident(OldItemIndex);
+                return;
+            }
             
             FString const ItemName = Items[OldItemIndex].Actor->GetItemInfos().FriendlyName;
-            Items[OldItemIndex].Actor->Destroy();
+            DespawnItemActor(Items[OldItemIndex].Actor);
             Items[OldItemIndex].Actor = nullptr;
 
             UE_LOG(ItemManager, Display, TEXT("Item (%s) has been destroyed"), *ItemName)
         }
         else
         {
-            if(!IsValid(CharacterMesh))
-            {
-                CharacterMesh = GetOwner()->FindComponentByClass<USkeletalMeshComponent>();
-            }
-            
-            if(CharacterMesh)
+            HolsterItemActor(OldItemIndex);
+
+            if (IsResidencyEnabled())
             {
-                Items[OldItemIndex].Actor->AttachToComponent(CharacterMesh, EnumAttachmentRulesToStuct(Items[OldItemIndex].ItemInfos.ItemDetachSocket.AttachementRules), Items[OldItemIndex].ItemInfos.ItemDetachSocket.ItemSocket);
+                MakeItemResident(OldItemIndex);
             }
         }
 
     }
-    else
+    else if (bIsVirtual)
     {
-        UE_LOG(ItemManager, Warning, TEXT("Failed to destroy item"));
-    }
-}
-
-void UItemManagerComponent::ActivateSwitching(int Delay)
-{
-    FTimerHandle TimerHandle;
-    int OldItemIndex = CurrentItemIndex;
+        // switched out while virtual, it is holstered when the manager is materialized
+        const AItemParent* ItemDefaults = Items.IsValidIndex(OldItemIndex) && Items[OldItemIndex].Item ? Items[OldItemIndex].Item.GetDefaultObject() : nullptr;
 
-    // avoid a non called lambda
-    if (Delay <= 0.0f)
-    {
-        bIsSwitchingItem = false;
+        if (ItemDefaults && !ItemDefaults->IsItemDespawnWhenSwitched())
+        {
+            VirtualHolsteredSlotIds.Add(Items[OldItemIndex].SlotId);
+        }
     }
     else
     {
-        GetWorld()->GetTimerManager().SetTimer(TimerHandle, [this, TimerHandle, OldItemIndex]()
-        {
-            bIsSwitchingItem = false;
-        }, Delay, false);
+        UE_LOG(ItemManager, Warning, TEXT("Failed to destroy item"));
     }
 }
 
-bool UItemManagerComponent::IsCurrentItemValid()
-{
-    return CurrentItemIndex >= 0 && CurrentItemIndex < Items.Num() && Items[CurrentItemIndex].Actor != nullptr;
-}
-
-UItemManagerComponent::UItemManagerComponent()
+bool UItemManagerComponent::IsResidencyEnabled() const
 {
-    PrimaryComponentTick.bCanEverTick = true;
+    return MaxResidentItems.GetValue() > 0 || ResidentMemoryBudgetKB.GetValue() > 0;
 }
 
-void UItemManagerComponent::SwitchNextItem()
+void UItemManagerComponent::MakeItemResident(int ItemIndex)
 {
-    AItemParent* ItemInstance;
-    int NextItemIndex = CurrentItemIndex;
+    AItemParent* ItemActor = Items[ItemIndex].Actor;
 
-    if (NextItemIndex < 0 || NextItemIndex >= Items.Num()) { OnFailedtoSwitchItem.Broadcast(1); return; }
+    RemoveResidentItem(ItemActor);
 
-    int ItemCount = 0;
-    do
+    // non despawning items stay visible on their detach socket, already dormant
+    if (ItemActor->IsItemDespawnWhenSwitched())
     {
-        NextItemIndex++;
-
-        if (bLoopSwitching && NextItemIndex >= Items.Num())
-        {
-            NextItemIndex = 0;
-        }
+        ItemActor->SetActorHiddenInGame(true);
+        ItemActor->EnterHolsteredDormancy(true);
+    }
 
-        ItemInstance = GetItemInstance(Items[NextItemIndex].Item);
+    FItemResidentActor& ResidentActor = ResidentItems.AddDefaulted_GetRef();
+    ResidentActor.Actor = ItemActor;
+    // the actor with its components and the meshes they use
+    ResidentActor.ResourceSize = ItemManagerMemReport::GetActorResourceSize(ItemActor, EResourceSizeMode::EstimatedTotal);
 
-        if (!ItemInstance) { return;  }
+    EnforceResidencyBudget();
+}
 
-        ItemCount++;
-    } while(NextItemIndex < Items.Num() - 1 && ItemCount < Items.Num() && !ItemInstance->CanBeSwitched());
+void UItemManagerComponent::ActivateResidentItem(AItemParent* ItemActor)
+{
+    int32 const ResidentIndex = ResidentItems.IndexOfByPredicate([ItemActor](const FItemResidentActor& ResidentActor)
+    {
+        return ResidentActor.Actor == ItemActor;
+    });
 
-    if(ItemCount == Items.Num() && ItemState != EItemState::IS_None)
+    if (ResidentIndex == INDEX_NONE)
     {
-        UE_LOG(ItemManager, Display, TEXT("No item to switch on"))
-        OnFailedtoSwitchItem.Broadcast(2);
         return;
     }
 
-	SwitchItem(NextItemIndex);
+    ResidentItems.RemoveAt(ResidentIndex);
+    ResidencyStats.Hits++;
+    INC_DWORD_STAT(STAT_ItemResidencyHits);
+
+    // the dormancy is left by SpawnItem
+    ItemActor->SetActorHiddenInGame(false);
 }
 
-void UItemManagerComponent::SwitchPreviousItem()
+void UItemManagerComponent::RemoveResidentItem(AItemParent* ItemActor)
+{
+    ResidentItems.RemoveAll([ItemActor](const FItemResidentActor& ResidentActor)
+    {
+        return ResidentActor.Actor == ItemActor;
+    });
+}
+
+void UItemManagerComponent::EnforceResidencyBudget()
 {
-    AItemParent* ItemInstance;
-    int PreviousItemIndex = CurrentItemIndex;
+    int32 const MaxItems = MaxResidentItems.GetValue();
+    int64 const MemoryBudget = static_cast<int64>(ResidentMemoryBudgetKB.GetValue()) * 1024;
+    int64 ResidentMemory = 0;
 
-    if (Items.Num() <= 0 || PreviousItemIndex < 0) { OnFailedtoSwitchItem.Broadcast(1); return; }
+    for (const FItemResidentActor& ResidentActor : ResidentItems)
+    {
+        ResidentMemory += ResidentActor.ResourceSize;
+    }
 
-    int ItemCount = 0;
-    do
+    while (ResidentItems.Num() > 0 && ((MaxItems > 0 && ResidentItems.Num() > MaxItems) || (MemoryBudget > 0 && ResidentMemory > MemoryBudget)))
     {
-        PreviousItemIndex--;
+        // least recently used first
+        AItemParent* const EvictedActor = ResidentItems[0].Actor.Get();
+        ResidentMemory -= ResidentItems[0].ResourceSize;
+        ResidentItems.RemoveAt(0);
+
+        // an actor destroyed elsewhere has already left its slot
+        int32 const ItemIndex = EvictedActor ? Items.IndexOfByPredicate([EvictedActor](const FItemObject& Item)
+        {
+            return Item.Actor == EvictedActor;
+        }) : INDEX_NONE;
 
-        if (bLoopSwitching && PreviousItemIndex < 0)
+        if (ItemIndex != INDEX_NONE)
         {
-            PreviousItemIndex = Items.Num() - 1;
+            // despawning items already notified when switched
+            if (IsValid(EvictedActor) && !EvictedActor->IsItemDespawnWhenSwitched())
+            {
+                OnItemDespawnedDelegate.Broadcast(Items[ItemIndex]);
+                BroadcastItemEvent(EItemManagerEvent::IE_Despawned, ItemIndex);
+            }
+
+            Items[ItemIndex].Actor = nullptr;
+            RecordItemChange(EItemChangeType::IC_StateChanged, ItemIndex);
         }
 
-        ItemInstance = GetItemInstance(Items[PreviousItemIndex].Item);
+        DespawnItemActor(EvictedActor);
 
-        if (!ItemInstance) { return; }
+        ResidencyStats.Evictions++;
+        INC_DWORD_STAT(STAT_ItemResidencyEvictions);
+    }
+}
 
-        ItemCount++;
-    } while (PreviousItemIndex >= 0 && ItemCount < Items.Num() && !ItemInstance->CanBeSwitched());
+FItemResidencyStats UItemManagerComponent::GetResidencyStats() const
+{
+    FItemResidencyStats Stats = ResidencyStats;
+    int64 ResidentMemory = 0;
 
-    if (ItemCount == Items.Num() && ItemState != EItemState::IS_None)
+    for (const FItemResidentActor& ResidentActor : ResidentItems)
     {
-        UE_LOG(ItemManager, Display, TEXT("No item to switch on"))
-        OnFailedtoSwitchItem.Broadcast(2);
-        return;
+        ResidentMemory += ResidentActor.ResourceSize;
     }
 
+    Stats.ResidentItems = ResidentItems.Num();
+    Stats.ResidentMemoryKB = static_cast<int32>(ResidentMemory / 1024);
+    Stats.HitRate = Stats.Hits + Stats.Misses > 0 ? static_cast<float>(Stats.Hits) / (Stats.Hits + Stats.Misses) : 0.f;
 
-	SwitchItem(PreviousItemIndex);
+    return Stats;
 }
 
-void UItemManagerComponent::SwitchIndexItem(int32 Index)
+void UItemManagerComponent::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
 {
-    SwitchItem(Index);
+    Super::GetResourceSizeEx(CumulativeResourceSize);
+
+    CumulativeResourceSize.AddDedicatedSystemMemoryBytes(GetInventoryAllocatedSize());
 }
 
-void UItemManagerComponent::DropItem() 
+int64 UItemManagerComponent::GetInventoryAllocatedSize() const
 {
-    int OldItemIndex = CurrentItemIndex;
-    if(!bIsSwitchingItem && CurrentItemIndex >= 0 && CurrentItemIndex < Items.Num() && IsValid(Items[CurrentItemIndex].Actor) && Items[CurrentItemIndex].ItemInfos.bIsDropable)
+    int64 AllocatedSize = Items.GetAllocatedSize() + ItemsCollectable.GetAllocatedSize() + ResidentItems.GetAllocatedSize()
+        + ItemTagIndex.GetAllocatedSize() + DroppableItemIndex.GetAllocatedSize() + ItemNameIndex.GetAllocatedSize() + ChangeJournal.GetAllocatedSize() + InventoryCore.GetAllocatedSize();
+
+    for (const TPair<FGameplayTag, TBitArray<>>& TagIndex : ItemTagIndex)
     {
-        UE_LOG(ItemManager, Display, TEXT("Removing Item(%s) at %d"), *Items[CurrentItemIndex].ItemInfos.FriendlyName, CurrentItemIndex)
+        AllocatedSize += TagIndex.Value.GetAllocatedSize();
+    }
 
-        if(Items[CurrentItemIndex].Actor)
-        {
-            Items[CurrentItemIndex].Actor->Destroy();
-        }
-        
-        CurrentItemIndex = 0;
-        SpawnItem();
+    for (const FItemNameIndexEntry& NameIndexEntry : ItemNameIndex)
+    {
+        AllocatedSize += NameIndexEntry.LowerName.GetAllocatedSize();
+    }
 
-        FTransform Transform;
-        if (!IsValid(CharacterMesh))
+    for (const FItemObject& ItemObject : Items)
+    {
+        if (const UScriptStruct* InstanceStateStruct = ItemObject.InstanceState.GetScriptStruct())
         {
-             CharacterMesh = GetOwner()->FindComponentByClass<USkeletalMeshComponent>();
+            AllocatedSize += InstanceStateStruct->GetStructureSize();
         }
+    }
 
-        Transform.SetLocation(GetOwner()->GetActorLocation());
+    // the published snapshot, older ones are owned by their readers
+    if (InventorySnapshot.IsValid())
+    {
+        AllocatedSize += sizeof(FItemInventorySnapshot) + InventorySnapshot->Slots.GetAllocatedSize();
+    }
 
-        if(CharacterMesh)
-        {
-            if(CharacterMesh->DoesSocketExist(Items[OldItemIndex].ItemInfos.ItemAttachSocket.ItemSocket))
-            {
-                Transform.SetLocation(CharacterMesh->GetSocketLocation(Items[OldItemIndex].ItemInfos.ItemAttachSocket.ItemSocket));
-            }
-            
-        }
+    return AllocatedSize;
+}
 
-        AItemCollectable* ItemCollectable = GetWorld()->SpawnActorDeferred<AItemCollectable>(AItemCollectable::StaticClass(), Transform);
-        ItemCollectable->Init(Items[OldItemIndex].ItemCollectableData);
-        ItemCollectable->FinishSpawning(Transform);
+void UItemManagerComponent::GetItemMemoryRecords(TArray<FItemMemoryRecord>& OutRecords) const
+{
+    FString const ManagerName = GetNameSafe(GetOwner());
 
-        // Add ItemCollectable to ItemsCollectables
-        ItemsCollectable.Add(ItemCollectable);
+    for (const FItemObject& ItemObject : Items)
+    {
+        FItemMemoryRecord& Record = OutRecords.AddDefaulted_GetRef();
+        Record.Manager = ManagerName;
+        Record.ItemClass = ItemObject.Item.Get();
+
+        // configs are interned, see FItemConfigRegistry, the slot only pays for its record
+        Record.RecordBytes = sizeof(FItemObject);
+
+        if (!IsValid(ItemObject.Actor))
+        {
+            Record.Representation = EItemRepresentation::IR_Virtual;
+            continue;
+        }
 
-        Items.RemoveAt(OldItemIndex);
+        bool const bIsResident = ResidentItems.ContainsByPredicate([&ItemObject](const FItemResidentActor& ResidentActor)
+        {
+            return ResidentActor.Actor == ItemObject.Actor;
+        });
 
-        ItemState = Items.Num() <= 0 ? EItemState::IS_None : ItemState;
+        Record.Representation = bIsResident ? EItemRepresentation::IR_Resident : EItemRepresentation::IR_Actor;
+        Record.ActorBytes = ItemManagerMemReport::GetActorResourceSize(ItemObject.Actor);
     }
 }
 
-void UItemManagerComponent::UseItem()
+void UItemManagerComponent::ActivateSwitching(int Delay)
 {
-    if(IsCurrentItemValid())
+    // avoid a non called lambda
+    if (Delay <= 0.0f)
     {
-        if(ItemState == EItemState::IS_Idle)
-        {
-            Items[CurrentItemIndex].Actor->UseItem(this);
-        }
-        else
-        {
-            UE_LOG(ItemManager, Warning, TEXT("Cannot use item"))
-        }
-        
+        InventoryCore.EndSwitching();
     }
     else
     {
-        UE_LOG(ItemManager, Warning, TEXT("The current item is invalid"))
+        SetItemTimer(SwitchingTimerHandle, EItemTimerType::IT_EndSwitching, Delay);
     }
 }
 
-int UItemManagerComponent::AddItem(TSubclassOf<AItemParent> Item)
+bool UItemManagerComponent::IsCurrentItemValid()
 {
-	if (!IsValid(Item)) 
-    { 
-        OnAddingItem.Broadcast(1);
-        return 1; 
-    }
-    if (ItemLimit > 0 && Items.Num() >= ItemLimit) 
+    return InventoryCore.GetCurrentIndex() >= 0 && InventoryCore.GetCurrentIndex() < Items.Num() && Items[InventoryCore.GetCurrentIndex()].Actor != nullptr;
+}
+
+FItemInfos UItemManagerComponent::GetItemObjectInfos(const FItemObject& ItemObject)
+{
+    if (ItemObject.ItemInfos.IsValid() || !ItemObject.Item)
     {
-        OnAddingItem.Broadcast(2);
-        return 2; 
+        return ItemObject.GetItemInfos();
     }
 
-    AItemParent* ItemInstance = Item.GetDefaultObject();
-    
-    FItemObject NewItem;
-    NewItem.Item = Item;
-    NewItem.Actor = nullptr;
-    NewItem.ItemInfos = ItemInstance->GetItemInfos();
+    return *FItemConfigRegistry::Get().GetItemInfos(ItemObject.Item);
+}
 
-    if(bAllowsDuplicates || !Items.Contains(NewItem))
-    {
-        Items.Add(NewItem);
-    }
-    else
+FItemCollectableData UItemManagerComponent::GetItemObjectCollectableData(const FItemObject& ItemObject)
+{
+    if (ItemObject.ItemCollectableData.IsValid() || !ItemObject.Item)
     {
-        OnAddingItem.Broadcast(3);
-        return 3;
+        return ItemObject.GetItemCollectableData();
     }
-    
-    ItemInstance = nullptr;
 
-    OnAddingItem.Broadcast(0);
-    return 0;
+    return *ItemObject.GetItemCollectableDataRef();
 }
 
-// Called when the game starts
-void UItemManagerComponent::BeginPlay()
+void UItemManagerComponent::SetItemObjectInfos(FItemObject& ItemObject, const FItemInfos& ItemInfos)
 {
-	Super::BeginPlay();
+    ItemObject.ItemInfos = FItemConfigRegistry::Get().Intern(ItemInfos);
+}
 
-    // create an 'empty' item. this item wont have any actor
-    TSubclassOf<AEmptyItem> EmptyItem;
+void UItemManagerComponent::SetItemObjectCollectableData(FItemObject& ItemObject, const FItemCollectableData& ItemCollectableData)
+{
+    ItemObject.ItemCollectableData = FItemConfigRegistry::Get().Intern(ItemCollectableData);
+}
 
-    if(bAddEmptyItemByDefault)
-    {
-        EmptyItem = AEmptyItem::StaticClass();
-        AddItem(EmptyItem);
-        SpawnItem();
-    }
+bool UItemManagerComponent::IsEmptyItem(int32 ItemIndex) const
+{
+    // subclasses of AEmptyItem may have visuals, only the built-in one is actorless
+    return Items.IsValidIndex(ItemIndex) && Items[ItemIndex].Item == AEmptyItem::StaticClass();
+}
 
-    // get all items collectables actor in the world
-    TArray<AActor*> FoundActors;
-    UGameplayStatics::GetAllActorsOfClass(GetWorld(), AItemCollectable::StaticClass(), FoundActors);
-    for (AActor* Actor : FoundActors)
-    {
-        AItemCollectable* ItemCollectable = Cast<AItemCollectable>(Actor);
+static_assert(static_cast<uint8>(EItemState::IS_None) == static_cast<uint8>(EItemSwitchPhase::SP_None)
+    && static_cast<uint8>(EItemState::IS_Switching) == static_cast<uint8>(EItemSwitchPhase::SP_Switching)
+    && static_cast<uint8>(EItemState::IS_Idle) == static_cast<uint8>(EItemSwitchPhase::SP_Idle), "EItemState mirrors EItemSwitchPhase");
 
-        if (ItemCollectable)
-        {
-            ItemsCollectable.Add(ItemCollectable);
-        }
-    }
+UItemManagerComponent::UItemManagerComponent()
+{
+    PrimaryComponentTick.bCanEverTick = true;
+
+    // only ticks while an item is held in use
+    PrimaryComponentTick.bStartWithTickEnabled = false;
+
+    InventorySnapshot = MakeShared<const FItemInventorySnapshot, ESPMode::ThreadSafe>();
 }
 
-void UItemManagerComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+void UItemManagerComponent::SwitchNextItem()
+{
+    RecordTraceOp(EItemTraceOp::TO_SwitchNextItem);
+    TGuardValue<int32> TraceGuard(TraceCallDepth, TraceCallDepth + 1);
+
+    SwitchToSelectedItem(InventoryCore.SelectNextItem(GetInventoryRules()));
+}
+
+void UItemManagerComponent::SwitchPreviousItem()
+{
+    RecordTraceOp(EItemTraceOp::TO_SwitchPreviousItem);
+    TGuardValue<int32> TraceGuard(TraceCallDepth, TraceCallDepth + 1);
+
+    SwitchToSelectedItem(InventoryCore.SelectPreviousItem(GetInventoryRules()));
+}
+
+void UItemManagerComponent::SwitchToSelectedItem(const FItemSwitchSelection& Selection)
 {
-    if(SpawnItemTimerHandle.IsValid())
+    if (Selection.Error != EItemSwitchError::SE_None)
     {
-        GetWorld()->GetTimerManager().ClearTimer(SpawnItemTimerHandle);
+        if (Selection.Error == EItemSwitchError::SE_SameItem)
+        {
+            UE_LOG(ItemManager, Display, TEXT("No item to switch on"))
+        }
+
+        OnFailedtoSwitchItem.Broadcast(static_cast<int>(Selection.Error));
+        BroadcastItemEvent(EItemManagerEvent::IE_FailedToSwitch, GetCurrentItemIndex(), static_cast<int32>(Selection.Error));
+        return;
     }
-    
-    if (DestroyItemTimerHandle.IsValid())
+
+    if (Selection.Index != INDEX_NONE)
     {
-        GetWorld()->GetTimerManager().ClearTimer(DestroyItemTimerHandle);
+        SwitchItem(Selection.Index);
     }
 }
 
-
+void UItemManagerComponent::SwitchIndexItem(int32 Index)
+{
+    RecordTraceOp(EItemTraceOp::TO_SwitchIndexItem, Index);
+    TGuardValue<int32> TraceGuard(TraceCallDepth, TraceCallDepth + 1);
+
+    SwitchItem(Index);
+}
+
+void UItemManagerComponent::DropItem() 
+{
+    RecordTraceOp(EItemTraceOp::TO_DropItem);
+    TGuardValue<int32> TraceGuard(TraceCallDepth, TraceCallDepth + 1);
+
+    int OldItemIndex = InventoryCore.GetCurrentIndex();
+    bool const bHasItemActor = Items.IsValidIndex(OldItemIndex) && (IsValid(Items[OldItemIndex].Actor) || bIsVirtual);
+
+    if(InventoryCore.CanDropCurrentItem(bHasItemActor))
+    {
+        UE_LOG(ItemManager, Display, TEXT("Removing Item(%s) at %d"), *Items[InventoryCore.GetCurrentIndex()].GetItemInfos().FriendlyName, InventoryCore.GetCurrentIndex())
+
+        FTransform const Transform = GetDropTransform(OldItemIndex);
+        TSharedRef<const FItemCollectableData> const ItemCollectableData = Items[OldItemIndex].GetItemCollectableDataRef();
+        FInstancedStruct const InstanceState = MoveTemp(Items[OldItemIndex].InstanceState);
+
+        DespawnItemActor(Items[OldItemIndex].Actor);
+        RemoveItemAt(OldItemIndex);
+
+        // back to the first item
+        if(InventoryCore.FinishRemoval() && Items.Num() > 0)
+        {
+            SpawnItem();
+        }
+
+        // the inventory is already up to date, the ItemCollectable will be spawned by the scheduler
+        SpawnItemCollectable(ItemCollectableData, Transform, InstanceState);
+    }
+}
+
+void UItemManagerComponent::DropAllItems()
+{
+    // the old item of a pending switch is put away now, a non droppable one would stay in hand otherwise
+    if (DestroyItemTimerHandle.IsValid())
+    {
+        ClearItemTimer(DestroyItemTimerHandle);
+        DestroyItem(PendingDestroyItemIndex);
+    }
+
+    // pending switch timers would work on shifted indices
+    ClearSwitchTimers();
+    InventoryCore.EndSwitching();
+
+    for (int ItemIndex = Items.Num() - 1; ItemIndex >= 0; ItemIndex--)
+    {
+        if (!Items[ItemIndex].GetItemInfos().bIsDropable)
+        {
+            continue;
+        }
+
+        UE_LOG(ItemManager, Display, TEXT("Removing Item(%s) at %d"), *Items[ItemIndex].GetItemInfos().FriendlyName, ItemIndex)
+
+        SpawnItemCollectable(Items[ItemIndex].GetItemCollectableDataRef(), GetDropTransform(ItemIndex), Items[ItemIndex].InstanceState);
+        DespawnItemActor(Items[ItemIndex].Actor);
+        RemoveItemAt(ItemIndex);
+    }
+
+    bool const bIsCurrentItemDropped = InventoryCore.FinishRemoval();
+
+    // a switch interrupted above never spawned its item
+    if ((bIsCurrentItemDropped || InventoryCore.GetPhase() == EItemSwitchPhase::SP_Switching) && Items.Num() > 0)
+    {
+        SpawnItem();
+    }
+}
+
+void UItemManagerComponent::BroadcastItemEvent(EItemManagerEvent Type, int32 ItemIndex, int32 Value, AItemCollectable* ItemCollectable)
+{
+    // most events have no native listener, do not even build them
+    if (!CachedSubsystem.IsValid() || !CachedSubsystem->GetEventBus().HasSubscribers(Type))
+    {
+        return;
+    }
+
+    FItemManagerEvent Event;
+    Event.Type = Type;
+    Event.Manager = this;
+    Event.Owner = GetOwner();
+    Event.ItemIndex = ItemIndex;
+    Event.Value = Value;
+    Event.ItemCollectable = ItemCollectable;
+    Event.Item = Items.IsValidIndex(ItemIndex) ? Items[ItemIndex].Item : (IsValid(ItemCollectable) ? ItemCollectable->GetItem() : nullptr);
+
+    CachedSubsystem->GetEventBus().Broadcast(Event);
+}
+
+void UItemManagerComponent::SetVirtual(bool bVirtual)
+{
+    if (bIsVirtual == bVirtual)
+    {
+        return;
+    }
+
+    bIsVirtual = bVirtual;
+    MarkInventorySnapshotDirty();
+
+    if (bIsVirtual)
+    {
+        INC_DWORD_STAT(STAT_ItemVirtualManagers);
+
+        // resident and holstered actors go away too, only the inventory data is kept
+        ResidentItems.Empty();
+
+        for (int ItemIndex = 0; ItemIndex < Items.Num(); ItemIndex++)
+        {
+            if (Items[ItemIndex].Actor)
+            {
+                // visible on their detach socket, they come back with the manager
+                if (ItemIndex != InventoryCore.GetCurrentIndex() && !Items[ItemIndex].Actor->IsItemDespawnWhenSwitched())
+                {
+                    VirtualHolsteredSlotIds.Add(Items[ItemIndex].SlotId);
+                }
+
+                DespawnItemActor(Items[ItemIndex].Actor);
+                Items[ItemIndex].Actor = nullptr;
+                RecordItemChange(EItemChangeType::IC_StateChanged, ItemIndex);
+            }
+        }
+
+        UE_LOG(ItemManager, Verbose, TEXT("Item manager of %s is now virtual"), *GetNameSafe(GetOwner()));
+    }
+    else
+    {
+        DEC_DWORD_STAT(STAT_ItemVirtualManagers);
+
+        // a pending switch spawns the new item itself
+        if (InventoryCore.GetPhase() != EItemSwitchPhase::SP_Switching && Items.IsValidIndex(InventoryCore.GetCurrentIndex()))
+        {
+            SpawnItem();
+        }
+
+        // holstered items go back on their detach socket, removed slots are skipped
+        for (int ItemIndex = 0; ItemIndex < Items.Num() && VirtualHolsteredSlotIds.Num() > 0; ItemIndex++)
+        {
+            if (VirtualHolsteredSlotIds.Remove(Items[ItemIndex].SlotId) <= 0 || ItemIndex == InventoryCore.GetCurrentIndex() || Items[ItemIndex].Actor)
+            {
+                continue;
+            }
+
+            Items[ItemIndex].Actor = SpawnSlotActor(ItemIndex);
+
+            if (IsValid(Items[ItemIndex].Actor))
+            {
+                HolsterItemActor(ItemIndex);
+                RecordItemChange(EItemChangeType::IC_StateChanged, ItemIndex);
+            }
+        }
+
+        VirtualHolsteredSlotIds.Reset();
+
+        UE_LOG(ItemManager, Verbose, TEXT("Item manager of %s is now materialized"), *GetNameSafe(GetOwner()));
+    }
+}
+
+bool UItemManagerComponent::IsOwnerSignificant() const
+{
+    AActor* Owner = GetOwner();
+
+    if (!IsValid(Owner))
+    {
+        return false;
+    }
+
+    const APawn* Pawn = Cast<APawn>(Owner);
+    if ((Pawn && Pawn->IsLocallyControlled()) || Owner->WasRecentlyRendered(0.2f))
+    {
+        return true;
+    }
+
+    const FVector OwnerLocation = Owner->GetActorLocation();
+    const float MaxDistanceSquared = FMath::Square(VirtualizationDistance);
+
+    // a server also keeps the items of owners replicated to a player
+    const ENetMode NetMode = GetNetMode();
+    const bool bCheckNetRelevancy = bUseNetRelevancy && (NetMode == NM_DedicatedServer || NetMode == NM_ListenServer);
+
+    for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+    {
+        const APlayerController* PlayerController = Iterator->Get();
+
+        if (PlayerController)
+        {
+            FVector ViewLocation;
+            FRotator ViewRotation;
+            PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+            if (FVector::DistSquared(OwnerLocation, ViewLocation) <= MaxDistanceSquared)
+            {
+                return true;
+            }
+
+            if (bCheckNetRelevancy && Owner->IsNetRelevantFor(PlayerController, PlayerController->GetViewTarget(), ViewLocation))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void UItemManagerComponent::UpdateSignificance()
+{
+    SCOPE_CYCLE_COUNTER(STAT_ItemSignificanceUpdate);
+
+    SetVirtual(!IsOwnerSignificant());
+}
+
+FTransform UItemManagerComponent::GetDropTransform(int ItemIndex)
+{
+    FTransform Transform;
+    if (!IsValid(CharacterMesh))
+    {
+         CharacterMesh = GetOwner()->FindComponentByClass<USkeletalMeshComponent>();
+    }
+
+    Transform.SetLocation(GetOwner()->GetActorLocation());
+
+    if(CharacterMesh)
+    {
+        if(CharacterMesh->DoesSocketExist(Items[ItemIndex].GetItemInfos().ItemAttachSocket.ItemSocket))
+        {
+            Transform.SetLocation(CharacterMesh->GetSocketLocation(Items[ItemIndex].GetItemInfos().ItemAttachSocket.ItemSocket));
+        }
+        
+    }
+
+    return Transform;
+}
+
+void UItemManagerComponent::SpawnItemCollectable(const TSharedRef<const FItemCollectableData>& ItemCollectableData, const FTransform& Transform, const FInstancedStruct& InstanceState)
+{
+    UItemManagerSubsystem* ItemManagerSubsystem = GetWorld()->GetSubsystem<UItemManagerSubsystem>();
+
+    if (ItemManagerSubsystem)
+    {
+        ItemManagerSubsystem->EnqueueSpawnCollectable(ItemCollectableData, Transform, this, InstanceState);
+        return;
+    }
+
+    AItemCollectable* ItemCollectable = GetWorld()->SpawnActorDeferred<AItemCollectable>(AItemCollectable::StaticClass(), Transform);
+    ItemCollectable->Init(*ItemCollectableData);
+    ItemCollectable->SetInstanceState(InstanceState);
+    ItemCollectable->FinishSpawning(Transform);
+
+    RegisterItemCollectable(ItemCollectable);
+}
+
+void UItemManagerComponent::DespawnItemActor(AItemParent* ItemActor)
+{
+    RemoveResidentItem(ItemActor);
+
+    if (!IsValid(ItemActor))
+    {
+        return;
+    }
+
+    UItemManagerSubsystem* ItemManagerSubsystem = GetWorld()->GetSubsystem<UItemManagerSubsystem>();
+
+    if (ItemManagerSubsystem)
+    {
+        // pooled for the next spawn of its class, or destroyed by the scheduler
+        ItemManagerSubsystem->ReleaseItemActor(ItemActor);
+    }
+    else
+    {
+        ItemActor->Destroy();
+    }
+}
+
+void UItemManagerComponent::RegisterItemCollectable(AItemCollectable* ItemCollectable)
+{
+    if (IsValid(ItemCollectable))
+    {
+        // Add ItemCollectable to ItemsCollectables
+        ItemsCollectable.Add(ItemCollectable);
+    }
+}
+
+void UItemManagerComponent::UnregisterItemCollectable(AItemCollectable* ItemCollectable)
+{
+    ItemsCollectable.Remove(ItemCollectable);
+
+    if (CurrentItemCollectable == ItemCollectable)
+    {
+        OnPickableEndOverlap(ItemCollectable);
+    }
+}
+
+void UItemManagerComponent::UseItem()
+{
+    RecordTraceOp(EItemTraceOp::TO_UseItem);
+    TGuardValue<int32> TraceGuard(TraceCallDepth, TraceCallDepth + 1);
+
+    if(IsCurrentItemValid())
+    {
+        if(InventoryCore.GetPhase() == EItemSwitchPhase::SP_Idle)
+        {
+            Items[InventoryCore.GetCurrentIndex()].Actor->UseItem(this);
+        }
+        else
+        {
+            UE_LOG(ItemManager, Warning, TEXT("Cannot use item"))
+        }
+        
+    }
+    else if (IsEmptyItem(InventoryCore.GetCurrentIndex()))
+    {
+        UE_LOG(ItemManager, Verbose, TEXT("Nothing to use with empty hands"))
+    }
+    else
+    {
+        UE_LOG(ItemManager, Warning, TEXT("The current item is invalid"))
+    }
+}
+
+void UItemManagerComponent::BeginUseItem()
+{
+    if (bIsUsingItem)
+    {
+        return;
+    }
+
+    if (!IsCurrentItemValid() || InventoryCore.GetPhase() != EItemSwitchPhase::SP_Idle)
+    {
+        UE_LOG(ItemManager, Verbose, TEXT("Cannot use item"));
+        return;
+    }
+
+    AItemParent* ItemActor = Items[InventoryCore.GetCurrentIndex()].Actor;
+
+    if (!ItemActor->CanBeUsed())
+    {
+        // only the Cannot Use Item event of the item is called, no use is counted nor repeated
+        ItemActor->ProcessUses(1);
+        EndUseItem();
+        return;
+    }
+
+    ItemActor->ProcessUses(1);
+    DispatchUses(1);
+
+    if (ItemActor->GetUseRate() > 0.f)
+    {
+        bIsUsingItem = true;
+        UseTimeAccumulator = 0.f;
+        SetComponentTickEnabled(true);
+    }
+}
+
+void UItemManagerComponent::EndUseItem()
+{
+    if (!bIsUsingItem)
+    {
+        return;
+    }
+
+    bIsUsingItem = false;
+    SetComponentTickEnabled(false);
+}
+
+void UItemManagerComponent::UpdateHeldUse(float DeltaTime)
+{
+    SCOPE_CYCLE_COUNTER(STAT_ItemHeldUse);
+
+    AItemParent* ItemActor = GetCurrentItemActor();
+
+    if (!IsValid(ItemActor) || InventoryCore.GetPhase() != EItemSwitchPhase::SP_Idle || ItemActor->GetUseRate() <= 0.f)
+    {
+        EndUseItem();
+        return;
+    }
+
+    // uses due since the last tick, the remainder is kept so the rate does not depend on the frame rate
+    float const UseInterval = 1.f / ItemActor->GetUseRate();
+    UseTimeAccumulator += DeltaTime;
+
+    int32 const NumUses = FMath::FloorToInt32(UseTimeAccumulator / UseInterval);
+
+    if (NumUses <= 0)
+    {
+        return;
+    }
+
+    UseTimeAccumulator -= NumUses * UseInterval;
+
+    if (!ItemActor->CanBeUsed())
+    {
+        // the item cannot be used anymore (out of ammo...), tell it once and stop repeating
+        ItemActor->ProcessUses(1);
+        EndUseItem();
+        return;
+    }
+
+    ItemActor->ProcessUses(NumUses);
+    DispatchUses(NumUses);
+}
+
+void UItemManagerComponent::DispatchUses(int32 NumUses)
+{
+    INC_DWORD_STAT_BY(STAT_ItemUses, NumUses);
+
+    if (OnItemUses.IsBound())
+    {
+        OnItemUses.Broadcast(InventoryCore.GetCurrentIndex(), NumUses);
+    }
+
+    BroadcastItemEvent(EItemManagerEvent::IE_Used, InventoryCore.GetCurrentIndex(), NumUses);
+}
+
+int UItemManagerComponent::AddItem(TSubclassOf<AItemParent> Item)
+{
+    if (TraceRecorder && TraceCallDepth == 0)
+    {
+        TraceRecorder->RecordAddItem(Item);
+    }
+    TGuardValue<int32> TraceGuard(TraceCallDepth, TraceCallDepth + 1);
+
+    EItemAddError const AddError = InventoryCore.CanAddItem(GetInventoryRules(), IsValid(Item) ? Item.Get() : nullptr);
+
+    if (AddError != EItemAddError::AE_None)
+    {
+        OnAddingItem.Broadcast(static_cast<int>(AddError));
+        BroadcastItemEvent(EItemManagerEvent::IE_Added, INDEX_NONE, static_cast<int32>(AddError));
+        return static_cast<int>(AddError);
+    }
+
+    FItemObject NewItem;
+    NewItem.Item = Item;
+    NewItem.Actor = nullptr;
+    NewItem.ItemInfos = FItemConfigRegistry::Get().GetItemInfos(Item);
+    NewItem.ItemCollectableData = FItemConfigRegistry::Get().GetItemCollectableData(Item);
+
+    AddItemObject(NewItem);
+
+    OnAddingItem.Broadcast(0);
+    BroadcastItemEvent(EItemManagerEvent::IE_Added, Items.Num() - 1, 0);
+    return 0;
+}
+
+int32 UItemManagerComponent::AddLoot(UItemLootTable* LootTable, int32 Seed, FGameplayTagContainer ContextTags)
+{
+    if (!IsValid(LootTable))
+    {
+        return 0;
+    }
+
+    TArray<TSharedRef<const FItemCollectableData>> Loot;
+    LootTable->GenerateLoot(Seed, ContextTags, Loot);
+
+    int32 AddedItems = 0;
+
+    for (const TSharedRef<const FItemCollectableData>& ItemCollectableData : Loot)
+    {
+        if (AddItem(ItemCollectableData->Item) == 0)
+        {
+            Items.Last().ItemCollectableData = ItemCollectableData;
+            AddedItems++;
+        }
+    }
+
+    return AddedItems;
+}
+
+FItemBatchResult UItemManagerComponent::AddItems(const TArray<TSubclassOf<AItemParent>>& NewItems, bool bEquipFirstItem)
+{
+    TArray<FItemObject> NewItemObjects;
+    NewItemObjects.Reserve(NewItems.Num());
+
+    for (const TSubclassOf<AItemParent>& Item : NewItems)
+    {
+        FItemObject& NewItem = NewItemObjects.AddDefaulted_GetRef();
+        NewItem.Item = Item;
+        NewItem.Actor = nullptr;
+    }
+
+    return AddItemObjects(NewItemObjects, bEquipFirstItem);
+}
+
+FItemBatchResult UItemManagerComponent::AddItemObjects(const TArray<FItemObject>& NewItems, bool bEquipFirstItem)
+{
+    FItemBatchResult Result;
+
+    // validate the whole set before touching the inventory
+    TArray<const void*> ItemKeys;
+    ItemKeys.Reserve(NewItems.Num());
+
+    for (const FItemObject& NewItemObject : NewItems)
+    {
+        ItemKeys.Add(IsValid(NewItemObject.Item) ? NewItemObject.Item.Get() : nullptr);
+    }
+
+    Result.Error = static_cast<int32>(InventoryCore.CanAddItems(GetInventoryRules(), ItemKeys, Result.FailedEntry));
+
+    if (Result.Error != 0)
+    {
+        UE_LOG(ItemManager, Warning, TEXT("Cannot add items, error %d at entry %d"), Result.Error, Result.FailedEntry);
+        OnAddingItems.Broadcast(Result);
+        BroadcastItemEvent(EItemManagerEvent::IE_ItemsAdded, INDEX_NONE, Result.Error);
+        return Result;
+    }
+
+    Items.Reserve(Items.Num() + NewItems.Num());
+    Result.Slots.Reserve(NewItems.Num());
+
+    bool const bWasEmpty = Items.Num() <= 0;
+
+    for (const FItemObject& NewItemObject : NewItems)
+    {
+        if (TraceRecorder && TraceCallDepth == 0)
+        {
+            TraceRecorder->RecordAddItem(NewItemObject.Item);
+        }
+
+        // records coming from a container keep their collectable data
+        FItemObject NewItem = NewItemObject;
+        NewItem.Actor = nullptr;
+        if (!NewItem.ItemInfos.IsValid())
+        {
+            NewItem.ItemInfos = FItemConfigRegistry::Get().GetItemInfos(NewItem.Item);
+        }
+        if (!NewItem.ItemCollectableData.IsValid())
+        {
+            NewItem.ItemCollectableData = FItemConfigRegistry::Get().GetItemCollectableData(NewItem.Item);
+        }
+
+        int const ItemIndex = AddItemObject(NewItem);
+        Result.Slots.Add(GetItemHandle(ItemIndex));
+    }
+
+    UE_LOG(ItemManager, Display, TEXT("%d items added"), NewItems.Num());
+    OnAddingItems.Broadcast(Result);
+    BroadcastItemEvent(EItemManagerEvent::IE_ItemsAdded, INDEX_NONE, Result.Error);
+
+    if (bEquipFirstItem && Result.Slots.Num() > 0)
+    {
+        int const FirstItemIndex = Result.Slots[0].IndexHint;
+
+        if (bWasEmpty)
+        {
+            // nothing to switch from, spawn the first item only
+            InventoryCore.SetCurrentIndex(FirstItemIndex);
+            SpawnItem();
+        }
+        else
+        {
+            SwitchIndexItem(FirstItemIndex);
+        }
+    }
+
+    return Result;
+}
+
+FItemBatchResult UItemManagerComponent::RemoveItems(const TArray<FItemSlotHandle>& Slots)
+{
+    TArray<FItemObject> RemovedItems;
+    return RemoveItemObjects(Slots, RemovedItems);
+}
+
+FItemBatchResult UItemManagerComponent::RemoveItemObjects(const TArray<FItemSlotHandle>& Slots, TArray<FItemObject>& OutRemovedItems)
+{
+    FItemBatchResult Result;
+    OutRemovedItems.Reset();
+    TArray<int32> ItemIndices;
+    ItemIndices.Reserve(Slots.Num());
+
+    // pending switch timers would work on shifted indices
+    if (InventoryCore.IsSwitching())
+    {
+        Result.Error = 4;
+    }
+
+    for (int32 EntryIndex = 0; Result.Error == 0 && EntryIndex < Slots.Num(); EntryIndex++)
+    {
+        int32 const ItemIndex = GetItemIndexFromHandle(Slots[EntryIndex]);
+
+        if (ItemIndex == INDEX_NONE)
+        {
+            Result.Error = 1;
+            Result.FailedEntry = EntryIndex;
+        }
+        else
+        {
+            ItemIndices.AddUnique(ItemIndex);
+        }
+    }
+
+    if (Result.Error != 0)
+    {
+        UE_LOG(ItemManager, Warning, TEXT("Cannot remove items, error %d at entry %d"), Result.Error, Result.FailedEntry);
+        OnRemovingItems.Broadcast(Result);
+        BroadcastItemEvent(EItemManagerEvent::IE_ItemsRemoved, INDEX_NONE, Result.Error);
+        return Result;
+    }
+
+    // last first, so the remaining indices stay valid
+    ItemIndices.Sort(TGreater<int32>());
+
+    for (int32 const ItemIndex : ItemIndices)
+    {
+        Result.Slots.Add(GetItemHandle(ItemIndex));
+
+        DespawnItemActor(Items[ItemIndex].Actor);
+
+        FItemObject& RemovedItem = OutRemovedItems.Add_GetRef(Items[ItemIndex]);
+        RemovedItem.Actor = nullptr;
+        RemovedItem.SlotId = INDEX_NONE;
+
+        RemoveItemAt(ItemIndex);
+    }
+
+    if (InventoryCore.FinishRemoval() && Items.Num() > 0)
+    {
+        SpawnItem();
+    }
+
+    // removed last first above
+    Algo::Reverse(OutRemovedItems);
+    Algo::Reverse(Result.Slots);
+
+    UE_LOG(ItemManager, Display, TEXT("%d items removed"), ItemIndices.Num());
+    OnRemovingItems.Broadcast(Result);
+    BroadcastItemEvent(EItemManagerEvent::IE_ItemsRemoved, INDEX_NONE, Result.Error);
+
+    return Result;
+}
+
+void UItemManagerComponent::StartTraceRecording()
+{
+    TraceRecorder = MakeUnique<FItemManagerTraceRecorder>(GFrameCounter);
+}
+
+bool UItemManagerComponent::StopTraceRecording(const FString& FilePath)
+{
+    if (!TraceRecorder)
+    {
+        UE_LOG(ItemManager, Warning, TEXT("Trace is not recording"));
+        return false;
+    }
+
+    TUniquePtr<FItemManagerTraceRecorder> Recorder = MoveTemp(TraceRecorder);
+    FItemManagerTrace Trace = Recorder->GetTrace();
+
+    if (Trace.Events.Num() <= 0 || !Trace.SaveToFile(FilePath))
+    {
+        UE_LOG(ItemManager, Warning, TEXT("Cannot save trace to %s"), *FilePath);
+        return false;
+    }
+
+    return true;
+}
+
+void UItemManagerComponent::RecordTraceOp(EItemTraceOp Op, int32 Value)
+{
+    if (TraceRecorder && TraceCallDepth == 0)
+    {
+        TraceRecorder->Record(Op, Value);
+    }
+}
+
+int UItemManagerComponent::AddItemObject(FItemObject& NewItem)
+{
+    NewItem.SlotId = NextSlotId++;
+
+    int const ItemIndex = Items.Add(NewItem);
+    InventoryCore.AddSlot(MakeCoreSlot(NewItem));
+    IndexItem(ItemIndex);
+    RecordItemChange(EItemChangeType::IC_Added, ItemIndex);
+
+    return ItemIndex;
+}
+
+void UItemManagerComponent::RemoveItemAt(int ItemIndex)
+{
+    RecordItemChange(EItemChangeType::IC_Removed, ItemIndex);
+    UnindexItem(ItemIndex);
+    Items.RemoveAt(ItemIndex);
+
+    // the current index is moved by FinishRemoval, once every slot is removed
+    InventoryCore.RemoveSlot(ItemIndex);
+}
+
+FItemCoreSlot UItemManagerComponent::MakeCoreSlot(const FItemObject& ItemObject)
+{
+    // switch rules are class defaults, no need for an instance
+    const AItemParent* ItemDefaults = ItemObject.Item.GetDefaultObject();
+
+    FItemCoreSlot Slot;
+    Slot.ItemKey = ItemObject.Item.Get();
+    Slot.bCanBeSwitched = ItemDefaults && ItemDefaults->CanBeSwitched();
+    Slot.bIsDropable = ItemObject.GetItemInfos().bIsDropable;
+
+    // the built-in empty slot has no actor to wait for, only the delays of the other item of a switch are used
+    bool const bIsEmptySentinel = ItemObject.Item == AEmptyItem::StaticClass();
+    Slot.TimeBeforeSpawn = bIsEmptySentinel ? 0.f : ItemObject.GetItemInfos().TimeBeforeSpawn;
+    Slot.TimeBeforeDespawn = bIsEmptySentinel ? 0.f : ItemObject.GetItemInfos().TimeBeforeDespawn;
+    return Slot;
+}
+
+FItemInventoryRules UItemManagerComponent::GetInventoryRules() const
+{
+    FItemInventoryRules Rules;
+    Rules.ItemLimit = ItemLimit;
+    Rules.bAllowsDuplicates = bAllowsDuplicates;
+    Rules.bLoopSwitching = bLoopSwitching;
+    return Rules;
+}
+
+bool UItemManagerComponent::SwapItems(int32 FirstIndex, int32 SecondIndex)
+{
+    if (!Items.IsValidIndex(FirstIndex) || !Items.IsValidIndex(SecondIndex) || FirstIndex == SecondIndex)
+    {
+        UE_LOG(ItemManager, Warning, TEXT("Cannot swap items at %d and %d"), FirstIndex, SecondIndex);
+        return false;
+    }
+
+    // pending switch timers work on indices
+    if (InventoryCore.IsSwitching())
+    {
+        UE_LOG(ItemManager, Warning, TEXT("Item is switching, cannot swap items at the moment."));
+        return false;
+    }
+
+    Items.Swap(FirstIndex, SecondIndex);
+    InventoryCore.SwapSlots(FirstIndex, SecondIndex);
+
+    for (TPair<FGameplayTag, TBitArray<>>& TagBits : ItemTagIndex)
+    {
+        int32 const MaxIndex = FMath::Max(FirstIndex, SecondIndex);
+        if (TagBits.Value.Num() <= MaxIndex)
+        {
+            TagBits.Value.Add(false, MaxIndex + 1 - TagBits.Value.Num());
+        }
+
+        bool const FirstBit = TagBits.Value[FirstIndex];
+        TagBits.Value[FirstIndex] = TagBits.Value[SecondIndex];
+        TagBits.Value[SecondIndex] = FirstBit;
+    }
+
+    bool const FirstDroppable = DroppableItemIndex[FirstIndex];
+    DroppableItemIndex[FirstIndex] = DroppableItemIndex[SecondIndex];
+    DroppableItemIndex[SecondIndex] = FirstDroppable;
+
+    for (FItemNameIndexEntry& NameEntry : ItemNameIndex)
+    {
+        if (NameEntry.ItemIndex == FirstIndex)
+        {
+            NameEntry.ItemIndex = SecondIndex;
+        }
+        else if (NameEntry.ItemIndex == SecondIndex)
+        {
+            NameEntry.ItemIndex = FirstIndex;
+        }
+    }
+
+    RecordItemChange(EItemChangeType::IC_Moved, SecondIndex, FirstIndex);
+    RecordItemChange(EItemChangeType::IC_Moved, FirstIndex, SecondIndex);
+
+    return true;
+}
+
+void UItemManagerComponent::RecordItemChange(EItemChangeType ChangeType, int ItemIndex, int PreviousItemIndex)
+{
+    if (!Items.IsValidIndex(ItemIndex))
+    {
+        return;
+    }
+
+    InventoryVersion++;
+    MarkInventorySnapshotDirty();
+
+    FItemChange& Change = ChangeJournal.AddDefaulted_GetRef();
+    Change.Version = InventoryVersion;
+    Change.ChangeType = ChangeType;
+    Change.SlotId = Items[ItemIndex].SlotId;
+    Change.ItemIndex = ItemIndex;
+    Change.PreviousItemIndex = PreviousItemIndex;
+
+    // trimmed by chunks to keep the cost amortized
+    int32 const Capacity = FMath::Max(ChangeJournalCapacity, 1);
+    if (ChangeJournal.Num() >= 2 * Capacity)
+    {
+        ChangeJournal.RemoveAt(0, ChangeJournal.Num() - Capacity, EAllowShrinking::No);
+    }
+}
+
+bool UItemManagerComponent::GetChangesSince(int32 Version, TArray<FItemChange>& OutChanges) const
+{
+    OutChanges.Reset();
+
+    if (Version == InventoryVersion)
+    {
+        return true;
+    }
+
+    // unknown version or older than the journal
+    int32 const OldestVersion = ChangeJournal.Num() > 0 ? ChangeJournal[0].Version - 1 : InventoryVersion;
+    if (Version > InventoryVersion || Version < OldestVersion)
+    {
+        return false;
+    }
+
+    int32 const FirstChange = Algo::UpperBoundBy(ChangeJournal, Version, &FItemChange::Version);
+    OutChanges.Append(ChangeJournal.GetData() + FirstChange, ChangeJournal.Num() - FirstChange);
+
+    return true;
+}
+
+FItemInventorySnapshotPtr UItemManagerComponent::GetInventorySnapshot()
+{
+    // the game thread is the only writer, it never reads a stale snapshot
+    if (IsInGameThread() && bIsInventorySnapshotDirty)
+    {
+        PublishInventorySnapshot();
+    }
+
+    FReadScopeLock ReadLock(InventorySnapshotLock);
+    return InventorySnapshot;
+}
+
+void UItemManagerComponent::MarkInventorySnapshotDirty()
+{
+    if (bIsInventorySnapshotDirty)
+    {
+        return;
+    }
+
+    bIsInventorySnapshotDirty = true;
+
+    // many changes in a frame, one snapshot
+    if (CachedSubsystem.IsValid())
+    {
+        CachedSubsystem->RequestSnapshotPublish(this);
+    }
+}
+
+void UItemManagerComponent::PublishInventorySnapshot()
+{
+    check(IsInGameThread());
+    SCOPE_CYCLE_COUNTER(STAT_ItemSnapshotPublish);
+
+    bIsInventorySnapshotDirty = false;
+
+    TSharedRef<FItemInventorySnapshot, ESPMode::ThreadSafe> NewSnapshot = MakeShared<FItemInventorySnapshot, ESPMode::ThreadSafe>();
+    NewSnapshot->Version = InventoryVersion;
+    NewSnapshot->CurrentItemIndex = InventoryCore.GetCurrentIndex();
+    NewSnapshot->ItemState = GetItemState();
+    NewSnapshot->bIsVirtual = bIsVirtual;
+    NewSnapshot->Slots.Reserve(Items.Num());
+
+    for (const FItemObject& ItemObject : Items)
+    {
+        FItemInventorySnapshot::FSlot& Slot = NewSnapshot->Slots.AddDefaulted_GetRef();
+        Slot.Item = ItemObject.Item;
+        Slot.SlotId = ItemObject.SlotId;
+        Slot.ItemInfos = ItemObject.ItemInfos;
+        Slot.bHasActor = ItemObject.Actor != nullptr;
+    }
+
+    FItemInventorySnapshotPtr OldSnapshot = NewSnapshot;
+    {
+        FWriteScopeLock WriteLock(InventorySnapshotLock);
+        Swap(InventorySnapshot, OldSnapshot);
+    }
+
+    // the previous snapshot is freed here, or by its last reader
+    INC_DWORD_STAT(STAT_ItemSnapshotsPublished);
+}
+
+void UItemManagerComponent::IndexItem(int ItemIndex)
+{
+    const FItemObject& ItemObject = Items[ItemIndex];
+
+    // slots are only appended, the new bit is always the last one
+    if (ItemObject.Item)
+    {
+        for (const FGameplayTag& Tag : ItemObject.Item.GetDefaultObject()->GetItemTags().GetGameplayTagParents())
+        {
+            TBitArray<>& Bits = ItemTagIndex.FindOrAdd(Tag);
+            if (Bits.Num() <= ItemIndex)
+            {
+                Bits.Add(false, ItemIndex + 1 - Bits.Num());
+            }
+            Bits[ItemIndex] = true;
+        }
+    }
+
+    if (DroppableItemIndex.Num() <= ItemIndex)
+    {
+        DroppableItemIndex.Add(false, ItemIndex + 1 - DroppableItemIndex.Num());
+    }
+    DroppableItemIndex[ItemIndex] = ItemObject.GetItemInfos().bIsDropable;
+
+    FItemNameIndexEntry NameEntry;
+    NameEntry.LowerName = ItemObject.GetItemInfos().FriendlyName.ToLower();
+    NameEntry.ItemIndex = ItemIndex;
+
+    int32 const InsertIndex = Algo::UpperBoundBy(ItemNameIndex, NameEntry.LowerName, &FItemNameIndexEntry::LowerName, ItemNameLess);
+    ItemNameIndex.Insert(MoveTemp(NameEntry), InsertIndex);
+}
+
+void UItemManagerComponent::UnindexItem(int ItemIndex)
+{
+    for (TPair<FGameplayTag, TBitArray<>>& TagBits : ItemTagIndex)
+    {
+        if (ItemIndex < TagBits.Value.Num())
+        {
+            TagBits.Value.RemoveAt(ItemIndex);
+        }
+    }
+
+    if (ItemIndex < DroppableItemIndex.Num())
+    {
+        DroppableItemIndex.RemoveAt(ItemIndex);
+    }
+
+    FString const LowerName = Items[ItemIndex].GetItemInfos().FriendlyName.ToLower();
+    int32 NameIndex = Algo::LowerBoundBy(ItemNameIndex, LowerName, &FItemNameIndexEntry::LowerName, ItemNameLess);
+
+    for (; NameIndex < ItemNameIndex.Num() && ItemNameIndex[NameIndex].LowerName.Equals(LowerName, ESearchCase::CaseSensitive); NameIndex++)
+    {
+        if (ItemNameIndex[NameIndex].ItemIndex == ItemIndex)
+        {
+            ItemNameIndex.RemoveAt(NameIndex);
+            break;
+        }
+    }
+
+    // following slots are shifted
+    for (FItemNameIndexEntry& NameEntry : ItemNameIndex)
+    {
+        if (NameEntry.ItemIndex > ItemIndex)
+        {
+            NameEntry.ItemIndex--;
+        }
+    }
+}
+
+TArray<FItemSlotHandle> UItemManagerComponent::BitsToHandles(const TBitArray<>& Bits) const
+{
+    TArray<FItemSlotHandle> Handles;
+
+    for (TConstSetBitIterator<> It(Bits); It; ++It)
+    {
+        if (Items.IsValidIndex(It.GetIndex()))
+        {
+            FItemSlotHandle& Handle = Handles.AddDefaulted_GetRef();
+            Handle.SlotId = Items[It.GetIndex()].SlotId;
+            Handle.IndexHint = It.GetIndex();
+        }
+    }
+
+    return Handles;
+}
+
+TArray<FItemSlotHandle> UItemManagerComponent::FindItemsWithTag(FGameplayTag Tag) const
+{
+    SCOPE_CYCLE_COUNTER(STAT_ItemInventoryQuery);
+
+    const TBitArray<>* Bits = ItemTagIndex.Find(Tag);
+    return Bits ? BitsToHandles(*Bits) : TArray<FItemSlotHandle>();
+}
+
+TArray<FItemSlotHandle> UItemManagerComponent::FindItemsWithAllTags(const FGameplayTagContainer& Tags) const
+{
+    SCOPE_CYCLE_COUNTER(STAT_ItemInventoryQuery);
+
+    TBitArray<> Result;
+    bool bIsFirstTag = true;
+
+    for (const FGameplayTag& Tag : Tags)
+    {
+        const TBitArray<>* Bits = ItemTagIndex.Find(Tag);
+
+        if (!Bits)
+        {
+            return TArray<FItemSlotHandle>();
+        }
+
+        if (bIsFirstTag)
+        {
+            Result = *Bits;
+            bIsFirstTag = false;
+        }
+        else
+        {
+            Result.CombineWithBitwiseAND(*Bits, EBitwiseOperatorFlags::MinSize);
+        }
+    }
+
+    return BitsToHandles(Result);
+}
+
+TArray<FItemSlotHandle> UItemManagerComponent::FindItemsWithAnyTags(const FGameplayTagContainer& Tags) const
+{
+    SCOPE_CYCLE_COUNTER(STAT_ItemInventoryQuery);
+
+    TBitArray<> Result;
+
+    for (const FGameplayTag& Tag : Tags)
+    {
+        if (const TBitArray<>* Bits = ItemTagIndex.Find(Tag))
+        {
+            Result.CombineWithBitwiseOR(*Bits, EBitwiseOperatorFlags::MaxSize);
+        }
+    }
+
+    return BitsToHandles(Result);
+}
+
+TArray<FItemSlotHandle> UItemManagerComponent::FindDroppableItems() const
+{
+    SCOPE_CYCLE_COUNTER(STAT_ItemInventoryQuery);
+
+    return BitsToHandles(DroppableItemIndex);
+}
+
+TArray<FItemSlotHandle> UItemManagerComponent::FindItemsByNamePrefix(const FString& Prefix) const
+{
+    SCOPE_CYCLE_COUNTER(STAT_ItemInventoryQuery);
+
+    TArray<FItemSlotHandle> Handles;
+    FString const LowerPrefix = Prefix.ToLower();
+
+    for (int32 NameIndex = Algo::LowerBoundBy(ItemNameIndex, LowerPrefix, &FItemNameIndexEntry::LowerName, ItemNameLess);
+        NameIndex < ItemNameIndex.Num() && ItemNameIndex[NameIndex].LowerName.StartsWith(LowerPrefix, ESearchCase::CaseSensitive);
+        NameIndex++)
+    {
+        FItemSlotHandle& Handle = Handles.AddDefaulted_GetRef();
+        Handle.SlotId = Items[ItemNameIndex[NameIndex].ItemIndex].SlotId;
+        Handle.IndexHint = ItemNameIndex[NameIndex].ItemIndex;
+    }
+
+    return Handles;
+}
+
+TArray<FItemSlotHandle> UItemManagerComponent::FindItemsByName(const FString& Text) const
+{
+    SCOPE_CYCLE_COUNTER(STAT_ItemInventoryQuery);
+
+    TArray<FItemSlotHandle> Handles;
+    FString const LowerText = Text.ToLower();
+
+    for (const FItemNameIndexEntry& NameEntry : ItemNameIndex)
+    {
+        if (NameEntry.LowerName.Contains(LowerText, ESearchCase::CaseSensitive))
+        {
+            FItemSlotHandle& Handle = Handles.AddDefaulted_GetRef();
+            Handle.SlotId = Items[NameEntry.ItemIndex].SlotId;
+            Handle.IndexHint = NameEntry.ItemIndex;
+        }
+    }
+
+    return Handles;
+}
+
+int32 UItemManagerComponent::GetItemIndexFromHandle(const FItemSlotHandle& Handle) const
+{
+    if (!Handle.IsValid())
+    {
+        return INDEX_NONE;
+    }
+
+    if (Items.IsValidIndex(Handle.IndexHint) && Items[Handle.IndexHint].SlotId == Handle.SlotId)
+    {
+        return Handle.IndexHint;
+    }
+
+    return Items.IndexOfByPredicate([&Handle](const FItemObject& ItemObject)
+    {
+        return ItemObject.SlotId == Handle.SlotId;
+    });
+}
+
+FItemSlotHandle UItemManagerComponent::GetItemHandle(int32 ItemIndex) const
+{
+    FItemSlotHandle Handle;
+
+    if (Items.IsValidIndex(ItemIndex))
+    {
+        Handle.SlotId = Items[ItemIndex].SlotId;
+        Handle.IndexHint = ItemIndex;
+    }
+
+    return Handle;
+}
+
+bool UItemManagerComponent::GetItemFromHandle(const FItemSlotHandle& Handle, FItemObject& OutItem) const
+{
+    int32 const ItemIndex = GetItemIndexFromHandle(Handle);
+
+    if (ItemIndex == INDEX_NONE)
+    {
+        return false;
+    }
+
+    OutItem = Items[ItemIndex];
+    return true;
+}
+
+FInstancedStruct UItemManagerComponent::GetItemInstanceState(int32 ItemIndex) const
+{
+    return Items.IsValidIndex(ItemIndex) ? Items[ItemIndex].GetInstanceState() : FInstancedStruct();
+}
+
+bool UItemManagerComponent::SetItemInstanceState(int32 ItemIndex, const FInstancedStruct& InstanceState)
+{
+    if (!Items.IsValidIndex(ItemIndex))
+    {
+        return false;
+    }
+
+    Items[ItemIndex].InstanceState = InstanceState;
+    return true;
+}
+
+FInstancedStruct* UItemManagerComponent::GetMutableItemInstanceState(int32 ItemIndex)
+{
+    if (!Items.IsValidIndex(ItemIndex))
+    {
+        return nullptr;
+    }
+
+    FItemObject& ItemObject = Items[ItemIndex];
+
+    // copy on write, untouched slots share the defaults of their item
+    if (!ItemObject.InstanceState.IsValid())
+    {
+        ItemObject.InstanceState = ItemObject.GetInstanceState();
+    }
+
+    return &ItemObject.InstanceState;
+}
+
+// Called when the game starts
+void UItemManagerComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+    CachedSubsystem = GetWorld()->GetSubsystem<UItemManagerSubsystem>();
+
+    if (CachedSubsystem.IsValid())
+    {
+        CachedSubsystem->RegisterManager(this);
+
+        // changed before begin play, not requested yet
+        if (bIsInventorySnapshotDirty)
+        {
+            CachedSubsystem->RequestSnapshotPublish(this);
+        }
+    }
+
+    if (bEnableVirtualization)
+    {
+        // decide before the first spawn, an insignificant AI never spawns its item actor
+        UpdateSignificance();
+        // spread over the interval so the managers spawned together do not check on the same frame
+        SetItemTimer(SignificanceTimerHandle, EItemTimerType::IT_Significance, FMath::FRand() * SignificanceCheckInterval);
+    }
+
+    // create an 'empty' item. this item wont have any actor, see IsEmptyItem
+    if(bAddEmptyItemByDefault)
+    {
+        AddItem(AEmptyItem::StaticClass());
+        SpawnItem();
+    }
+
+    // get all items collectables actor in the world
+    TArray<AActor*> FoundActors;
+    UGameplayStatics::GetAllActorsOfClass(GetWorld(), AItemCollectable::StaticClass(), FoundActors);
+    for (AActor* Actor : FoundActors)
+    {
+        AItemCollectable* ItemCollectable = Cast<AItemCollectable>(Actor);
+
+        if (ItemCollectable)
+        {
+            ItemsCollectable.Add(ItemCollectable);
+        }
+    }
+}
+
+void UItemManagerComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    ClearSwitchTimers();
+    ClearItemTimer(SignificanceTimerHandle);
+
+    if (bIsVirtual)
+    {
+        DEC_DWORD_STAT(STAT_ItemVirtualManagers);
+    }
+
+    if (UItemManagerSubsystem* ItemManagerSubsystem = GetWorld()->GetSubsystem<UItemManagerSubsystem>())
+    {
+        ItemManagerSubsystem->UnregisterManager(this);
+    }
+
+    Super::EndPlay(EndPlayReason);
+}
+
+void UItemManagerComponent::ClearSwitchTimers()
+{
+    ClearItemTimer(SpawnItemTimerHandle);
+    ClearItemTimer(DestroyItemTimerHandle);
+    ClearItemTimer(SwitchingTimerHandle);
+}
+
+void UItemManagerComponent::SetItemTimer(FItemTimerHandle& Handle, EItemTimerType Type, float Delay, int32 Value)
+{
+    // replaces the pending one, like a timer manager handle
+    ClearItemTimer(Handle);
+
+    FItemTimer Timer;
+    Timer.Manager = this;
+    Timer.Type = Type;
+    Timer.Value = Value;
+
+    if (CachedSubsystem.IsValid())
+    {
+        Handle = CachedSubsystem->ScheduleItemTimer(Timer, Delay);
+    }
+    else if (Type != EItemTimerType::IT_Significance)
+    {
+        // not begun play yet, nothing to wait for
+        HandleItemTimer(Timer);
+    }
+}
+
+void UItemManagerComponent::ClearItemTimer(FItemTimerHandle& Handle)
+{
+    if (Handle.IsValid() && CachedSubsystem.IsValid())
+    {
+        CachedSubsystem->CancelItemTimer(Handle);
+    }
+
+    Handle.Invalidate();
+}
+
+void UItemManagerComponent::HandleItemTimer(const FItemTimer& Timer)
+{
+    switch (Timer.Type)
+    {
+    case EItemTimerType::IT_SpawnItem:
+        SpawnItemTimerHandle.Invalidate();
+        SpawnItem();
+        break;
+
+    case EItemTimerType::IT_DestroyItem:
+        DestroyItemTimerHandle.Invalidate();
+        DestroyItem(Timer.Value);
+        break;
+
+    case EItemTimerType::IT_EndSwitching:
+        SwitchingTimerHandle.Invalidate();
+        InventoryCore.EndSwitching();
+        break;
+
+    case EItemTimerType::IT_Significance:
+        SignificanceTimerHandle.Invalidate();
+        UpdateSignificance();
+        SetItemTimer(SignificanceTimerHandle, EItemTimerType::IT_Significance, FMath::Max(SignificanceCheckInterval, 0.05f));
+        break;
+    }
+}
+
+
 // Called every frame
 void UItemManagerComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
+    if (bIsUsingItem)
+    {
+        UpdateHeldUse(DeltaTime);
+    }
+
     //GEngine->AddOnScreenDebugMessage(0, MAX_flt, FColor::Cyan, FString(TEXT("Item State : ") + ItemStateToString(ItemState)));
 }
 
@@ -9,9 +9,18 @@
 #include "Kismet/GameplayStatics.h"
 #include "Engine/World.h"
 #include "TimerManager.h"
+#include "PerPlatformProperties.h"
+#include "GameplayTagContainer.h"
 #include <ItemParent.h>
 #include <ItemCollectable.h>
 #include <DefaultItems/EmptyItem.h>
+#include "utils/ItemConfigRegistry.h"
+#include "utils/ItemManagerTrace.h"
+#include "ItemLootTable.h"
+#include "utils/ItemManagerEventBus.h"
+#include "utils/ItemManagerMemReport.h"
+#include "utils/ItemTimingWheel.h"
+#include "ItemInventoryCore.h"
 #include "ItemManagerComponent.generated.h"
 
 UENUM(BlueprintType)
@@ -33,16 +42,187 @@ struct FItemObject
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item Object")
     AItemParent* Actor;
     
+    // unique in the item manager, used by FItemSlotHandle
+    int32 SlotId = INDEX_NONE;
+
+    // shared with every slot using the same config, see FItemConfigRegistry
+    TSharedPtr<const FItemInfos> ItemInfos;
+    TSharedPtr<const FItemCollectableData> ItemCollectableData;
+
+    // state of this instance of the item (ammo, durability...), empty until first written
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item Object")
-    FItemInfos ItemInfos;
+    FInstancedStruct InstanceState;
+
+    // The slot state, or the defaults of the item if never written
+    const FInstancedStruct& GetInstanceState() const
+    {
+        return InstanceState.IsValid() || !Item ? InstanceState : Item.GetDefaultObject()->GetDefaultInstanceState();
+    }
 
-    FItemCollectableData ItemCollectableData;
+    const FItemInfos& GetItemInfos() const
+    {
+        static const FItemInfos DefaultItemInfos;
+        return ItemInfos.IsValid() ? *ItemInfos : DefaultItemInfos;
+    }
+
+    const FItemCollectableData& GetItemCollectableData() const
+    {
+        static const FItemCollectableData DefaultItemCollectableData;
+        return ItemCollectableData.IsValid() ? *ItemCollectableData : DefaultItemCollectableData;
+    }
+
+    // The collectable data to drop the slot with, the defaults of the item for records made in Blueprint
+    TSharedRef<const FItemCollectableData> GetItemCollectableDataRef() const
+    {
+        return ItemCollectableData.IsValid() ? ItemCollectableData.ToSharedRef() : FItemConfigRegistry::Get().GetItemCollectableData(Item);
+    }
 
     bool operator==(const FItemObject& Other) const
     {
         return Item == Other.Item;
     }
+
+    // Properties, then the records that differ from the item defaults
+    bool Serialize(FArchive& Ar);
+};
+
+template<>
+struct TStructOpsTypeTraits<FItemObject> : public TStructOpsTypeTraitsBase2<FItemObject>
+{
+    enum
+    {
+        WithSerializer = true,
+    };
+};
+
+UENUM(BlueprintType)
+enum class EItemChangeType : uint8
+{
+    IC_Added UMETA(DisplayName = "Added"),
+    IC_Removed UMETA(DisplayName = "Removed", ToolTip = "The following slots are shifted by one"),
+    IC_Moved UMETA(DisplayName = "Moved"),
+    IC_StateChanged UMETA(DisplayName = "State Changed", ToolTip = "The slot has been switched on/off, or its actor spawned/despawned")
 };
+
+USTRUCT(BlueprintType)
+struct FItemChange
+{
+    GENERATED_USTRUCT_BODY()
+
+    UPROPERTY(BlueprintReadOnly, meta = (ToolTip = "Inventory version after this change"), Category = "Item Change")
+    int32 Version = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Item Change")
+    EItemChangeType ChangeType = EItemChangeType::IC_StateChanged;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Item Change")
+    int32 SlotId = INDEX_NONE;
+
+    UPROPERTY(BlueprintReadOnly, meta = (ToolTip = "Index of the slot after the change (before the change if removed)"), Category = "Item Change")
+    int32 ItemIndex = INDEX_NONE;
+
+    UPROPERTY(BlueprintReadOnly, meta = (ToolTip = "Index of the slot before the change. Only set if moved"), Category = "Item Change")
+    int32 PreviousItemIndex = INDEX_NONE;
+};
+
+// Reference to an item slot that stays valid when other slots are removed
+USTRUCT(BlueprintType)
+struct FItemSlotHandle
+{
+    GENERATED_USTRUCT_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Item Slot Handle")
+    int32 SlotId = INDEX_NONE;
+
+    // index of the slot when the handle was created, checked first when resolving the handle
+    UPROPERTY(BlueprintReadOnly, Category = "Item Slot Handle")
+    int32 IndexHint = INDEX_NONE;
+
+    bool IsValid() const { return SlotId != INDEX_NONE; }
+};
+
+// Summary of an AddItems/RemoveItems call. Nothing is applied if Error is not 0.
+USTRUCT(BlueprintType)
+struct FItemBatchResult
+{
+    GENERATED_USTRUCT_BODY()
+
+    UPROPERTY(BlueprintReadOnly, meta = (ToolTip = "0 : No error.\n 1 : Invalid item or slot.\n 2 : Item limit reached.\n 3 : Duplicates.\n 4 : Item is switching."), Category = "Item Batch")
+    int32 Error = 0;
+
+    UPROPERTY(BlueprintReadOnly, meta = (ToolTip = "Index in the batch of the entry that failed the validation, -1 if none"), Category = "Item Batch")
+    int32 FailedEntry = INDEX_NONE;
+
+    UPROPERTY(BlueprintReadOnly, meta = (ToolTip = "Added slots, or removed slots (no longer valid)"), Category = "Item Batch")
+    TArray<FItemSlotHandle> Slots;
+};
+
+struct FItemNameIndexEntry
+{
+    FString LowerName;
+    int32 ItemIndex = INDEX_NONE;
+};
+
+USTRUCT(BlueprintType)
+struct FItemResidencyStats
+{
+    GENERATED_USTRUCT_BODY()
+
+    UPROPERTY(BlueprintReadOnly, meta = (ToolTip = "Number of switches on an item whose actor was still resident"), Category = "Item Residency")
+    int32 Hits = 0;
+
+    UPROPERTY(BlueprintReadOnly, meta = (ToolTip = "Number of switches on an item whose actor had to be spawned"), Category = "Item Residency")
+    int32 Misses = 0;
+
+    UPROPERTY(BlueprintReadOnly, meta = (ToolTip = "Number of resident actors that have been evicted"), Category = "Item Residency")
+    int32 Evictions = 0;
+
+    UPROPERTY(BlueprintReadOnly, meta = (ToolTip = "Number of item actors currently resident (not including the current item)"), Category = "Item Residency")
+    int32 ResidentItems = 0;
+
+    UPROPERTY(BlueprintReadOnly, meta = (ToolTip = "Estimated memory used by the resident actors, in KB"), Category = "Item Residency")
+    int32 ResidentMemoryKB = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Item Residency")
+    float HitRate = 0.f;
+};
+
+// Immutable copy of an inventory, safe to read from any thread. No UObject of the world is referenced.
+struct FItemInventorySnapshot
+{
+    struct FSlot
+    {
+        TSubclassOf<AItemParent> Item;
+        int32 SlotId = INDEX_NONE;
+        TSharedPtr<const FItemInfos> ItemInfos;
+        bool bHasActor = false;
+
+        const FItemInfos& GetItemInfos() const
+        {
+            static const FItemInfos DefaultItemInfos;
+            return ItemInfos.IsValid() ? *ItemInfos : DefaultItemInfos;
+        }
+    };
+
+    // inventory version it has been taken at
+    int32 Version = 0;
+    int32 CurrentItemIndex = INDEX_NONE;
+    EItemState ItemState = EItemState::IS_None;
+    bool bIsVirtual = false;
+    TArray<FSlot> Slots;
+
+    const FSlot* GetCurrentSlot() const { return Slots.IsValidIndex(CurrentItemIndex) ? &Slots[CurrentItemIndex] : nullptr; }
+};
+
+using FItemInventorySnapshotPtr = TSharedPtr<const FItemInventorySnapshot, ESPMode::ThreadSafe>;
+
+struct FItemResidentActor
+{
+    // cleared by the garbage collector if the actor is destroyed behind the manager
+    TWeakObjectPtr<AItemParent> Actor;
+    int64 ResourceSize = 0;
+};
+
 DECLARE_LOG_CATEGORY_EXTERN(ItemManager, Log, All);
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnItemCollectedDelegate);
@@ -55,34 +235,122 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnItemDespawnedDelegate, FItemObjec
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnBeginOverlapDelegate, AItemCollectable*, NewItem);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnEndOverlapDelegate, AItemCollectable*, NewItem);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnAddingItem, int, Value);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnItemsBatchDelegate, const FItemBatchResult&, Result);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnItemUsesDelegate, int32, ItemIndex, int32, NumUses);
+
+class UItemManagerSubsystem;
 
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent, DisplayName = "Item Manager", ToolTip = "Item Manager Component"), Category = "Item Manager")
 class UItemManagerComponent : public UActorComponent
 {
 	GENERATED_BODY()
 
+    friend class FItemManagerTraceReplayer;
+    friend class FItemManagerSoakTest;
+    friend class UItemManagerSubsystem;
+    friend class UItemContainerComponent;
+
 private:
+    // reported to the garbage collector, destroyed actors are cleared by the next collection
+    UPROPERTY(Transient)
     TArray<FItemObject> Items;
+
+    UPROPERTY(Transient)
     TArray<AItemCollectable*> ItemsCollectable;
-	int CurrentItemIndex;
-    bool bIsSwitchingItem;
+
+    // current slot and switch state, with the rules of each slot of Items
+    FItemInventoryCore InventoryCore;
+
+    UPROPERTY(Transient)
 	AItemCollectable* CurrentItemCollectable;
-    EItemState ItemState = EItemState::IS_None;
+
+    UPROPERTY(Transient)
     USkeletalMeshComponent* CharacterMesh;
-    FTimerHandle SpawnItemTimerHandle;
-    FTimerHandle DestroyItemTimerHandle;
 
-    AItemParent* GetItemInstance(TSubclassOf<AItemParent> Item);
+    // pending lifecycle timers, on the timing wheel of the subsystem
+    FItemTimerHandle SpawnItemTimerHandle;
+    FItemTimerHandle DestroyItemTimerHandle;
+    int32 PendingDestroyItemIndex = INDEX_NONE;
+    FItemTimerHandle SwitchingTimerHandle;
+
+    // least recently used first
+    TArray<FItemResidentActor> ResidentItems;
+    FItemResidencyStats ResidencyStats;
+
+    // query indices, updated when slots are added/removed. Bits are slot indices
+    int32 NextSlotId = 0;
+    TMap<FGameplayTag, TBitArray<>> ItemTagIndex;
+    TBitArray<> DroppableItemIndex;
+    TArray<FItemNameIndexEntry> ItemNameIndex;
+
+    // slot level changes, oldest first
+    int32 InventoryVersion = 0;
+    TArray<FItemChange> ChangeJournal;
+
+    // readers only hold the lock to copy the pointer, snapshots are built outside of it
+    FItemInventorySnapshotPtr InventorySnapshot;
+    mutable FRWLock InventorySnapshotLock;
+    bool bIsInventorySnapshotDirty = false;
+
+    // only the calls made from outside of the manager are recorded
+    TUniquePtr<FItemManagerTraceRecorder> TraceRecorder;
+    int32 TraceCallDepth = 0;
+
+    // virtual managers only keep the data-side inventory, no item actor is spawned
+    bool bIsVirtual = false;
+    FItemTimerHandle SignificanceTimerHandle;
+
+    // slots holstered when the manager became virtual, or switched out since
+    TSet<int32> VirtualHolsteredSlotIds;
+
+    TWeakObjectPtr<UItemManagerSubsystem> CachedSubsystem;
+
+    // held use, repeated at the item use rate by the component tick
+    bool bIsUsingItem = false;
+    float UseTimeAccumulator = 0.f;
+
     void PickupItem(AItemParent* item);
 	void SwitchItem(int newItemIndex);
+    void SwitchToSelectedItem(const FItemSwitchSelection& Selection);
     void SpawnItemLambda(float delay);
     void SpawnItem();
-    void DestroyItemLambda(float delay);
+    void DestroyItemLambda(float delay, int OldItemIndex);
     void DestroyItem(int OldItemIndex);
     void ActivateSwitching(int Delay);
     bool IsCurrentItemValid();
-    FItemCollectableData SetItemCollectableData(AItemCollectable* ItemCollectable);
+    TSharedRef<const FItemCollectableData> SetItemCollectableData(AItemCollectable* ItemCollectable);
     FAttachmentTransformRules EnumAttachmentRulesToStuct(EAttachmentRules AttachmentRules);
+    FTransform GetDropTransform(int ItemIndex);
+    void SpawnItemCollectable(const TSharedRef<const FItemCollectableData>& ItemCollectableData, const FTransform& Transform, const FInstancedStruct& InstanceState);
+    void DespawnItemActor(AItemParent* ItemActor);
+    AItemParent* SpawnSlotActor(int ItemIndex);
+    void HolsterItemActor(int ItemIndex);
+    void ClearSwitchTimers();
+    void SetItemTimer(FItemTimerHandle& Handle, EItemTimerType Type, float Delay, int32 Value = INDEX_NONE);
+    void ClearItemTimer(FItemTimerHandle& Handle);
+    void HandleItemTimer(const FItemTimer& Timer);
+    bool IsResidencyEnabled() const;
+    void MakeItemResident(int ItemIndex);
+    void ActivateResidentItem(AItemParent* ItemActor);
+    void RemoveResidentItem(AItemParent* ItemActor);
+    void EnforceResidencyBudget();
+    int64 GetInventoryAllocatedSize() const;
+    int AddItemObject(FItemObject& NewItem);
+    void RemoveItemAt(int ItemIndex);
+    static FItemCoreSlot MakeCoreSlot(const FItemObject& ItemObject);
+    FItemInventoryRules GetInventoryRules() const;
+    void IndexItem(int ItemIndex);
+    void UnindexItem(int ItemIndex);
+    TArray<FItemSlotHandle> BitsToHandles(const TBitArray<>& Bits) const;
+    void RecordItemChange(EItemChangeType ChangeType, int ItemIndex, int PreviousItemIndex = INDEX_NONE);
+    void MarkInventorySnapshotDirty();
+    void PublishInventorySnapshot();
+    void RecordTraceOp(EItemTraceOp Op, int32 Value = 0);
+    bool IsOwnerSignificant() const;
+    void BroadcastItemEvent(EItemManagerEvent Type, int32 ItemIndex, int32 Value = 0, AItemCollectable* ItemCollectable = nullptr);
+    void UpdateSignificance();
+    void UpdateHeldUse(float DeltaTime);
+    void DispatchUses(int32 NumUses);
 
 public:	
 	// Sets default values for this component's properties
@@ -91,10 +359,31 @@ public:
 	void OnPickableBeginOverlap(AItemCollectable* ItemCollectable);
 	void OnPickableEndOverlap(AItemCollectable* ItemCollectable);
 
+    // Called by the scheduler once a dropped ItemCollectable has been spawned
+    void RegisterItemCollectable(AItemCollectable* ItemCollectable);
+    void UnregisterItemCollectable(AItemCollectable* ItemCollectable);
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Start Trace Recording", ToolTip = "Record the calls made to the item manager (add, switch, collect, drop, use) with their frame."), Category = "Item Manager|Trace")
+    void StartTraceRecording();
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Stop Trace Recording", ToolTip = "Stop recording and save the trace. Return false if nothing was recorded or the file cannot be written."), Category = "Item Manager|Trace")
+    bool StopTraceRecording(const FString& FilePath);
+
+    bool IsTraceRecording() const { return TraceRecorder.IsValid(); }
+
+    // Enter/leave the virtual mode. Item actors are destroyed when entering it and the current item is spawned back when leaving it.
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Set Virtual", ToolTip = "A virtual item manager keeps its items and switch state but does not spawn any item actor."), Category = "Item Manager|Virtualization")
+    void SetVirtual(bool bVirtual);
+
+    UFUNCTION(BlueprintPure, BlueprintCallable, meta = (DisplayName = "Is Virtual"), Category = "Item Manager|Virtualization")
+    bool IsVirtual() const { return bIsVirtual; };
+
 protected:
 
 	UFUNCTION(BlueprintCallable, Category = "Item")
 	void CollectItem();
+
+public:
 	
     // return value based on error. such as invalid item or item limit reach.
     // 0 --> No error
@@ -104,6 +393,19 @@ protected:
     UFUNCTION(BlueprintCallable, meta = (DisplayName = "Add Item", ToolTip = "Add an item to the list of items. If item already exist, it will not be added."), Category = "Item Manager")
     int AddItem(TSubclassOf<AItemParent> Item);
 
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Add Loot", ToolTip = "Draw a loot table and add the items. Return the number of items added.\nThe same seed always gives the same items."), Category = "Item Manager|Loot")
+    int32 AddLoot(UItemLootTable* LootTable, int32 Seed, FGameplayTagContainer ContextTags);
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Add Items", ToolTip = "Add all the items or none of them. The whole set is checked against the item limit and duplicates first.\nOn Adding Items is called once. If Equip First Item is true, the first added item is switched to."), Category = "Item Manager")
+    FItemBatchResult AddItems(const TArray<TSubclassOf<AItemParent>>& NewItems, bool bEquipFirstItem = false);
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Remove Items", ToolTip = "Remove all the slots or none of them. On Removing Items is called once."), Category = "Item Manager")
+    FItemBatchResult RemoveItems(const TArray<FItemSlotHandle>& Slots);
+
+    // AddItems/RemoveItems on whole records, used to move items without losing their collectable data
+    FItemBatchResult AddItemObjects(const TArray<FItemObject>& NewItems, bool bEquipFirstItem = false);
+    FItemBatchResult RemoveItemObjects(const TArray<FItemSlotHandle>& Slots, TArray<FItemObject>& OutRemovedItems);
+
 	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Switch Next Item"), Category = "Item Manager")
 	void SwitchNextItem();
 
@@ -116,9 +418,24 @@ protected:
     UFUNCTION(BlueprintCallable, meta = (DisplayName = "Drop Item"), Category = "Item Manager")
     void DropItem();
 
+    // Drop every droppable item at once. Inventory is updated right away, the ItemCollectables are spawned by the scheduler.
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Drop All Items"), Category = "Item Manager")
+    void DropAllItems();
+
     UFUNCTION(BlueprintCallable, meta = (DisplayName = "Use Item"), Category = "Item Manager")
     void UseItem();
 
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Begin Use Item", ToolTip = "Use the current item now, then again at its Use Rate until End Use Item is called or the item is switched."), Category = "Item Manager")
+    void BeginUseItem();
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "End Use Item"), Category = "Item Manager")
+    void EndUseItem();
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Swap Items", ToolTip = "Swap the position of two items in the items list."), Category = "Item Manager")
+    bool SwapItems(int32 FirstIndex, int32 SecondIndex);
+
+protected:
+
     UPROPERTY(EditAnywhere, meta = (DisplayName = "Loop Switching", ToolTip = "If true, Item Manager will loop in the items list. "), Category = "Item Manager")
     bool bLoopSwitching{ true };
 
@@ -131,6 +448,27 @@ protected:
     UPROPERTY(EditAnywhere, meta = (DisplayName = "Item Limit", ToolTip = "Litmit the number of item.\nIf set to 0, the number of item will be unlimited"), Category = "Item Manager")
     int ItemLimit{ 0 };
 
+    UPROPERTY(EditAnywhere, meta = (DisplayName = "Change Journal Capacity", ToolTip = "Number of slot changes kept for Get Changes Since. Older versions will require a full resync."), Category = "Item Manager")
+    int32 ChangeJournalCapacity{ 256 };
+
+    UPROPERTY(EditAnywhere, meta = (DisplayName = "Enable Virtualization", ToolTip = "If true, the item manager becomes virtual (no item actor) while its owner is not significant: not locally controlled, not recently rendered and far from every player."), Category = "Item Manager|Virtualization")
+    bool bEnableVirtualization{ false };
+
+    UPROPERTY(EditAnywhere, meta = (DisplayName = "Virtualization Distance", ToolTip = "Distance to the closest player above which the owner is not significant", EditCondition = "bEnableVirtualization"), Category = "Item Manager|Virtualization")
+    float VirtualizationDistance{ 3000.f };
+
+    UPROPERTY(EditAnywhere, meta = (DisplayName = "Use Net Relevancy", ToolTip = "If true, on a server the owner is also significant while it is net relevant to a player", EditCondition = "bEnableVirtualization"), Category = "Item Manager|Virtualization")
+    bool bUseNetRelevancy{ true };
+
+    UPROPERTY(EditAnywhere, meta = (DisplayName = "Significance Check Interval", ToolTip = "Time in seconds between two significance checks", EditCondition = "bEnableVirtualization"), Category = "Item Manager|Virtualization")
+    float SignificanceCheckInterval{ 0.5f };
+
+    UPROPERTY(EditAnywhere, meta = (DisplayName = "Max Resident Items", ToolTip = "Number of switched out item actors kept alive (hidden and dormant) so switching back to them is instant. Least recently used items are evicted first.\nIf set to 0 and no memory budget is set, despawning items are destroyed and non despawning items are kept forever."), Category = "Item Manager|Residency")
+    FPerPlatformInt MaxResidentItems{ 0 };
+
+    UPROPERTY(EditAnywhere, meta = (DisplayName = "Resident Memory Budget (KB)", ToolTip = "Estimated memory the switched out item actors are allowed to use. Least recently used items are evicted first.\nIf set to 0, only Max Resident Items is used."), Category = "Item Manager|Residency")
+    FPerPlatformInt ResidentMemoryBudgetKB{ 0 };
+
 
 
 	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Switched Item", ToolTip = "Called when switching item has been done successfully."), Category = "Item Manager")
@@ -160,20 +498,48 @@ protected:
     UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Adding Item", ToolTip = "Called when adding an item.\n 0 : No error.\n 1 : Invalid item.\n 2 : Item limit reached.\n 3 : Duplicates."), Category = "Item Manager")
     FOnAddingItem OnAddingItem;
 
+    UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Adding Items", ToolTip = "Called once per Add Items call, with the added slots or the reason nothing was added."), Category = "Item Manager")
+    FOnItemsBatchDelegate OnAddingItems;
+
+    UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Removing Items", ToolTip = "Called once per Remove Items call, with the removed slots or the reason nothing was removed."), Category = "Item Manager")
+    FOnItemsBatchDelegate OnRemovingItems;
+
+    UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Item Uses", ToolTip = "Called once per tick while the item is held in use, with the number of uses since the last tick."), Category = "Item Manager")
+    FOnItemUsesDelegate OnItemUses;
+
 	virtual void BeginPlay() override;
     virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:	
 	
+    UFUNCTION(BlueprintPure, BlueprintCallable, meta = (DisplayName = "Get Item Object Infos", ToolTip = "Get the infos of an item object, or the defaults of its item if the object was made in Blueprint"), Category = "Item Manager")
+    static FItemInfos GetItemObjectInfos(const FItemObject& ItemObject);
+
+    UFUNCTION(BlueprintPure, BlueprintCallable, meta = (DisplayName = "Get Item Object Collectable Data", ToolTip = "Get the collectable data an item object is dropped with, or the defaults of its item if the object was made in Blueprint"), Category = "Item Manager")
+    static FItemCollectableData GetItemObjectCollectableData(const FItemObject& ItemObject);
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Set Item Object Infos", ToolTip = "Give an item object its own infos"), Category = "Item Manager")
+    static void SetItemObjectInfos(UPARAM(ref) FItemObject& ItemObject, const FItemInfos& ItemInfos);
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Set Item Object Collectable Data", ToolTip = "Give an item object its own collectable data, used when it is dropped"), Category = "Item Manager")
+    static void SetItemObjectCollectableData(UPARAM(ref) FItemObject& ItemObject, const FItemCollectableData& ItemCollectableData);
+
     UFUNCTION(BlueprintPure, BlueprintCallable, meta = (DisplayName = "Get Current Item", ToolTip = "Get the current item"), Category = "Item Manager")
-    FItemObject GetCurrentItem() const { return Items[CurrentItemIndex]; };
+    FItemObject GetCurrentItem() const { return Items[InventoryCore.GetCurrentIndex()]; };
 
     UFUNCTION(BlueprintPure, BlueprintCallable, meta = (DisplayName = "Get Current Item Index", ToolTip = "Get the current item"), Category = "Item Manager")
-    int32 GetCurrentItemIndex() const { return CurrentItemIndex; };
+    int32 GetCurrentItemIndex() const { return InventoryCore.GetCurrentIndex(); };
+
+    AItemParent* GetCurrentItemActor() const { return Items.IsValidIndex(GetCurrentItemIndex()) ? Items[GetCurrentItemIndex()].Actor : nullptr; }
+
+    UFUNCTION(BlueprintPure, BlueprintCallable, meta = (DisplayName = "Is Using Item", ToolTip = "Return true between Begin Use Item and End Use Item"), Category = "Item Manager")
+    bool IsUsingItem() const { return bIsUsingItem; }
 
     UFUNCTION(BlueprintPure, BlueprintCallable, meta = (DisplayName = "Get Items", ToolTip = "Get the current item"), Category = "Item Manager")
     TArray<FItemObject> GetItems() const { return Items; };
 
+    int32 GetNumItems() const { return Items.Num(); }
+
     UFUNCTION(BlueprintPure, BlueprintCallable, meta = (DisplayName = "Get Items Collectable", ToolTip = "Get all items collectable in the world"), Category = "Item Manager")
     TArray<AItemCollectable*> GetItemsCollectables() const { return ItemsCollectable; };
 
@@ -190,7 +556,81 @@ public:
     bool IsLoopSwitching() const { return bLoopSwitching; };
 
     UFUNCTION(BlueprintPure, BlueprintCallable, meta = (DisplayName = "Get Item State", ToolTip = "Return the current item state."), Category = "Item Manager")
-    EItemState GetItemState() const { return ItemState; };
+    EItemState GetItemState() const { return static_cast<EItemState>(InventoryCore.GetPhase()); };
+
+    UFUNCTION(BlueprintPure, BlueprintCallable, meta = (DisplayName = "Get Inventory Version", ToolTip = "Incremented on each slot change"), Category = "Item Manager")
+    int32 GetInventoryVersion() const { return InventoryVersion; };
+
+    // Return false if Version is too old (or unknown) and the whole items list must be read again.
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Changes Since", ToolTip = "Get the slot changes made after Version, oldest first.\nReturn false if a full resync is required (Version is too old or unknown)."), Category = "Item Manager")
+    bool GetChangesSince(int32 Version, TArray<FItemChange>& OutChanges) const;
+
+    // Latest published copy of the inventory, callable from any thread. Changes are published once per frame,
+    // or right away when called from the game thread.
+    FItemInventorySnapshotPtr GetInventorySnapshot();
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Find Items With Tag", ToolTip = "Return the items having the tag (or one of its children)."), Category = "Item Manager|Query")
+    TArray<FItemSlotHandle> FindItemsWithTag(FGameplayTag Tag) const;
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Find Items With All Tags", ToolTip = "Return the items having all the tags."), Category = "Item Manager|Query")
+    TArray<FItemSlotHandle> FindItemsWithAllTags(const FGameplayTagContainer& Tags) const;
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Find Items With Any Tags", ToolTip = "Return the items having at least one of the tags."), Category = "Item Manager|Query")
+    TArray<FItemSlotHandle> FindItemsWithAnyTags(const FGameplayTagContainer& Tags) const;
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Find Droppable Items", ToolTip = "Return the items that can be dropped."), Category = "Item Manager|Query")
+    TArray<FItemSlotHandle> FindDroppableItems() const;
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Find Items By Name Prefix", ToolTip = "Return the items whose friendly name starts with Prefix (case insensitive)."), Category = "Item Manager|Query")
+    TArray<FItemSlotHandle> FindItemsByNamePrefix(const FString& Prefix) const;
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Find Items By Name", ToolTip = "Return the items whose friendly name contains Text (case insensitive)."), Category = "Item Manager|Query")
+    TArray<FItemSlotHandle> FindItemsByName(const FString& Text) const;
+
+    UFUNCTION(BlueprintPure, BlueprintCallable, meta = (DisplayName = "Get Item Index From Handle", ToolTip = "Return the index of the slot, -1 if the slot does not exist anymore."), Category = "Item Manager|Query")
+    int32 GetItemIndexFromHandle(const FItemSlotHandle& Handle) const;
+
+    UFUNCTION(BlueprintPure, BlueprintCallable, meta = (DisplayName = "Get Item Handle", ToolTip = "Return a handle on the slot at ItemIndex, invalid if there is no such slot."), Category = "Item Manager|Query")
+    FItemSlotHandle GetItemHandle(int32 ItemIndex) const;
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Item From Handle", ToolTip = "Return false if the slot does not exist anymore."), Category = "Item Manager|Query")
+    bool GetItemFromHandle(const FItemSlotHandle& Handle, FItemObject& OutItem) const;
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Item Instance State", ToolTip = "Get the state of the item instance in the slot (ammo, durability...), or the defaults of the item if never written.\nThe item actor does not need to be spawned."), Category = "Item Manager|Instance State")
+    FInstancedStruct GetItemInstanceState(int32 ItemIndex) const;
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Set Item Instance State", ToolTip = "Replace the state of the item instance in the slot. It follows the item when dropped, collected or moved to a container.\nReturn false if the slot does not exist."), Category = "Item Manager|Instance State")
+    bool SetItemInstanceState(int32 ItemIndex, const FInstancedStruct& InstanceState);
+
+    // Typed access without copy, null if the slot does not exist or its state is not a T
+    template<typename T>
+    const T* GetItemInstanceStatePtr(int32 ItemIndex) const
+    {
+        return Items.IsValidIndex(ItemIndex) ? Items[ItemIndex].GetInstanceState().GetPtr<T>() : nullptr;
+    }
+
+    // The defaults of the item are copied to the slot on the first write
+    template<typename T>
+    T* GetMutableItemInstanceStatePtr(int32 ItemIndex)
+    {
+        FInstancedStruct* InstanceState = GetMutableItemInstanceState(ItemIndex);
+        return InstanceState ? InstanceState->GetMutablePtr<T>() : nullptr;
+    }
+
+    FInstancedStruct* GetMutableItemInstanceState(int32 ItemIndex);
+
+    UFUNCTION(BlueprintPure, BlueprintCallable, meta = (DisplayName = "Get Residency Stats", ToolTip = "Return the hit/miss stats of the resident item actors."), Category = "Item Manager")
+    FItemResidencyStats GetResidencyStats() const;
+
+    // The default empty slot is a sentinel: it never spawns an actor and switches to or from it cost nothing
+    UFUNCTION(BlueprintPure, BlueprintCallable, meta = (DisplayName = "Is Empty Item", ToolTip = "Return true if the slot at ItemIndex is the empty hands slot (no actor)."), Category = "Item Manager")
+    bool IsEmptyItem(int32 ItemIndex) const;
+
+    // The inventory records and indices. Item actors are accounted as actors of their own.
+    virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
+    // One record per slot, with the representation of the item and the size of its actor
+    void GetItemMemoryRecords(TArray<FItemMemoryRecord>& OutRecords) const;
 
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
@@ -0,0 +1,89 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+
+#include "ItemManagerSettings.h"
+#include "ItemManagerComponent.h"
+#include "ItemManagerSubsystem.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+
+UItemManagerSettings::UItemManagerSettings()
+{
+    OutlineMaterial = TSoftObjectPtr<UMaterialInstance>(FSoftObjectPath(TEXT("/ItemManager/Materials/M_Outline_Inst.M_Outline_Inst")));
+    TransparencyPostProcessMaterial = TSoftObjectPtr<UMaterialInstance>(FSoftObjectPath(TEXT("/ItemManager/Materials/M_TransparencyPP_Inst.M_TransparencyPP_Inst")));
+}
+
+#if WITH_EDITOR
+void UItemManagerSettings::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+    Super::PostEditChangeProperty(PropertyChangedEvent);
+
+    // keep the new assets loaded instead of the old ones
+    if (PreloadHandle.IsValid())
+    {
+        PreloadHandle->ReleaseHandle();
+        PreloadHandle.Reset();
+        PreloadSeconds = 0.0;
+    }
+
+    RequestSharedAssetsPreload();
+}
+#endif
+
+void UItemManagerSettings::RequestSharedAssetsPreload()
+{
+    // the streamable manager of the asset manager only exists once the engine is initialized
+    if (PreloadHandle.IsValid() || !UAssetManager::IsInitialized())
+    {
+        return;
+    }
+
+    TArray<FSoftObjectPath> AssetPaths;
+
+    // nobody sees the outline and the transparency on a dedicated server
+    if (!UItemManagerSubsystem::IsServerModeEnabled())
+    {
+        if (!OutlineMaterial.IsNull())
+        {
+            AssetPaths.Add(OutlineMaterial.ToSoftObjectPath());
+        }
+
+        if (!TransparencyPostProcessMaterial.IsNull())
+        {
+            AssetPaths.Add(TransparencyPostProcessMaterial.ToSoftObjectPath());
+        }
+    }
+
+    if (AssetPaths.Num() <= 0)
+    {
+        return;
+    }
+
+    PreloadStartTime = FPlatformTime::Seconds();
+    PreloadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(AssetPaths,
+        FStreamableDelegate::CreateUObject(this, &UItemManagerSettings::OnSharedAssetsPreloaded), FStreamableManager::AsyncLoadHighPriority);
+
+    if (!PreloadHandle.IsValid())
+    {
+        UE_LOG(ItemManager, Warning, TEXT("Cannot preload the shared item assets"));
+    }
+}
+
+void UItemManagerSettings::OnSharedAssetsPreloaded()
+{
+    PreloadSeconds = FMath::Max(FPlatformTime::Seconds() - PreloadStartTime, UE_DOUBLE_SMALL_NUMBER);
+
+    UE_LOG(ItemManager, Log, TEXT("Shared item assets preloaded in %.2f ms"), PreloadSeconds * 1000.0);
+}
+
+UMaterialInstance* UItemManagerSettings::GetOutlineMaterial() const
+{
+    UMaterialInstance* Material = OutlineMaterial.Get();
+    return Material || OutlineMaterial.IsNull() ? Material : OutlineMaterial.LoadSynchronous();
+}
+
+UMaterialInstance* UItemManagerSettings::GetTransparencyPostProcessMaterial() const
+{
+    UMaterialInstance* Material = TransparencyPostProcessMaterial.Get();
+    return Material || TransparencyPostProcessMaterial.IsNull() ? Material : TransparencyPostProcessMaterial.LoadSynchronous();
+}
@@ -0,0 +1,581 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+
+#include "ItemManagerSubsystem.h"
+#include "ItemManagerComponent.h"
+#include "ItemManagerStats.h"
+#include "ItemManagerSettings.h"
+#include "utils/ItemManagerMemReport.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Scheduler Tick"), STAT_ItemSchedulerTick, STATGROUP_ItemManager);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Scheduled Requests"), STAT_ItemScheduledRequests, STATGROUP_ItemManager);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Processed Requests"), STAT_ItemProcessedRequests, STATGROUP_ItemManager);
+DECLARE_CYCLE_STAT(TEXT("Item Timers Dispatch"), STAT_ItemTimerDispatch, STATGROUP_ItemManager);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pending Item Timers"), STAT_ItemPendingTimers, STATGROUP_ItemManager);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fired Item Timers"), STAT_ItemFiredTimers, STATGROUP_ItemManager);
+DECLARE_CYCLE_STAT(TEXT("Item Actor Spawn"), STAT_ItemActorSpawn, STATGROUP_ItemManager);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Item Actor Pool Hits"), STAT_ItemActorPoolHits, STATGROUP_ItemManager);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Item Actor Pool Misses"), STAT_ItemActorPoolMisses, STATGROUP_ItemManager);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Item Actors"), STAT_ItemPooledActors, STATGROUP_ItemManager);
+
+static TAutoConsoleVariable<bool> CVarItemSchedulerEnabled(
+    TEXT("ItemManager.Scheduler.Enabled"),
+    true,
+    TEXT("If true, item actors spawns and destroys are queued and processed within a per-frame budget."));
+
+static TAutoConsoleVariable<float> CVarItemSchedulerBudgetMs(
+    TEXT("ItemManager.Scheduler.BudgetMs"),
+    2.f,
+    TEXT("Time in milliseconds the scheduler is allowed to spend each frame. At least one request is processed per frame."));
+
+static TAutoConsoleVariable<int32> CVarItemPoolMaxPerClass(
+    TEXT("ItemManager.Pool.MaxPerClass"),
+    2,
+    TEXT("Number of despawned item actors kept per item class for the next spawns. 0 disables the pool."));
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice ItemPoolStatsCommand(
+    TEXT("ItemManager.Pool.Stats"),
+    TEXT("Print the hits of the item actor pool and the spawn and register costs it saved."),
+    FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+    {
+        UItemManagerSubsystem* ItemManagerSubsystem = World ? World->GetSubsystem<UItemManagerSubsystem>() : nullptr;
+
+        if (!ItemManagerSubsystem)
+        {
+            return;
+        }
+
+        const FItemActorPoolStats& Stats = ItemManagerSubsystem->GetItemActorPoolStats();
+        const double SpawnMicroseconds = Stats.Misses > 0 ? Stats.SpawnSeconds * 1000000.0 / Stats.Misses : 0.0;
+        const double ReuseMicroseconds = Stats.Hits > 0 ? Stats.ReuseSeconds * 1000000.0 / Stats.Hits : 0.0;
+        const double ComponentsPerSpawn = Stats.Misses > 0 ? static_cast<double>(Stats.RegisteredComponents) / Stats.Misses : 0.0;
+
+        Ar.Logf(TEXT("Item actor pool: %d hits, %d misses"), Stats.Hits, Stats.Misses);
+        Ar.Logf(TEXT("  Spawn: %.1f us and %.1f registered components per actor"), SpawnMicroseconds, ComponentsPerSpawn);
+        Ar.Logf(TEXT("  Reuse: %.1f us per actor, no registration"), ReuseMicroseconds);
+        Ar.Logf(TEXT("  Saved: %.2f ms and %d component registrations"),
+            Stats.Hits * FMath::Max(SpawnMicroseconds - ReuseMicroseconds, 0.0) / 1000.0, FMath::RoundToInt(Stats.Hits * ComponentsPerSpawn));
+    }));
+
+static TAutoConsoleVariable<int32> CVarItemServerMode(
+    TEXT("ItemManager.ServerMode"),
+    -1,
+    TEXT("Lean server mode, skipping every visual setup and cosmetic tick of the item actors.\n")
+    TEXT("-1: only on dedicated servers (default)\n")
+    TEXT(" 0: disabled\n")
+    TEXT(" 1: enabled"));
+
+bool UItemManagerSubsystem::IsServerModeEnabled()
+{
+    int32 const ServerMode = CVarItemServerMode.GetValueOnAnyThread();
+    return ServerMode < 0 ? IsRunningDedicatedServer() : ServerMode > 0;
+}
+
+bool UItemManagerSubsystem::IsSchedulerEnabled()
+{
+    return CVarItemSchedulerEnabled.GetValueOnGameThread();
+}
+
+void UItemManagerSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    // does nothing once requested, the request made after engine init may have been skipped
+    UItemManagerSettings::Get()->RequestSharedAssetsPreload();
+}
+
+void UItemManagerSubsystem::Deinitialize()
+{
+    DEC_DWORD_STAT_BY(STAT_ItemScheduledRequests, ScheduledRequests.Num());
+    ScheduledRequests.Empty();
+
+    SET_DWORD_STAT(STAT_ItemPendingTimers, 0);
+
+    // pooled actors go away with the world
+    SET_DWORD_STAT(STAT_ItemPooledActors, 0);
+    PooledItemActors.Empty();
+    PendingPrewarms.Empty();
+
+    Super::Deinitialize();
+}
+
+TStatId UItemManagerSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UItemManagerSubsystem, STATGROUP_Tickables);
+}
+
+FItemTimerHandle UItemManagerSubsystem::ScheduleItemTimer(const FItemTimer& Timer, float Delay)
+{
+    return TimingWheel.Schedule(GetWorld()->GetTimeSeconds(), Delay, Timer);
+}
+
+void UItemManagerSubsystem::CancelItemTimer(FItemTimerHandle& Handle)
+{
+    TimingWheel.Cancel(Handle);
+}
+
+void UItemManagerSubsystem::DispatchItemTimers()
+{
+    SCOPE_CYCLE_COUNTER(STAT_ItemTimerDispatch);
+
+    // game time, paused and dilated like the world timers
+    ExpiredItemTimers.Reset();
+    TimingWheel.Advance(GetWorld()->GetTimeSeconds(), ExpiredItemTimers);
+
+    // a fired timer may cancel the next ones, Consume skips them
+    for (const FItemTimerHandle& Handle : ExpiredItemTimers)
+    {
+        FItemTimer Timer;
+        if (TimingWheel.Consume(Handle, Timer))
+        {
+            if (UItemManagerComponent* Manager = Timer.Manager.Get())
+            {
+                INC_DWORD_STAT(STAT_ItemFiredTimers);
+                Manager->HandleItemTimer(Timer);
+            }
+        }
+    }
+
+    SET_DWORD_STAT(STAT_ItemPendingTimers, TimingWheel.Num());
+}
+
+AItemParent* UItemManagerSubsystem::SpawnItemActor(TSubclassOf<AItemParent> Item, const FTransform& Transform)
+{
+    SCOPE_CYCLE_COUNTER(STAT_ItemActorSpawn);
+
+    const double StartTime = FPlatformTime::Seconds();
+
+    if (TArray<TWeakObjectPtr<AItemParent>>* PooledActors = PooledItemActors.Find(Item))
+    {
+        while (PooledActors->Num() > 0)
+        {
+            AItemParent* ItemActor = PooledActors->Pop(EAllowShrinking::No).Get();
+            DEC_DWORD_STAT(STAT_ItemPooledActors);
+
+            if (!IsValid(ItemActor))
+            {
+                continue;
+            }
+
+            // components stay registered, the dormancy is left by the item manager
+            ItemActor->SetActorTransform(Transform);
+            ItemActor->SetActorHiddenInGame(false);
+            ItemActor->NotifyReused();
+
+            PoolStats.Hits++;
+            PoolStats.ReuseSeconds += FPlatformTime::Seconds() - StartTime;
+            INC_DWORD_STAT(STAT_ItemActorPoolHits);
+
+            return ItemActor;
+        }
+    }
+
+    AItemParent* ItemActor = GetWorld()->SpawnActor<AItemParent>(Item, Transform);
+
+    PoolStats.Misses++;
+    PoolStats.SpawnSeconds += FPlatformTime::Seconds() - StartTime;
+    PoolStats.RegisteredComponents += ItemActor ? ItemActor->GetComponents().Num() : 0;
+    INC_DWORD_STAT(STAT_ItemActorPoolMisses);
+
+    return ItemActor;
+}
+
+void UItemManagerSubsystem::ReleaseItemActor(AItemParent* ItemActor)
+{
+    if (!IsValid(ItemActor))
+    {
+        return;
+    }
+
+    TArray<TWeakObjectPtr<AItemParent>>& PooledActors = PooledItemActors.FindOrAdd(ItemActor->GetClass());
+
+    // destroyed with their level
+    int32 const NumStaleActors = PooledActors.RemoveAll([](const TWeakObjectPtr<AItemParent>& PooledActor)
+    {
+        return !PooledActor.IsValid();
+    });
+    DEC_DWORD_STAT_BY(STAT_ItemPooledActors, NumStaleActors);
+
+    if (PooledActors.Num() >= CVarItemPoolMaxPerClass.GetValueOnGameThread())
+    {
+        EnqueueDestroyActor(ItemActor);
+        return;
+    }
+
+    // kept alive but nothing ticks, collides nor skins
+    ItemActor->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+    ItemActor->SetActorHiddenInGame(true);
+    ItemActor->EnterHolsteredDormancy(true);
+
+    PooledActors.Add(ItemActor);
+    INC_DWORD_STAT(STAT_ItemPooledActors);
+}
+
+void UItemManagerSubsystem::PrewarmItemActors(TSubclassOf<AItemParent> Item, int32 Count)
+{
+    if (!Item || Count <= 0)
+    {
+        return;
+    }
+
+    int32& PendingCount = PendingPrewarms.FindOrAdd(Item);
+    int32 const NumMissingActors = FMath::Min(Count, CVarItemPoolMaxPerClass.GetValueOnGameThread()) - GetNumPooledItemActors(Item) - PendingCount;
+
+    for (int32 ActorIndex = 0; ActorIndex < NumMissingActors; ActorIndex++)
+    {
+        FItemScheduledRequest& Request = AddScheduledRequest(EItemScheduledRequest::SR_PrewarmItemActor);
+        Request.ItemClass = Item;
+
+        PendingCount++;
+        INC_DWORD_STAT(STAT_ItemScheduledRequests);
+    }
+
+    if (NumMissingActors > 0 && !IsSchedulerEnabled())
+    {
+        FlushScheduledRequests();
+    }
+}
+
+int32 UItemManagerSubsystem::GetNumPooledItemActors(TSubclassOf<AItemParent> Item) const
+{
+    const TArray<TWeakObjectPtr<AItemParent>>* PooledActors = PooledItemActors.Find(Item);
+    return PooledActors ? PooledActors->Num() : 0;
+}
+
+bool UItemManagerSubsystem::IsPooledItemActor(const AItemParent* ItemActor) const
+{
+    const TArray<TWeakObjectPtr<AItemParent>>* PooledActors = ItemActor ? PooledItemActors.Find(ItemActor->GetClass()) : nullptr;
+
+    return PooledActors && PooledActors->ContainsByPredicate([ItemActor](const TWeakObjectPtr<AItemParent>& PooledActor)
+    {
+        return PooledActor.Get() == ItemActor;
+    });
+}
+
+void UItemManagerSubsystem::RequestSnapshotPublish(UItemManagerComponent* Manager)
+{
+    SnapshotPublishRequests.Add(Manager);
+}
+
+void UItemManagerSubsystem::PublishInventorySnapshots()
+{
+    for (const TWeakObjectPtr<UItemManagerComponent>& Manager : SnapshotPublishRequests)
+    {
+        // may have been published on a game thread read since
+        if (Manager.IsValid() && Manager->bIsInventorySnapshotDirty)
+        {
+            Manager->PublishInventorySnapshot();
+        }
+    }
+
+    SnapshotPublishRequests.Reset();
+}
+
+void UItemManagerSubsystem::RegisterManager(UItemManagerComponent* Manager)
+{
+    Managers.AddUnique(Manager);
+}
+
+void UItemManagerSubsystem::UnregisterManager(UItemManagerComponent* Manager)
+{
+    Managers.RemoveSwap(Manager);
+}
+
+void UItemManagerSubsystem::UnregisterItemCollectable(AItemCollectable* ItemCollectable)
+{
+    for (const TWeakObjectPtr<UItemManagerComponent>& Manager : Managers)
+    {
+        if (Manager.IsValid())
+        {
+            Manager->UnregisterItemCollectable(ItemCollectable);
+        }
+    }
+}
+
+int32 UItemManagerSubsystem::GetNumVirtualManagers() const
+{
+    int32 NumVirtualManagers = 0;
+
+    for (const TWeakObjectPtr<UItemManagerComponent>& Manager : Managers)
+    {
+        if (Manager.IsValid() && Manager->IsVirtual())
+        {
+            NumVirtualManagers++;
+        }
+    }
+
+    return NumVirtualManagers;
+}
+
+int32 UItemManagerSubsystem::GetNumMaterializedManagers() const
+{
+    int32 NumMaterializedManagers = 0;
+
+    for (const TWeakObjectPtr<UItemManagerComponent>& Manager : Managers)
+    {
+        if (Manager.IsValid() && !Manager->IsVirtual())
+        {
+            NumMaterializedManagers++;
+        }
+    }
+
+    return NumMaterializedManagers;
+}
+
+int32 UItemManagerSubsystem::GetMemoryUsageKB() const
+{
+    return static_cast<int32>(FItemManagerMemReport::Gather(GetWorld()).GetTotalBytes() / 1024);
+}
+
+void UItemManagerSubsystem::EnqueueSpawnCollectable(const TSharedRef<const FItemCollectableData>& ItemCollectableData, const FTransform& Transform, UItemManagerComponent* Requester, const FInstancedStruct& InstanceState)
+{
+    FItemScheduledRequest& Request = AddScheduledRequest(EItemScheduledRequest::SR_SpawnCollectable);
+    Request.ItemCollectableData = ItemCollectableData;
+    Request.InstanceState = InstanceState;
+    Request.Transform = Transform;
+    Request.Requester = Requester;
+
+    INC_DWORD_STAT(STAT_ItemScheduledRequests);
+
+    if (!IsSchedulerEnabled())
+    {
+        FlushScheduledRequests();
+    }
+}
+
+int32 UItemManagerSubsystem::SpawnLoot(UItemLootTable* LootTable, FTransform Origin, float Radius, int32 Seed, FGameplayTagContainer ContextTags)
+{
+    if (!IsValid(LootTable))
+    {
+        return 0;
+    }
+
+    FItemLootBatch Batch;
+    Batch.DrawOffsets.Add(0);
+    LootTable->GenerateLoot(Seed, ContextTags, Batch.Loot);
+    Batch.DrawOffsets.Add(Batch.Loot.Num());
+
+    SpawnLootBatch(Batch, { Origin }, Radius);
+
+    return Batch.Loot.Num();
+}
+
+void UItemManagerSubsystem::SpawnLootBatch(const FItemLootBatch& Batch, const TArray<FTransform>& Origins, float Radius)
+{
+    const int32 NumDraws = FMath::Min(Batch.GetNumDraws(), Origins.Num());
+    ScheduledRequests.Reserve(ScheduledRequests.Num() + (NumDraws > 0 ? Batch.DrawOffsets[NumDraws] : 0));
+
+    for (int32 DrawIndex = 0; DrawIndex < NumDraws; DrawIndex++)
+    {
+        const int32 FirstLoot = Batch.DrawOffsets[DrawIndex];
+        const int32 NumLoot = Batch.DrawOffsets[DrawIndex + 1] - FirstLoot;
+
+        for (int32 LootIndex = 0; LootIndex < NumLoot; LootIndex++)
+        {
+            FTransform Transform = Origins[DrawIndex];
+
+            // evenly spread, a single item stays on the origin
+            if (NumLoot > 1)
+            {
+                const float Angle = 2.f * PI * LootIndex / NumLoot;
+                Transform.AddToTranslation(FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * Radius);
+            }
+
+            const int32 BatchIndex = FirstLoot + LootIndex;
+            EnqueueSpawnCollectable(Batch.Loot[BatchIndex], Transform, nullptr, Batch.InstanceStates.IsValidIndex(BatchIndex) ? Batch.InstanceStates[BatchIndex] : FInstancedStruct());
+        }
+    }
+}
+
+void UItemManagerSubsystem::EnqueueDestroyActor(AActor* Actor)
+{
+    if (!IsValid(Actor))
+    {
+        return;
+    }
+
+    // the actor disappears right away, the visuals only catch up later
+    Actor->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+    Actor->SetActorHiddenInGame(true);
+    Actor->SetActorEnableCollision(false);
+    Actor->SetActorTickEnabled(false);
+
+    FItemScheduledRequest& Request = AddScheduledRequest(EItemScheduledRequest::SR_DestroyActor);
+    Request.Actor = Actor;
+
+    INC_DWORD_STAT(STAT_ItemScheduledRequests);
+
+    if (!IsSchedulerEnabled())
+    {
+        FlushScheduledRequests();
+    }
+}
+
+FItemScheduledRequest& UItemManagerSubsystem::AddScheduledRequest(EItemScheduledRequest Type)
+{
+    FItemScheduledRequest& Request = ScheduledRequests.AddDefaulted_GetRef();
+    Request.Type = Type;
+    Request.Sequence = NextRequestSequence++;
+
+    return Request;
+}
+
+void UItemManagerSubsystem::FlushScheduledRequests()
+{
+    // requests may be queued while processing (e.g. a collectable spawning another one)
+    while (ScheduledRequests.Num() > 0)
+    {
+        TArray<FItemScheduledRequest> Requests = MoveTemp(ScheduledRequests);
+        ScheduledRequests.Reset();
+        DEC_DWORD_STAT_BY(STAT_ItemScheduledRequests, Requests.Num());
+
+        for (FItemScheduledRequest& Request : Requests)
+        {
+            ProcessRequest(Request);
+        }
+    }
+}
+
+static bool ScheduledRequestLess(const FItemScheduledRequest& A, const FItemScheduledRequest& B)
+{
+    return A.Priority < B.Priority || (A.Priority == B.Priority && A.Sequence < B.Sequence);
+}
+
+void UItemManagerSubsystem::Tick(float DeltaTime)
+{
+    SCOPE_CYCLE_COUNTER(STAT_ItemSchedulerTick);
+
+    DispatchItemTimers();
+    PublishInventorySnapshots();
+
+    EventBus.FlushCoalescedEvents();
+
+    if (ScheduledRequests.Num() <= 0)
+    {
+        return;
+    }
+
+    UpdatePriorities();
+
+    // detached like FlushScheduledRequests, processing may queue or flush requests
+    TArray<FItemScheduledRequest> Requests = MoveTemp(ScheduledRequests);
+    ScheduledRequests.Reset();
+
+    // closest to the players first, only the requests processed this frame are ordered
+    Requests.Heapify(ScheduledRequestLess);
+
+    const double BudgetSeconds = CVarItemSchedulerBudgetMs.GetValueOnGameThread() / 1000.0;
+    const double StartTime = FPlatformTime::Seconds();
+    int32 ProcessedCount = 0;
+
+    while (Requests.Num() > 0)
+    {
+        FItemScheduledRequest Request;
+        Requests.HeapPop(Request, ScheduledRequestLess, EAllowShrinking::No);
+        ProcessedCount++;
+
+        ProcessRequest(Request);
+
+        if (FPlatformTime::Seconds() - StartTime >= BudgetSeconds)
+        {
+            break;
+        }
+    }
+
+    // left for the next frame with the requests queued meanwhile, the sequence keeps their order
+    Requests.Append(MoveTemp(ScheduledRequests));
+    ScheduledRequests = MoveTemp(Requests);
+
+    DEC_DWORD_STAT_BY(STAT_ItemScheduledRequests, ProcessedCount);
+    INC_DWORD_STAT_BY(STAT_ItemProcessedRequests, ProcessedCount);
+}
+
+void UItemManagerSubsystem::UpdatePriorities()
+{
+    TArray<FVector, TInlineAllocator<8>> ViewLocations;
+
+    for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+    {
+        const APlayerController* PlayerController = Iterator->Get();
+
+        if (PlayerController)
+        {
+            FVector ViewLocation;
+            FRotator ViewRotation;
+            PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+            ViewLocations.Add(ViewLocation);
+        }
+    }
+
+    for (FItemScheduledRequest& Request : ScheduledRequests)
+    {
+        FVector Location = Request.Transform.GetLocation();
+
+        if (Request.Type == EItemScheduledRequest::SR_DestroyActor && Request.Actor.IsValid())
+        {
+            Location = Request.Actor->GetActorLocation();
+        }
+
+        Request.Priority = ViewLocations.Num() > 0 ? MAX_flt : 0.f;
+
+        for (const FVector& ViewLocation : ViewLocations)
+        {
+            Request.Priority = FMath::Min(Request.Priority, static_cast<float>(FVector::DistSquared(Location, ViewLocation)));
+        }
+    }
+}
+
+void UItemManagerSubsystem::ProcessRequest(FItemScheduledRequest& Request)
+{
+    if (Request.Type == EItemScheduledRequest::SR_DestroyActor)
+    {
+        if (Request.Actor.IsValid())
+        {
+            Request.Actor->Destroy();
+        }
+        return;
+    }
+
+    if (Request.Type == EItemScheduledRequest::SR_PrewarmItemActor)
+    {
+        if (int32* PendingCount = PendingPrewarms.Find(Request.ItemClass))
+        {
+            *PendingCount = FMath::Max(*PendingCount - 1, 0);
+        }
+
+        // spawned hidden, straight into the pool
+        ReleaseItemActor(GetWorld()->SpawnActor<AItemParent>(Request.ItemClass, Request.Transform));
+        return;
+    }
+
+    AItemCollectable* ItemCollectable = GetWorld()->SpawnActorDeferred<AItemCollectable>(AItemCollectable::StaticClass(), Request.Transform);
+
+    if (ItemCollectable)
+    {
+        ItemCollectable->Init(*Request.ItemCollectableData);
+        ItemCollectable->SetInstanceState(Request.InstanceState);
+        ItemCollectable->FinishSpawning(Request.Transform);
+
+        if (Request.Requester.IsValid())
+        {
+            Request.Requester->RegisterItemCollectable(ItemCollectable);
+        }
+        else
+        {
+            // world loot can be picked up by anyone
+            for (const TWeakObjectPtr<UItemManagerComponent>& Manager : Managers)
+            {
+                if (Manager.IsValid())
+                {
+                    Manager->RegisterItemCollectable(ItemCollectable);
+                }
+            }
+        }
+    }
+    else
+    {
+        UE_LOG(ItemManager, Warning, TEXT("Failed to spawn ItemCollectable"));
+    }
+}
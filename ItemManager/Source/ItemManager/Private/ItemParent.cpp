@@ -2,6 +2,10 @@
 
 #include "ItemParent.h"
 #include "ItemManagerComponent.h"
+#include "ItemManagerStats.h"
+#include "Components/SkeletalMeshComponent.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Holstered Dormant Items"), STAT_ItemHolsteredDormantItems, STATGROUP_ItemManager);
 
 
 // Sets default values
@@ -17,11 +21,11 @@ AItemParent::AItemParent()
 
 void AItemParent::UseItem(UItemManagerComponent* ItemManagerComponent)
 {
-	if(ItemManagerComponent->GetCurrentItem().Item.GetDefaultObject()->StaticClass() == this->StaticClass())
+	if(ItemManagerComponent->GetCurrentItemActor() == this)
 	{
 		if(bCanBeUsed)
 		{
-			UE_LOG(ItemManager, Display, TEXT("Using item"));
+			UE_LOG(ItemManager, Verbose, TEXT("Using item"));
 			OnItemUsed_BP();
 			OnItemUsed();
 		}
@@ -41,6 +45,43 @@ void AItemParent::UseItem(UItemManagerComponent* ItemManagerComponent)
 
 
 
+void AItemParent::ProcessUses(int32 NumUses)
+{
+	if (!bAreUseEventsCached)
+	{
+		bImplementsOnItemUsed_BP = GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(AItemParent, OnItemUsed_BP));
+		bImplementsOnItemUsedBatch_BP = GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(AItemParent, OnItemUsedBatch_BP));
+		bAreUseEventsCached = true;
+	}
+
+	if (!bCanBeUsed)
+	{
+		CannotUseItem_BP();
+		CannotUseItem();
+		return;
+	}
+
+	OnItemUsedBatch(NumUses);
+
+	if (bImplementsOnItemUsedBatch_BP)
+	{
+		OnItemUsedBatch_BP(NumUses);
+	}
+}
+
+void AItemParent::OnItemUsedBatch(int32 NumUses)
+{
+	for (int32 UseIndex = 0; UseIndex < NumUses; UseIndex++)
+	{
+		if (bImplementsOnItemUsed_BP)
+		{
+			OnItemUsed_BP();
+		}
+
+		OnItemUsed();
+	}
+}
+
 void AItemParent::OnItemUsed()
 {
 }
@@ -49,6 +90,105 @@ void AItemParent::CannotUseItem()
 {
 }
 
+void AItemParent::EnterHolsteredDormancy(bool bForce)
+{
+	if (bIsHolsteredDormant)
+	{
+		// a holstered item at its forced LOD still updates its pose, once hidden it no longer has to
+		if (bForce && bIsAtHolsteredForcedLOD)
+		{
+			bIsAtHolsteredForcedLOD = false;
+			SkeletalMesh->SetForcedLOD(PreviousForcedLOD);
+			SkeletalMesh->SetComponentTickEnabled(false);
+			SkeletalMesh->bNoSkeletonUpdate = true;
+		}
+
+		return;
+	}
+
+	if (!bEnableHolsteredDormancy && !bForce)
+	{
+		return;
+	}
+
+	bIsHolsteredDormant = true;
+	INC_DWORD_STAT(STAT_ItemHolsteredDormantItems);
+
+	bWasActorTickEnabled = IsActorTickEnabled();
+	bWasCollisionEnabled = GetActorEnableCollision();
+	SetActorTickEnabled(false);
+	SetActorEnableCollision(false);
+
+	if (SkeletalMesh)
+	{
+		bWasMeshTickEnabled = SkeletalMesh->IsComponentTickEnabled();
+		bWasGeneratingOverlapEvents = SkeletalMesh->GetGenerateOverlapEvents();
+		bWasSkeletonUpdateDisabled = SkeletalMesh->bNoSkeletonUpdate;
+		PreviousForcedLOD = SkeletalMesh->GetForcedLOD();
+
+		SkeletalMesh->SetGenerateOverlapEvents(false);
+
+		if (HolsteredForcedLOD > 0 && !bForce)
+		{
+			// keep a cheap pose update, the item stays visible on its socket. Both are 1 based, 0 is no forced LOD.
+			SkeletalMesh->SetForcedLOD(HolsteredForcedLOD);
+			bIsAtHolsteredForcedLOD = true;
+		}
+		else
+		{
+			SkeletalMesh->SetComponentTickEnabled(false);
+			SkeletalMesh->bNoSkeletonUpdate = true;
+		}
+	}
+
+	OnEnterHolsteredDormancy_BP();
+	OnEnterHolsteredDormancy();
+}
+
+void AItemParent::ExitHolsteredDormancy()
+{
+	if (!bIsHolsteredDormant)
+	{
+		return;
+	}
+
+	bIsHolsteredDormant = false;
+	bIsAtHolsteredForcedLOD = false;
+	DEC_DWORD_STAT(STAT_ItemHolsteredDormantItems);
+
+	SetActorTickEnabled(bWasActorTickEnabled);
+	SetActorEnableCollision(bWasCollisionEnabled);
+
+	if (SkeletalMesh)
+	{
+		SkeletalMesh->SetGenerateOverlapEvents(bWasGeneratingOverlapEvents);
+		SkeletalMesh->SetForcedLOD(PreviousForcedLOD);
+		SkeletalMesh->bNoSkeletonUpdate = bWasSkeletonUpdateDisabled;
+		SkeletalMesh->SetComponentTickEnabled(bWasMeshTickEnabled);
+	}
+
+	OnExitHolsteredDormancy_BP();
+	OnExitHolsteredDormancy();
+}
+
+void AItemParent::OnEnterHolsteredDormancy()
+{
+}
+
+void AItemParent::OnExitHolsteredDormancy()
+{
+}
+
+void AItemParent::NotifyReused()
+{
+	OnItemReused_BP();
+	OnItemReused();
+}
+
+void AItemParent::OnItemReused()
+{
+}
+
 // Called when the game starts or when spawned
 void AItemParent::BeginPlay()
 {
@@ -56,6 +196,16 @@ void AItemParent::BeginPlay()
 	
 }
 
+void AItemParent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (bIsHolsteredDormant)
+	{
+		DEC_DWORD_STAT(STAT_ItemHolsteredDormantItems);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
 // Called every frame
 void AItemParent::Tick(float DeltaTime)
 {
@@ -0,0 +1,199 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+
+#include "utils/ItemCollectableAuditCommandlet.h"
+#include "ItemCollectable.h"
+#include "ItemManagerComponent.h"
+#include "EngineUtils.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+
+namespace ItemCollectableAudit
+{
+	// rough per-frame costs, calibrate them on the target hardware with ItemManager.Collectables.TickCost
+	struct FCostModel
+	{
+		float ActorTickUs = 1.f;
+		float MeshTickUs = 1.5f;
+		float PhysicsUs = 3.f;
+	};
+
+	static TArray<FString> FindMaps(const FString& Params)
+	{
+		TArray<FString> Maps;
+		FString MapList;
+
+		if (FParse::Value(*Params, TEXT("Maps="), MapList, false))
+		{
+			MapList.ParseIntoArray(Maps, TEXT("+"));
+			return Maps;
+		}
+
+		TArray<FString> Files;
+		FPackageName::FindPackagesInDirectory(Files, FPaths::ProjectContentDir());
+
+		for (const FString& File : Files)
+		{
+			FString PackageName;
+
+			if (FPaths::GetExtension(File, true) == FPackageName::GetMapPackageExtension() && FPackageName::TryConvertFilenameToLongPackageName(File, PackageName))
+			{
+				Maps.Add(PackageName);
+			}
+		}
+
+		Maps.Sort();
+		return Maps;
+	}
+
+	static FString AuditCollectable(const FString& MapName, AItemCollectable* ItemCollectable, const FCostModel& CostModel)
+	{
+		USkeletalMeshComponent* Mesh = ItemCollectable->GetSkeletalMesh();
+		USkeletalMesh* MeshAsset = Mesh ? Mesh->GetSkeletalMeshAsset() : nullptr;
+
+		const EItemDisplay ItemDisplay = ItemCollectable->GetItemDisplay();
+		const bool bIsPhysics = ItemDisplay == EItemDisplay::ID_Physics;
+		const bool bHasCollisions = bIsPhysics || ItemCollectable->AreCollisionsEnabled();
+
+		// only the animated display uses the actor tick, the mesh ticks as soon as it has an asset
+		const bool bTicksActor = ItemDisplay == EItemDisplay::ID_Animated;
+		const bool bTicksMesh = MeshAsset && Mesh->PrimaryComponentTick.bCanEverTick && Mesh->PrimaryComponentTick.bStartWithTickEnabled;
+		const bool bIsMissingPhysicsAsset = bIsPhysics && MeshAsset && !MeshAsset->GetPhysicsAsset();
+
+		const float EstimatedCostUs = (bTicksActor ? CostModel.ActorTickUs : 0.f) + (bTicksMesh ? CostModel.MeshTickUs : 0.f) + (bIsPhysics ? CostModel.PhysicsUs : 0.f);
+
+		if (!MeshAsset)
+		{
+			UE_LOG(ItemManager, Warning, TEXT("%s: %s has no mesh"), *MapName, *ItemCollectable->GetName());
+		}
+
+		if (bIsMissingPhysicsAsset)
+		{
+			UE_LOG(ItemManager, Warning, TEXT("%s: %s simulates physics without physics asset (%s)"), *MapName, *ItemCollectable->GetName(), *MeshAsset->GetPathName());
+		}
+
+		return FString::Printf(TEXT("%s,%s,%s,%s,%d,%d,%d,%d,%s,%d,%d,%d,%d,%.2f\n"),
+			*MapName,
+			*ItemCollectable->GetName(),
+			*GetPathNameSafe(ItemCollectable->GetItem().Get()),
+			*StaticEnum<EItemDisplay>()->GetNameStringByValue(static_cast<int64>(ItemDisplay)),
+			bHasCollisions,
+			bIsPhysics,
+			bTicksActor,
+			bTicksMesh,
+			*GetPathNameSafe(MeshAsset),
+			bIsMissingPhysicsAsset,
+			ItemCollectable->IsOutlineEnabled(),
+			ItemCollectable->IsTransparencyEnabled(),
+			ItemCollectable->HasBakedPlacement(),
+			EstimatedCostUs);
+	}
+}
+
+UItemCollectableAuditCommandlet::UItemCollectableAuditCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UItemCollectableAuditCommandlet::Main(const FString& Params)
+{
+	ItemCollectableAudit::FCostModel CostModel;
+	FParse::Value(*Params, TEXT("ActorTickUs="), CostModel.ActorTickUs);
+	FParse::Value(*Params, TEXT("MeshTickUs="), CostModel.MeshTickUs);
+	FParse::Value(*Params, TEXT("PhysicsUs="), CostModel.PhysicsUs);
+
+	FString CsvPath = FPaths::ProfilingDir() / TEXT("ItemManager") / TEXT("CollectableAudit.csv");
+	FParse::Value(*Params, TEXT("Csv="), CsvPath);
+
+	const bool bBake = FParse::Param(*Params, TEXT("Bake"));
+
+#if !WITH_EDITOR
+	if (bBake)
+	{
+		UE_LOG(ItemManager, Error, TEXT("Baking requires an editor build"));
+		return 1;
+	}
+#endif
+
+	FString Csv = TEXT("Map,Actor,Item,Display,Collisions,Physics,TicksActor,TicksMesh,Mesh,MissingPhysicsAsset,Outline,Transparency,Baked,EstimatedCostUs\n");
+	int32 NumCollectables = 0;
+	int32 NumBakedCollectables = 0;
+	bool bSucceeded = true;
+
+	for (const FString& MapName : ItemCollectableAudit::FindMaps(Params))
+	{
+		UPackage* Package = LoadPackage(nullptr, *MapName, LOAD_None);
+		UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+
+		if (!World)
+		{
+			UE_LOG(ItemManager, Error, TEXT("Cannot load %s"), *MapName);
+			bSucceeded = false;
+			continue;
+		}
+
+		// the ground traces need the collisions of the level
+		World->InitWorld(UWorld::InitializationValues()
+			.AllowAudioPlayback(false)
+			.RequiresHitProxies(false)
+			.CreateNavigation(false)
+			.CreateAISystem(false)
+			.ShouldSimulatePhysics(false)
+			.SetTransactional(false));
+		World->UpdateWorldComponents(true, false);
+
+		int32 NumMapCollectables = 0;
+
+		for (TActorIterator<AItemCollectable> It(World); It; ++It)
+		{
+			if (bBake)
+			{
+				It->BakePlacement();
+				NumBakedCollectables++;
+			}
+
+			Csv += ItemCollectableAudit::AuditCollectable(MapName, *It, CostModel);
+			NumMapCollectables++;
+		}
+
+		NumCollectables += NumMapCollectables;
+		UE_LOG(ItemManager, Display, TEXT("%s: %d collectables"), *MapName, NumMapCollectables);
+
+#if WITH_EDITOR
+		if (bBake && NumMapCollectables > 0)
+		{
+			const FString Filename = FPackageName::LongPackageNameToFilename(MapName, FPackageName::GetMapPackageExtension());
+
+			FSavePackageArgs SaveArgs;
+			SaveArgs.TopLevelFlags = RF_Standalone;
+
+			if (IFileManager::Get().IsReadOnly(*Filename) || !UPackage::SavePackage(Package, World, *Filename, SaveArgs))
+			{
+				UE_LOG(ItemManager, Error, TEXT("Cannot save %s, check it out first"), *Filename);
+				bSucceeded = false;
+			}
+		}
+#endif
+
+		World->CleanupWorld();
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	if (!FFileHelper::SaveStringToFile(Csv, *CsvPath))
+	{
+		UE_LOG(ItemManager, Error, TEXT("Cannot write %s"), *CsvPath);
+		return 1;
+	}
+
+	UE_LOG(ItemManager, Display, TEXT("%d collectables audited, %d baked. Report saved to %s"), NumCollectables, NumBakedCollectables, *CsvPath);
+
+	return bSucceeded ? 0 : 1;
+}
@@ -0,0 +1,26 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ItemCollectableAuditCommandlet.generated.h"
+
+/**
+ * List every ItemCollectable of the levels with its display, collision and tick settings and an estimated per-frame cost.
+ * Usage: UnrealEditor-Cmd <Project> -run=ItemCollectableAudit [-Maps=/Game/A+/Game/B] [-Csv=File] [-Bake]
+ *        [-ActorTickUs=] [-MeshTickUs=] [-PhysicsUs=]
+ * Without -Maps, every level of the project content is audited.
+ * -Bake resolves the mesh and the ground placement of the collectables and saves the levels, see AItemCollectable::BakePlacement.
+ */
+UCLASS()
+class UItemCollectableAuditCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UItemCollectableAuditCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
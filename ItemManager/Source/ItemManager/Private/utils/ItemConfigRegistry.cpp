@@ -0,0 +1,305 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+
+#include "utils/ItemConfigRegistry.h"
+#include "HAL/IConsoleManager.h"
+
+namespace ItemConfigRegistry
+{
+	uint32 HashTransform(const FTransform& Transform)
+	{
+		const FQuat Rotation = Transform.GetRotation();
+		uint32 Hash = GetTypeHash(Transform.GetTranslation());
+		Hash = HashCombine(Hash, GetTypeHash(Transform.GetScale3D()));
+		Hash = HashCombine(Hash, GetTypeHash(FVector4(Rotation.X, Rotation.Y, Rotation.Z, Rotation.W)));
+		return Hash;
+	}
+
+	uint32 HashSocket(const FItemSocket& Socket)
+	{
+		return HashCombine(GetTypeHash(Socket.ItemSocket), GetTypeHash(Socket.AttachementRules));
+	}
+
+	bool AreSocketsEqual(const FItemSocket& A, const FItemSocket& B)
+	{
+		return A.ItemSocket == B.ItemSocket && A.AttachementRules == B.AttachementRules;
+	}
+
+	uint32 Hash(const FItemInfos& ItemInfos)
+	{
+		uint32 Hash = GetTypeHash(ItemInfos.FriendlyName);
+		Hash = HashCombine(Hash, HashSocket(ItemInfos.ItemAttachSocket));
+		Hash = HashCombine(Hash, HashSocket(ItemInfos.ItemDetachSocket));
+		Hash = HashCombine(Hash, HashTransform(ItemInfos.SpawnRelativeTransform));
+		Hash = HashCombine(Hash, GetTypeHash(ItemInfos.TimeBeforeDespawn));
+		Hash = HashCombine(Hash, GetTypeHash(ItemInfos.TimeBeforeSpawn));
+		Hash = HashCombine(Hash, GetTypeHash(ItemInfos.bIsDropable));
+		return Hash;
+	}
+
+	bool AreEqual(const FItemInfos& A, const FItemInfos& B)
+	{
+		return A.FriendlyName.Equals(B.FriendlyName, ESearchCase::CaseSensitive)
+			&& AreSocketsEqual(A.ItemAttachSocket, B.ItemAttachSocket)
+			&& AreSocketsEqual(A.ItemDetachSocket, B.ItemDetachSocket)
+			&& A.SpawnRelativeTransform.Equals(B.SpawnRelativeTransform, 0.0)
+			&& A.TimeBeforeDespawn == B.TimeBeforeDespawn
+			&& A.TimeBeforeSpawn == B.TimeBeforeSpawn
+			&& A.bIsDropable == B.bIsDropable;
+	}
+
+	uint32 Hash(const FItemCollectableData& Data)
+	{
+		uint32 Hash = GetTypeHash(Data.Item.Get());
+		Hash = HashCombine(Hash, GetTypeHash(Data.Size));
+		Hash = HashCombine(Hash, GetTypeHash(Data.ItemDisplay));
+		Hash = HashCombine(Hash, GetTypeHash(Data.GroundTypeProperties.GroundRotationType));
+		Hash = HashCombine(Hash, GetTypeHash(Data.GroundTypeProperties.MaxHeight));
+		Hash = HashCombine(Hash, GetTypeHash(Data.AnimatedItemProperties.Height));
+		Hash = HashCombine(Hash, GetTypeHash(Data.AnimatedItemProperties.RotationSpeed));
+		Hash = HashCombine(Hash, GetTypeHash(Data.OutlineMaterial));
+		Hash = HashCombine(Hash, (Data.bEnableCollisions ? 1u : 0u) | (Data.bEnableTransparency ? 2u : 0u) | (Data.bEnableOutline ? 4u : 0u));
+		return Hash;
+	}
+
+	bool AreEqual(const FItemCollectableData& A, const FItemCollectableData& B)
+	{
+		return A.Item == B.Item
+			&& A.Size == B.Size
+			&& A.ItemDisplay == B.ItemDisplay
+			&& A.GroundTypeProperties.GroundRotationType == B.GroundTypeProperties.GroundRotationType
+			&& A.GroundTypeProperties.UseItemWidthInstead == B.GroundTypeProperties.UseItemWidthInstead
+			&& A.GroundTypeProperties.MaxHeight == B.GroundTypeProperties.MaxHeight
+			&& A.GroundTypeProperties.AdjustedRotator == B.GroundTypeProperties.AdjustedRotator
+			&& A.GroundTypeProperties.bInvertGroundRotation == B.GroundTypeProperties.bInvertGroundRotation
+			&& A.AnimatedItemProperties.Height == B.AnimatedItemProperties.Height
+			&& A.AnimatedItemProperties.HeightSpeed == B.AnimatedItemProperties.HeightSpeed
+			&& A.AnimatedItemProperties.RotationSpeed == B.AnimatedItemProperties.RotationSpeed
+			&& A.bEnableCollisions == B.bEnableCollisions
+			&& A.bEnableTransparency == B.bEnableTransparency
+			&& A.bEnableOutline == B.bEnableOutline
+			&& A.OutlineMaterial == B.OutlineMaterial;
+	}
+
+	int64 GetRecordSize(const FItemInfos& ItemInfos)
+	{
+		return sizeof(FItemInfos) + ItemInfos.FriendlyName.GetAllocatedSize();
+	}
+
+	int64 GetRecordSize(const FItemCollectableData& Data)
+	{
+		return sizeof(FItemCollectableData);
+	}
+
+	template<typename T>
+	TSharedRef<const T> Intern(TMultiMap<uint32, TSharedRef<const T>>& Records, const T& Value)
+	{
+		const uint32 ValueHash = Hash(Value);
+
+		for (auto It = Records.CreateConstKeyIterator(ValueHash); It; ++It)
+		{
+			if (AreEqual(*It.Value(), Value))
+			{
+				return It.Value();
+			}
+		}
+
+		TSharedRef<const T> Record = MakeShared<const T>(Value);
+		Records.Add(ValueHash, Record);
+		return Record;
+	}
+
+	template<typename T>
+	void Prune(TMultiMap<uint32, TSharedRef<const T>>& Records)
+	{
+		// a record only referenced by the registry is not used by any slot
+		for (auto It = Records.CreateIterator(); It; ++It)
+		{
+			if (It.Value().GetSharedReferenceCount() <= 1)
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	template<typename T>
+	void DumpTable(FOutputDevice& Ar, const TCHAR* Name, const TMultiMap<uint32, TSharedRef<const T>>& Records, const TMap<TWeakObjectPtr<UClass>, TSharedRef<const T>>& RecordsByClass)
+	{
+		TSet<const T*> ClassRecords;
+		for (const TPair<TWeakObjectPtr<UClass>, TSharedRef<const T>>& Pair : RecordsByClass)
+		{
+			ClassRecords.Add(&Pair.Value.Get());
+		}
+
+		int64 UsedRecords = 0;
+		int64 References = 0;
+		int64 SharedSize = 0;
+		int64 UnsharedSize = 0;
+
+		for (const TPair<uint32, TSharedRef<const T>>& Pair : Records)
+		{
+			const int64 RecordSize = GetRecordSize(Pair.Value.Get());
+			const int64 RecordReferences = Pair.Value.GetSharedReferenceCount() - 1 - (ClassRecords.Contains(&Pair.Value.Get()) ? 1 : 0);
+
+			if (RecordReferences > 0)
+			{
+				UsedRecords++;
+				References += RecordReferences;
+				SharedSize += RecordSize;
+				UnsharedSize += RecordSize * RecordReferences;
+			}
+		}
+
+		Ar.Logf(TEXT("%s: %d records (%lld used), %lld slot references, %lld bytes shared instead of %lld bytes, %lld bytes saved"),
+			Name, Records.Num(), UsedRecords, References, SharedSize, UnsharedSize, UnsharedSize - SharedSize);
+	}
+}
+
+static FAutoConsoleCommandWithOutputDevice ItemManagerConfigStatsCommand(
+	TEXT("ItemManager.ConfigStats"),
+	TEXT("Log the shared item config records and the memory saved by sharing them."),
+	FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar)
+	{
+		FItemConfigRegistry::Get().Prune();
+		FItemConfigRegistry::Get().DumpStats(Ar);
+	}));
+
+FItemConfigRegistry& FItemConfigRegistry::Get()
+{
+	static FItemConfigRegistry Registry;
+	return Registry;
+}
+
+TSharedRef<const FItemInfos> FItemConfigRegistry::Intern(const FItemInfos& ItemInfos)
+{
+	check(IsInGameThread());
+
+	// keep the tables from growing with released records
+	if (ItemInfosTable.Records.Num() > 2 * ItemInfosTable.NumRecordsAtLastPrune + 64)
+	{
+		ItemConfigRegistry::Prune(ItemInfosTable.Records);
+		ItemInfosTable.NumRecordsAtLastPrune = ItemInfosTable.Records.Num();
+	}
+
+	return ItemConfigRegistry::Intern(ItemInfosTable.Records, ItemInfos);
+}
+
+TSharedRef<const FItemCollectableData> FItemConfigRegistry::Intern(const FItemCollectableData& ItemCollectableData)
+{
+	check(IsInGameThread());
+
+	if (ItemCollectableDataTable.Records.Num() > 2 * ItemCollectableDataTable.NumRecordsAtLastPrune + 64)
+	{
+		ItemConfigRegistry::Prune(ItemCollectableDataTable.Records);
+		ItemCollectableDataTable.NumRecordsAtLastPrune = ItemCollectableDataTable.Records.Num();
+	}
+
+	return ItemConfigRegistry::Intern(ItemCollectableDataTable.Records, ItemCollectableData);
+}
+
+TSharedRef<const FItemInfos> FItemConfigRegistry::GetItemInfos(TSubclassOf<AItemParent> Item)
+{
+	if (const TSharedRef<const FItemInfos>* Record = ItemInfosByClass.Find(Item.Get()))
+	{
+		return *Record;
+	}
+
+	FItemInfos ItemInfos;
+	if (Item)
+	{
+		ItemInfos = Item.GetDefaultObject()->GetItemInfos();
+	}
+
+	return ItemInfosByClass.Add(Item.Get(), Intern(ItemInfos));
+}
+
+TSharedRef<const FItemCollectableData> FItemConfigRegistry::GetItemCollectableData(TSubclassOf<AItemParent> Item)
+{
+	if (const TSharedRef<const FItemCollectableData>* Record = ItemCollectableDataByClass.Find(Item.Get()))
+	{
+		return *Record;
+	}
+
+	FItemCollectableData ItemCollectableData;
+	ItemCollectableData.Item = Item;
+
+	return ItemCollectableDataByClass.Add(Item.Get(), Intern(ItemCollectableData));
+}
+
+void FItemConfigRegistry::InvalidateClassRecords(const UClass* ItemClass)
+{
+	check(IsInGameThread());
+
+	if (!ItemClass)
+	{
+		ItemInfosByClass.Reset();
+		ItemCollectableDataByClass.Reset();
+		return;
+	}
+
+	for (auto It = ItemInfosByClass.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid() || It.Key()->IsChildOf(ItemClass))
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	for (auto It = ItemCollectableDataByClass.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid() || It.Key()->IsChildOf(ItemClass))
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void FItemConfigRegistry::Prune()
+{
+	for (auto It = ItemInfosByClass.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	for (auto It = ItemCollectableDataByClass.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	ItemConfigRegistry::Prune(ItemInfosTable.Records);
+	ItemConfigRegistry::Prune(ItemCollectableDataTable.Records);
+	ItemInfosTable.NumRecordsAtLastPrune = ItemInfosTable.Records.Num();
+	ItemCollectableDataTable.NumRecordsAtLastPrune = ItemCollectableDataTable.Records.Num();
+}
+
+void FItemConfigRegistry::DumpStats(FOutputDevice& Ar) const
+{
+	ItemConfigRegistry::DumpTable(Ar, TEXT("Item Infos"), ItemInfosTable.Records, ItemInfosByClass);
+	ItemConfigRegistry::DumpTable(Ar, TEXT("Item Collectable Data"), ItemCollectableDataTable.Records, ItemCollectableDataByClass);
+}
+
+int64 FItemConfigRegistry::GetAllocatedSize() const
+{
+	return ItemInfosTable.Records.GetAllocatedSize() + ItemInfosTable.Records.Num() * sizeof(FItemInfos)
+		+ ItemCollectableDataTable.Records.GetAllocatedSize() + ItemCollectableDataTable.Records.Num() * sizeof(FItemCollectableData)
+		+ ItemInfosByClass.GetAllocatedSize() + ItemCollectableDataByClass.GetAllocatedSize();
+}
+
+void FItemConfigRegistry::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	// records keep their item class and outline material alive
+	for (const TPair<uint32, TSharedRef<const FItemCollectableData>>& Pair : ItemCollectableDataTable.Records)
+	{
+		UClass* ItemClass = Pair.Value->Item.Get();
+		UMaterialInstance* OutlineMaterial = Pair.Value->OutlineMaterial;
+
+		Collector.AddReferencedObject(ItemClass);
+		Collector.AddReferencedObject(OutlineMaterial);
+	}
+}
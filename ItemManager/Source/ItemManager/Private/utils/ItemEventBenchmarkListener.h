@@ -0,0 +1,22 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "ItemManagerComponent.h"
+#include "ItemEventBenchmarkListener.generated.h"
+
+// Blueprint delegate listener used to compare the dynamic delegates with FItemManagerEventBus
+UCLASS(Transient)
+class UItemEventBenchmarkListener : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	int32 NumReceivedEvents = 0;
+
+	UFUNCTION()
+	void OnItemSpawned(FItemObject SpawnedItem) { NumReceivedEvents++; }
+};
@@ -0,0 +1,137 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+
+#include "ItemManagerComponent.h"
+#include "utils/ItemManagerBenchmarkFixture.h"
+#include "Tasks/Task.h"
+#include "HAL/IConsoleManager.h"
+
+class FItemInventorySnapshotBenchmark
+{
+public:
+
+	static void Run(UWorld* World, int32 NumReaders, float Seconds, int32 MaxItems, FOutputDevice& Ar)
+	{
+		// no item actor, only the inventory traffic is measured
+		UItemManagerComponent* Manager = ItemManagerBenchmarkFixture::SpawnManager(World);
+		if (!Manager)
+		{
+			Ar.Logf(TEXT("Cannot spawn the benchmark actor"));
+			return;
+		}
+
+		// both ways to hand the inventory to a task are measured on the same full inventory
+		ItemManagerBenchmarkFixture::FillInventory(Manager, MaxItems, { AItemParent::StaticClass() });
+
+		// the former way: copy the items
+		const int32 NumCalls = 10000;
+		double StartTime = FPlatformTime::Seconds();
+		int32 NumCopiedItems = 0;
+		for (int32 CallIndex = 0; CallIndex < NumCalls; CallIndex++)
+		{
+			NumCopiedItems += Manager->GetItems().Num();
+		}
+		const double CopySeconds = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		int32 NumSnapshotItems = 0;
+		for (int32 CallIndex = 0; CallIndex < NumCalls; CallIndex++)
+		{
+			NumSnapshotItems += Manager->GetInventorySnapshot()->Slots.Num();
+		}
+		const double SnapshotSeconds = FPlatformTime::Seconds() - StartTime;
+
+		std::atomic<bool> bStopReaders{ false };
+		std::atomic<int64> NumReads{ 0 };
+		std::atomic<int32> NumInconsistentReads{ 0 };
+
+		TArray<UE::Tasks::FTask> Readers;
+		for (int32 ReaderIndex = 0; ReaderIndex < NumReaders; ReaderIndex++)
+		{
+			Readers.Add(UE::Tasks::Launch(UE_SOURCE_LOCATION, [Manager, &bStopReaders, &NumReads, &NumInconsistentReads]()
+			{
+				int64 ReaderReads = 0;
+				int32 LastVersion = 0;
+
+				while (!bStopReaders.load(std::memory_order_relaxed))
+				{
+					FItemInventorySnapshotPtr Snapshot = Manager->GetInventorySnapshot();
+
+					// a snapshot is never torn nor older than the previous one
+					const bool bIsCurrentIndexValid = Snapshot->CurrentItemIndex == INDEX_NONE || Snapshot->Slots.IsValidIndex(Snapshot->CurrentItemIndex) || Snapshot->Slots.Num() == 0;
+					if (!bIsCurrentIndexValid || Snapshot->Version < LastVersion)
+					{
+						NumInconsistentReads++;
+					}
+
+					LastVersion = Snapshot->Version;
+					ReaderReads++;
+				}
+
+				NumReads += ReaderReads;
+			}));
+		}
+
+		// heavy switch and pickup traffic on the game thread, every change published right away
+		FRandomStream RandomStream(0);
+		int32 NumWrites = 0;
+		StartTime = FPlatformTime::Seconds();
+
+		while (FPlatformTime::Seconds() - StartTime < Seconds)
+		{
+			const int32 NumItems = Manager->GetItems().Num();
+			const int32 Op = RandomStream.RandHelper(3);
+
+			if (Op == 0 && NumItems < MaxItems)
+			{
+				Manager->AddItem(AItemParent::StaticClass());
+			}
+			else if (Op == 1 && NumItems > 1)
+			{
+				Manager->SwitchIndexItem(RandomStream.RandHelper(NumItems));
+			}
+			else if (NumItems > 1)
+			{
+				const int32 ItemIndex = 1 + RandomStream.RandHelper(NumItems - 1);
+				if (ItemIndex != Manager->GetCurrentItemIndex())
+				{
+					Manager->RemoveItems({ Manager->GetItemHandle(ItemIndex) });
+				}
+			}
+
+			Manager->GetInventorySnapshot();
+			NumWrites++;
+		}
+
+		const double WriteSeconds = FPlatformTime::Seconds() - StartTime;
+
+		bStopReaders = true;
+		UE::Tasks::Wait(Readers);
+
+		ItemManagerBenchmarkFixture::DestroyManager(Manager);
+
+		Ar.Logf(TEXT("Inventory snapshots: %d readers, %.1f s"), NumReaders, WriteSeconds);
+		Ar.Logf(TEXT("  Writer: %d changes, %.2f us per change and publish"), NumWrites, NumWrites > 0 ? WriteSeconds * 1000000.0 / NumWrites : 0.0);
+		Ar.Logf(TEXT("  Readers: %lld reads, %.1f M reads/s, %d inconsistent"), NumReads.load(), NumReads.load() / WriteSeconds / 1000000.0, NumInconsistentReads.load());
+		Ar.Logf(TEXT("  Get Items copy on the game thread: %.3f us per call (%d items)"), CopySeconds * 1000000.0 / NumCalls, NumCopiedItems / NumCalls);
+		Ar.Logf(TEXT("  Get Inventory Snapshot on the game thread: %.3f us per call (%d items)"), SnapshotSeconds * 1000000.0 / NumCalls, NumSnapshotItems / NumCalls);
+	}
+};
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice ItemSnapshotBenchmarkCommand(
+	TEXT("ItemManager.Snapshot.Benchmark"),
+	TEXT("Read inventory snapshots from worker threads while the game thread adds, switches and removes items. Usage: ItemManager.Snapshot.Benchmark [NumReaders] [Seconds] [MaxItems=32]"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		if (!World)
+		{
+			Ar.Logf(TEXT("No world to run the benchmark in"));
+			return;
+		}
+
+		const int32 NumReaders = Args.Num() > 0 ? FMath::Clamp(FCString::Atoi(*Args[0]), 1, 64) : FMath::Max(FPlatformMisc::NumberOfWorkerThreadsToSpawn(), 1);
+		const float Seconds = Args.Num() > 1 ? FMath::Max(FCString::Atof(*Args[1]), 0.1f) : 2.f;
+		const int32 MaxItems = Args.Num() > 2 ? FMath::Clamp(FCString::Atoi(*Args[2]), 2, 100000) : 32;
+
+		FItemInventorySnapshotBenchmark::Run(World, NumReaders, Seconds, MaxItems, Ar);
+	}));
@@ -0,0 +1,52 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+
+#include "utils/ItemManagerBenchmarkFixture.h"
+#include "ItemManagerComponent.h"
+#include "GameFramework/Pawn.h"
+#include "Engine/World.h"
+
+namespace ItemManagerBenchmarkFixture
+{
+	UItemManagerComponent* SpawnManager(UWorld* World, const FVector& Location, bool bVirtual)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		SpawnParameters.ObjectFlags |= RF_Transient;
+
+		APawn* Owner = World ? World->SpawnActor<APawn>(APawn::StaticClass(), FTransform(Location), SpawnParameters) : nullptr;
+		if (!Owner)
+		{
+			return nullptr;
+		}
+
+		UItemManagerComponent* Manager = NewObject<UItemManagerComponent>(Owner);
+		Manager->RegisterComponent();
+		Manager->SetVirtual(bVirtual);
+
+		return Manager;
+	}
+
+	bool FillInventory(UItemManagerComponent* Manager, int32 NumItems, const TArray<TSubclassOf<AItemParent>>& ItemClasses)
+	{
+		const int32 FirstItemIndex = Manager->GetNumItems();
+
+		for (int32 ItemIndex = FirstItemIndex; ItemIndex < NumItems; ItemIndex++)
+		{
+			if (Manager->AddItem(ItemClasses[ItemIndex % ItemClasses.Num()]) != 0)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void DestroyManager(UItemManagerComponent* Manager)
+	{
+		if (AActor* Owner = Manager ? Manager->GetOwner() : nullptr)
+		{
+			Owner->Destroy();
+		}
+	}
+}
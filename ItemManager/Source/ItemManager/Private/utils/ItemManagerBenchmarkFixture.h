@@ -0,0 +1,23 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/SubclassOf.h"
+
+class AItemParent;
+class UItemManagerComponent;
+class UWorld;
+
+// Transient item managers for the benchmark console commands, driven through their public API like gameplay code
+namespace ItemManagerBenchmarkFixture
+{
+	// Spawn a transient pawn owning a registered item manager, virtual by default so no item actor is spawned
+	UItemManagerComponent* SpawnManager(UWorld* World, const FVector& Location = FVector::ZeroVector, bool bVirtual = true);
+
+	// Add items, cycling through ItemClasses, until the inventory holds NumItems. Return false if one was refused.
+	bool FillInventory(UItemManagerComponent* Manager, int32 NumItems, const TArray<TSubclassOf<AItemParent>>& ItemClasses);
+
+	// Destroy the owner spawned with the manager
+	void DestroyManager(UItemManagerComponent* Manager);
+}
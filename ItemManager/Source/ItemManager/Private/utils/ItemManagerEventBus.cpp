@@ -0,0 +1,325 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+
+#include "utils/ItemManagerEventBus.h"
+#include "utils/ItemEventBenchmarkListener.h"
+#include "ItemManagerStats.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Event Dispatch"), STAT_ItemEventDispatch, STATGROUP_ItemManager);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Events Delivered"), STAT_ItemEventsDelivered, STATGROUP_ItemManager);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Events Coalesced"), STAT_ItemEventsCoalesced, STATGROUP_ItemManager);
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice ItemEventBenchmarkCommand(
+	TEXT("ItemManager.Events.Benchmark"),
+	TEXT("Compare the dispatch cost of the Blueprint delegates and of the native event bus. Usage: ItemManager.Events.Benchmark [NumEvents] [NumListeners]"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		const int32 NumEvents = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 100000;
+		const int32 NumListeners = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 16;
+
+		FItemObject ItemObject;
+		ItemObject.Item = AItemParent::StaticClass();
+
+		// dynamic delegate, every listener receives every event
+		FOnItemSpawnedDelegate DynamicDelegate;
+		TArray<UItemEventBenchmarkListener*> Listeners;
+
+		for (int32 ListenerIndex = 0; ListenerIndex < NumListeners; ListenerIndex++)
+		{
+			UItemEventBenchmarkListener* Listener = NewObject<UItemEventBenchmarkListener>();
+			DynamicDelegate.AddDynamic(Listener, &UItemEventBenchmarkListener::OnItemSpawned);
+			Listeners.Add(Listener);
+		}
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 EventIndex = 0; EventIndex < NumEvents; EventIndex++)
+		{
+			DynamicDelegate.Broadcast(ItemObject);
+		}
+		const double DynamicSeconds = FPlatformTime::Seconds() - StartTime;
+
+		FItemManagerEvent Event;
+		Event.Type = EItemManagerEvent::IE_Spawned;
+		Event.Item = ItemObject.Item;
+		Event.ItemIndex = 0;
+
+		// native bus, every listener is interested
+		int32 NumReceivedEvents = 0;
+		FItemManagerEventBus InterestedBus;
+
+		for (int32 ListenerIndex = 0; ListenerIndex < NumListeners; ListenerIndex++)
+		{
+			InterestedBus.Subscribe(FItemManagerEventFilter().OnlyType(EItemManagerEvent::IE_Spawned), FOnItemManagerEvent::CreateLambda([&NumReceivedEvents](const FItemManagerEvent&)
+			{
+				NumReceivedEvents++;
+			}));
+		}
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 EventIndex = 0; EventIndex < NumEvents; EventIndex++)
+		{
+			InterestedBus.Broadcast(Event);
+		}
+		const double InterestedSeconds = FPlatformTime::Seconds() - StartTime;
+
+		// native bus, a single listener is interested, the others listen to another type
+		FItemManagerEventBus FilteredBus;
+
+		for (int32 ListenerIndex = 0; ListenerIndex < NumListeners; ListenerIndex++)
+		{
+			const EItemManagerEvent Type = ListenerIndex == 0 ? EItemManagerEvent::IE_Spawned : EItemManagerEvent::IE_Despawned;
+
+			FilteredBus.Subscribe(FItemManagerEventFilter().OnlyType(Type), FOnItemManagerEvent::CreateLambda([&NumReceivedEvents](const FItemManagerEvent&)
+			{
+				NumReceivedEvents++;
+			}));
+		}
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 EventIndex = 0; EventIndex < NumEvents; EventIndex++)
+		{
+			FilteredBus.Broadcast(Event);
+		}
+		const double FilteredSeconds = FPlatformTime::Seconds() - StartTime;
+
+		Ar.Logf(TEXT("%d events, %d listeners"), NumEvents, NumListeners);
+		Ar.Logf(TEXT("Dynamic delegate:          %8.1f ns/event"), DynamicSeconds * 1e9 / NumEvents);
+		Ar.Logf(TEXT("Event bus (all listening): %8.1f ns/event"), InterestedSeconds * 1e9 / NumEvents);
+		Ar.Logf(TEXT("Event bus (one listening): %8.1f ns/event"), FilteredSeconds * 1e9 / NumEvents);
+
+		for (UItemEventBenchmarkListener* Listener : Listeners)
+		{
+			Listener->MarkAsGarbage();
+		}
+	}));
+
+FDelegateHandle FItemManagerEventBus::Subscribe(const FItemManagerEventFilter& Filter, FOnItemManagerEvent Delegate)
+{
+	check(IsInGameThread());
+
+	FSubscriber Subscriber;
+	Subscriber.Handle = FDelegateHandle(FDelegateHandle::GenerateNewHandle);
+	Subscriber.Filter = Filter;
+	Subscriber.Delegate = MoveTemp(Delegate);
+
+	const FDelegateHandle Handle = Subscriber.Handle;
+	const int32 SubscriberIndex = Subscribers.Add(MoveTemp(Subscriber));
+
+	for (int32 Type = 0; Type < static_cast<int32>(EItemManagerEvent::IE_Num); Type++)
+	{
+		if ((Filter.Types & FItemManagerEventFilter::GetTypeBit(static_cast<EItemManagerEvent>(Type))) == 0)
+		{
+			continue;
+		}
+
+		if (Filter.Owner.IsExplicitlyNull())
+		{
+			TypeSubscribers[Type].AnyOwner.Add(SubscriberIndex);
+		}
+		else
+		{
+			TypeSubscribers[Type].ByOwner.FindOrAdd(TObjectKey<AActor>(Filter.Owner.Get())).Add(SubscriberIndex);
+		}
+
+		SubscriberCounts[Type]++;
+	}
+
+	return Handle;
+}
+
+void FItemManagerEventBus::Unsubscribe(FDelegateHandle Handle)
+{
+	check(IsInGameThread());
+
+	for (auto It = Subscribers.CreateIterator(); It; ++It)
+	{
+		FSubscriber& Subscriber = *It;
+
+		if (Subscriber.Handle != Handle || Subscriber.bIsRemoved)
+		{
+			continue;
+		}
+
+		const int32 SubscriberIndex = It.GetIndex();
+
+		for (int32 Type = 0; Type < static_cast<int32>(EItemManagerEvent::IE_Num); Type++)
+		{
+			if ((Subscriber.Filter.Types & FItemManagerEventFilter::GetTypeBit(static_cast<EItemManagerEvent>(Type))) == 0)
+			{
+				continue;
+			}
+
+			TypeSubscribers[Type].AnyOwner.Remove(SubscriberIndex);
+
+			for (auto OwnerIt = TypeSubscribers[Type].ByOwner.CreateIterator(); OwnerIt; ++OwnerIt)
+			{
+				if (OwnerIt.Value().Remove(SubscriberIndex) > 0 && OwnerIt.Value().Num() <= 0)
+				{
+					OwnerIt.RemoveCurrent();
+				}
+			}
+
+			SubscriberCounts[Type]--;
+		}
+
+		// the delegate may be running, it is only destroyed with its entry
+		Subscriber.bIsRemoved = true;
+		Subscriber.PendingEvents.Empty();
+
+		// the index may still be in a list being broadcast, free it once done
+		PendingRemovals.Add(SubscriberIndex);
+		ReleasePendingRemovals();
+		return;
+	}
+}
+
+bool FItemManagerEventBus::PassesFilter(const FItemManagerEventFilter& Filter, const FItemManagerEvent& Event) const
+{
+	if (Filter.ItemClass && !(Event.Item && Event.Item->IsChildOf(Filter.ItemClass)))
+	{
+		return false;
+	}
+
+	if (!Filter.ItemTags.IsEmpty() && !(Event.Item && Event.Item.GetDefaultObject()->GetItemTags().HasAny(Filter.ItemTags)))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+void FItemManagerEventBus::Broadcast(const FItemManagerEvent& Event)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ItemEventDispatch);
+	check(IsInGameThread());
+
+	const int32 Type = static_cast<int32>(Event.Type);
+
+	if (SubscriberCounts[Type] <= 0)
+	{
+		return;
+	}
+
+	// subscribers may subscribe or unsubscribe while being called
+	TArray<int32, TInlineAllocator<16>> SubscriberIndices(TypeSubscribers[Type].AnyOwner);
+
+	if (TypeSubscribers[Type].ByOwner.Num() > 0 && Event.Owner.IsValid())
+	{
+		if (const TArray<int32>* OwnerSubscribers = TypeSubscribers[Type].ByOwner.Find(TObjectKey<AActor>(Event.Owner.Get())))
+		{
+			SubscriberIndices.Append(*OwnerSubscribers);
+		}
+	}
+
+	++BroadcastDepth;
+
+	for (const int32 SubscriberIndex : SubscriberIndices)
+	{
+		Deliver(SubscriberIndex, Event);
+	}
+
+	--BroadcastDepth;
+
+	ReleasePendingRemovals();
+}
+
+void FItemManagerEventBus::Deliver(int32 SubscriberIndex, const FItemManagerEvent& Event)
+{
+	FSubscriber& Subscriber = Subscribers[SubscriberIndex];
+
+	if (Subscriber.bIsRemoved || !PassesFilter(Subscriber.Filter, Event))
+	{
+		return;
+	}
+
+	if (!Subscriber.Filter.bCoalesce)
+	{
+		INC_DWORD_STAT(STAT_ItemEventsDelivered);
+
+		// a subscribe from the callback may move the subscribers
+		const FOnItemManagerEvent Delegate = Subscriber.Delegate;
+		Delegate.ExecuteIfBound(Event);
+		return;
+	}
+
+	FItemManagerEvent* PendingEvent = Subscriber.PendingEvents.FindByPredicate([&Event](const FItemManagerEvent& Other)
+	{
+		return Other.Type == Event.Type && Other.Manager == Event.Manager;
+	});
+
+	if (PendingEvent)
+	{
+		*PendingEvent = Event;
+		INC_DWORD_STAT(STAT_ItemEventsCoalesced);
+	}
+	else
+	{
+		if (Subscriber.PendingEvents.Num() <= 0)
+		{
+			SubscribersWithPendingEvents.Add(SubscriberIndex);
+		}
+
+		Subscriber.PendingEvents.Add(Event);
+	}
+}
+
+void FItemManagerEventBus::FlushCoalescedEvents()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ItemEventDispatch);
+
+	if (SubscribersWithPendingEvents.Num() <= 0)
+	{
+		return;
+	}
+
+	TArray<int32> SubscriberIndices = MoveTemp(SubscribersWithPendingEvents);
+	SubscribersWithPendingEvents.Reset();
+
+	++BroadcastDepth;
+
+	for (const int32 SubscriberIndex : SubscriberIndices)
+	{
+		if (!Subscribers.IsValidIndex(SubscriberIndex) || Subscribers[SubscriberIndex].bIsRemoved)
+		{
+			continue;
+		}
+
+		TArray<FItemManagerEvent> PendingEvents = MoveTemp(Subscribers[SubscriberIndex].PendingEvents);
+		Subscribers[SubscriberIndex].PendingEvents.Reset();
+
+		// a subscribe from the callback may move the subscribers
+		const FOnItemManagerEvent Delegate = Subscribers[SubscriberIndex].Delegate;
+
+		for (const FItemManagerEvent& PendingEvent : PendingEvents)
+		{
+			// the subscriber may unsubscribe from its own callback
+			if (Subscribers[SubscriberIndex].bIsRemoved)
+			{
+				break;
+			}
+
+			INC_DWORD_STAT(STAT_ItemEventsDelivered);
+			Delegate.ExecuteIfBound(PendingEvent);
+		}
+	}
+
+	--BroadcastDepth;
+
+	ReleasePendingRemovals();
+}
+
+void FItemManagerEventBus::ReleasePendingRemovals()
+{
+	if (BroadcastDepth > 0 || PendingRemovals.Num() <= 0)
+	{
+		return;
+	}
+
+	for (const int32 SubscriberIndex : PendingRemovals)
+	{
+		Subscribers.RemoveAt(SubscriberIndex);
+	}
+
+	PendingRemovals.Reset();
+}
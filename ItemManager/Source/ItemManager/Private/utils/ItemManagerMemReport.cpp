@@ -0,0 +1,242 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+
+#include "utils/ItemManagerMemReport.h"
+#include "ItemManagerComponent.h"
+#include "ItemManagerSubsystem.h"
+#include "utils/ItemConfigRegistry.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace ItemManagerMemReport
+{
+	static const TCHAR* RepresentationNames[] =
+	{
+		TEXT("Actor"),
+		TEXT("Resident"),
+		TEXT("Virtual"),
+		TEXT("Collectable")
+	};
+	static_assert(UE_ARRAY_COUNT(RepresentationNames) == static_cast<int32>(EItemRepresentation::IR_Num), "Missing representation name");
+
+	struct FMemoryTotal
+	{
+		int32 Count = 0;
+		int64 RecordBytes = 0;
+		int64 ActorBytes = 0;
+
+		void Add(const FItemMemoryRecord& Record)
+		{
+			Count++;
+			RecordBytes += Record.RecordBytes;
+			ActorBytes += Record.ActorBytes;
+		}
+	};
+
+	static double ToKB(int64 Bytes)
+	{
+		return Bytes / 1024.0;
+	}
+
+	void GetActorResourceSizeEx(AActor* Actor, FResourceSizeEx& CumulativeResourceSize)
+	{
+		if (!IsValid(Actor))
+		{
+			return;
+		}
+
+		Actor->GetResourceSizeEx(CumulativeResourceSize);
+
+		for (UActorComponent* Component : Actor->GetComponents())
+		{
+			if (IsValid(Component))
+			{
+				Component->GetResourceSizeEx(CumulativeResourceSize);
+			}
+		}
+	}
+
+	int64 GetActorResourceSize(AActor* Actor, EResourceSizeMode::Type Mode)
+	{
+		FResourceSizeEx ResourceSize(Mode);
+		GetActorResourceSizeEx(Actor, ResourceSize);
+		return ResourceSize.GetTotalMemoryBytes();
+	}
+}
+
+const TCHAR* LexToString(EItemRepresentation Representation)
+{
+	return Representation < EItemRepresentation::IR_Num ? ItemManagerMemReport::RepresentationNames[static_cast<int32>(Representation)] : TEXT("Unknown");
+}
+
+FItemManagerMemReport FItemManagerMemReport::Gather(UWorld* World)
+{
+	FItemManagerMemReport Report;
+	UItemManagerSubsystem* ItemManagerSubsystem = World ? World->GetSubsystem<UItemManagerSubsystem>() : nullptr;
+
+	if (!ItemManagerSubsystem)
+	{
+		return Report;
+	}
+
+	for (const TWeakObjectPtr<UItemManagerComponent>& WeakManager : ItemManagerSubsystem->GetManagers())
+	{
+		UItemManagerComponent* Manager = WeakManager.Get();
+
+		if (!Manager)
+		{
+			continue;
+		}
+
+		int32 const FirstRecord = Report.Records.Num();
+		Manager->GetItemMemoryRecords(Report.Records);
+
+		// the component accounts for its whole inventory, what is not in a record is overhead
+		int64 OverheadBytes = Manager->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+
+		for (int32 RecordIndex = FirstRecord; RecordIndex < Report.Records.Num(); RecordIndex++)
+		{
+			OverheadBytes -= Report.Records[RecordIndex].RecordBytes;
+		}
+
+		Report.ManagerOverheadBytes.FindOrAdd(GetNameSafe(Manager->GetOwner())) += FMath::Max<int64>(OverheadBytes, 0);
+	}
+
+	for (TActorIterator<AItemCollectable> It(World); It; ++It)
+	{
+		FItemMemoryRecord& Record = Report.Records.AddDefaulted_GetRef();
+		Record.ItemClass = It->GetItem().Get();
+		Record.Representation = EItemRepresentation::IR_Collectable;
+		Record.ActorBytes = ItemManagerMemReport::GetActorResourceSize(*It);
+	}
+
+	Report.SharedConfigBytes = FItemConfigRegistry::Get().GetAllocatedSize();
+
+	return Report;
+}
+
+int64 FItemManagerMemReport::GetTotalBytes() const
+{
+	int64 TotalBytes = SharedConfigBytes;
+
+	for (const FItemMemoryRecord& Record : Records)
+	{
+		TotalBytes += Record.RecordBytes + Record.ActorBytes;
+	}
+
+	for (const TPair<FString, int64>& Overhead : ManagerOverheadBytes)
+	{
+		TotalBytes += Overhead.Value;
+	}
+
+	return TotalBytes;
+}
+
+void FItemManagerMemReport::Dump(FOutputDevice& Ar) const
+{
+	using ItemManagerMemReport::FMemoryTotal;
+	using ItemManagerMemReport::ToKB;
+
+	FMemoryTotal ByRepresentation[static_cast<int32>(EItemRepresentation::IR_Num)];
+	TMap<const UClass*, FMemoryTotal> ByItemClass;
+	TMap<FString, FMemoryTotal> ByManager;
+
+	for (const FItemMemoryRecord& Record : Records)
+	{
+		ByRepresentation[static_cast<int32>(Record.Representation)].Add(Record);
+		ByItemClass.FindOrAdd(Record.ItemClass).Add(Record);
+
+		if (Record.Representation != EItemRepresentation::IR_Collectable)
+		{
+			ByManager.FindOrAdd(Record.Manager).Add(Record);
+		}
+	}
+
+	Ar.Logf(TEXT("Item manager memory: %.1f KB total, %.1f KB of shared configs"), ToKB(GetTotalBytes()), ToKB(SharedConfigBytes));
+
+	Ar.Logf(TEXT("%-16s %8s %12s %12s"), TEXT("Representation"), TEXT("Count"), TEXT("Records KB"), TEXT("Actors KB"));
+	for (int32 Representation = 0; Representation < static_cast<int32>(EItemRepresentation::IR_Num); Representation++)
+	{
+		const FMemoryTotal& Total = ByRepresentation[Representation];
+		Ar.Logf(TEXT("%-16s %8d %12.1f %12.1f"), LexToString(static_cast<EItemRepresentation>(Representation)), Total.Count, ToKB(Total.RecordBytes), ToKB(Total.ActorBytes));
+	}
+
+	ByItemClass.ValueSort([](const FMemoryTotal& A, const FMemoryTotal& B)
+	{
+		return A.RecordBytes + A.ActorBytes > B.RecordBytes + B.ActorBytes;
+	});
+
+	Ar.Logf(TEXT("%-40s %8s %12s %12s"), TEXT("Item class"), TEXT("Count"), TEXT("Records KB"), TEXT("Actors KB"));
+	for (const TPair<const UClass*, FMemoryTotal>& ItemClass : ByItemClass)
+	{
+		Ar.Logf(TEXT("%-40s %8d %12.1f %12.1f"), *GetNameSafe(ItemClass.Key), ItemClass.Value.Count, ToKB(ItemClass.Value.RecordBytes), ToKB(ItemClass.Value.ActorBytes));
+	}
+
+	ByManager.ValueSort([](const FMemoryTotal& A, const FMemoryTotal& B)
+	{
+		return A.RecordBytes + A.ActorBytes > B.RecordBytes + B.ActorBytes;
+	});
+
+	Ar.Logf(TEXT("%-40s %8s %12s %12s %12s"), TEXT("Manager"), TEXT("Items"), TEXT("Records KB"), TEXT("Actors KB"), TEXT("Overhead KB"));
+	for (const TPair<FString, FMemoryTotal>& Manager : ByManager)
+	{
+		const int64* OverheadBytes = ManagerOverheadBytes.Find(Manager.Key);
+		Ar.Logf(TEXT("%-40s %8d %12.1f %12.1f %12.1f"), *Manager.Key, Manager.Value.Count, ToKB(Manager.Value.RecordBytes), ToKB(Manager.Value.ActorBytes), OverheadBytes ? ToKB(*OverheadBytes) : 0.0);
+	}
+}
+
+bool FItemManagerMemReport::SaveToCsv(const FString& FilePath) const
+{
+	using ItemManagerMemReport::FMemoryTotal;
+
+	// stable rows so two builds can be diffed
+	TMap<FString, FMemoryTotal> Rows;
+
+	for (const FItemMemoryRecord& Record : Records)
+	{
+		Rows.FindOrAdd(FString::Printf(TEXT("%s,%s,%s"), *Record.Manager, *GetPathNameSafe(Record.ItemClass), LexToString(Record.Representation))).Add(Record);
+	}
+
+	Rows.KeySort(TLess<FString>());
+
+	FString Csv = TEXT("Manager,ItemClass,Representation,Count,RecordBytes,ActorBytes\n");
+
+	for (const TPair<FString, FMemoryTotal>& Row : Rows)
+	{
+		Csv += FString::Printf(TEXT("%s,%d,%lld,%lld\n"), *Row.Key, Row.Value.Count, Row.Value.RecordBytes, Row.Value.ActorBytes);
+	}
+
+	for (const TPair<FString, int64>& Overhead : ManagerOverheadBytes)
+	{
+		Csv += FString::Printf(TEXT("%s,,Overhead,0,%lld,0\n"), *Overhead.Key, Overhead.Value);
+	}
+
+	Csv += FString::Printf(TEXT(",,SharedConfigs,0,%lld,0\n"), SharedConfigBytes);
+
+	return FFileHelper::SaveStringToFile(Csv, *FilePath);
+}
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice ItemManagerMemReportCommand(
+	TEXT("ItemManager.MemReport"),
+	TEXT("Break down the memory of the inventories and collectables by manager, item class and representation. Usage: ItemManager.MemReport [csv [File]]"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		const FItemManagerMemReport Report = FItemManagerMemReport::Gather(World);
+		Report.Dump(Ar);
+
+		if (Args.Num() > 0 && Args[0].Equals(TEXT("csv"), ESearchCase::IgnoreCase))
+		{
+			FString const FilePath = Args.Num() > 1 ? Args[1] : FPaths::ProfilingDir() / TEXT("ItemManager") / FString::Printf(TEXT("MemReport_%s.csv"), *FDateTime::Now().ToString());
+
+			if (Report.SaveToCsv(FilePath))
+			{
+				Ar.Logf(TEXT("Memory report saved to %s"), *FilePath);
+			}
+			else
+			{
+				Ar.Logf(TEXT("Cannot write %s"), *FilePath);
+			}
+		}
+	}));
@@ -2,19 +2,26 @@
 
 
 #include "utils/ItemManagerPostProcessVolume.h"
+#include "ItemManagerSubsystem.h"
+#include "ItemManagerSettings.h"
 
 AItemManagerPostProcessVolume::AItemManagerPostProcessVolume()
 {
-    FString PostProcessMaterialPath = TEXT("'/ItemManager/Materials/M_TransparencyPP_Inst.M_TransparencyPP_Inst'");
+	bUnbound = true;
+    SetActorLocation({ 0.f, 0.f, 0.f });
+}
 
-    static ConstructorHelpers::FObjectFinder<UMaterialInstance> PostProcessMateriallObject(*PostProcessMaterialPath);
+void AItemManagerPostProcessVolume::PostInitializeComponents()
+{
+    Super::PostInitializeComponents();
 
-    if (PostProcessMateriallObject.Succeeded()) 
+    // a dedicated server does not render, do not even load the material
+    if (!UItemManagerSubsystem::IsServerModeEnabled())
     {
-        PostProcessMaterialInstance = PostProcessMateriallObject.Object;
-        UMaterialInterface* PostProcessMaterialInterface = reinterpret_cast<UMaterialInterface*>(PostProcessMaterialInstance);
-        Settings.AddBlendable(PostProcessMaterialInterface, 1.f);
+        // preloaded with the other shared assets, only loaded here if the preload is not done yet
+        if (UMaterialInstance* PostProcessMaterialInstance = UItemManagerSettings::Get()->GetTransparencyPostProcessMaterial())
+        {
+            Settings.AddBlendable(PostProcessMaterialInstance, 1.f);
+        }
     }
-	bUnbound = true;
-    SetActorLocation({ 0.f, 0.f, 0.f });
 }
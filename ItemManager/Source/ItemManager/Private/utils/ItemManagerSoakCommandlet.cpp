@@ -0,0 +1,57 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+
+#include "utils/ItemManagerSoakCommandlet.h"
+#include "utils/ItemManagerSoakTest.h"
+#include "ItemManagerComponent.h"
+#include "Containers/Ticker.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+UItemManagerSoakCommandlet::UItemManagerSoakCommandlet()
+{
+	IsClient = false;
+	IsServer = true;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UItemManagerSoakCommandlet::Main(const FString& Params)
+{
+	FItemManagerSoakSettings Settings;
+	Settings.ParseParams(*Params);
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("ItemManagerSoak"));
+
+	if (!World)
+	{
+		UE_LOG(ItemManager, Error, TEXT("Soak test: cannot create the world"));
+		return 1;
+	}
+
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	FItemManagerSoakTest SoakTest(World, Settings);
+	SoakTest.Start();
+
+	// fixed 30 Hz frames, the frame time budget is checked on the wall time
+	const float DeltaSeconds = 1.f / 30.f;
+
+	while (!SoakTest.IsDone() && !IsEngineExitRequested())
+	{
+		World->Tick(LEVELTICK_All, DeltaSeconds);
+		FTSTicker::GetCoreTicker().Tick(DeltaSeconds);
+		SoakTest.Step(DeltaSeconds);
+	}
+
+	const bool bSucceeded = SoakTest.Finish(*GLog);
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	return bSucceeded ? 0 : 1;
+}
@@ -0,0 +1,24 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ItemManagerSoakCommandlet.generated.h"
+
+/**
+ * Run the item manager soak test in an empty game world, without rendering.
+ * Usage: UnrealEditor-Cmd <Project> -run=ItemManagerSoak [-Bots=] [-Collectables=] [-Duration=] [-Seed=] ...
+ * Return 1 if the soak test failed.
+ */
+UCLASS()
+class UItemManagerSoakCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UItemManagerSoakCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,487 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+
+#include "utils/ItemManagerSoakTest.h"
+#include "ItemManagerComponent.h"
+#include "ItemManagerSubsystem.h"
+#include "utils/ItemConfigRegistry.h"
+#include "Containers/Ticker.h"
+#include "EngineUtils.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "UObject/UObjectArray.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace ItemManagerSoak
+{
+	static TSharedPtr<FItemManagerSoakTest> RunningTest;
+
+	// bots and collectables are spread on a square of this spacing per actor
+	static constexpr float ActorSpacing = 200.f;
+}
+
+void FItemManagerSoakSettings::ParseParams(const TCHAR* Params)
+{
+	FParse::Value(Params, TEXT("Bots="), NumBots);
+	FParse::Value(Params, TEXT("Collectables="), NumCollectables);
+	FParse::Value(Params, TEXT("Duration="), DurationSeconds);
+	FParse::Value(Params, TEXT("Seed="), Seed);
+	FParse::Value(Params, TEXT("ActionRate="), ActionRate);
+	FParse::Value(Params, TEXT("FrameBudgetMs="), FrameBudgetMs);
+	FParse::Value(Params, TEXT("MaxMemoryGrowthMB="), MaxMemoryGrowthMB);
+	FParse::Value(Params, TEXT("MaxScheduledRequests="), MaxScheduledRequests);
+	FParse::Value(Params, TEXT("MaxObjectGrowth="), MaxObjectGrowth);
+	FParse::Value(Params, TEXT("GCInterval="), GCIntervalSeconds);
+
+	FString ItemPaths;
+	if (FParse::Value(Params, TEXT("Items="), ItemPaths, false))
+	{
+		TArray<FString> Paths;
+		ItemPaths.ParseIntoArray(Paths, TEXT("+"));
+
+		for (const FString& Path : Paths)
+		{
+			if (UClass* ItemClass = LoadClass<AItemParent>(nullptr, *Path))
+			{
+				ItemClasses.Add(ItemClass);
+			}
+			else
+			{
+				UE_LOG(ItemManager, Warning, TEXT("Soak test: cannot load item class %s"), *Path);
+			}
+		}
+	}
+
+	NumBots = FMath::Max(NumBots, 1);
+	NumCollectables = FMath::Max(NumCollectables, 0);
+	DurationSeconds = FMath::Max(DurationSeconds, 1.f);
+	ActionRate = FMath::Clamp(ActionRate, 0.f, 1.f);
+	GCIntervalSeconds = FMath::Max(GCIntervalSeconds, 0.f);
+}
+
+FItemManagerSoakTest::FItemManagerSoakTest(UWorld* InWorld, const FItemManagerSoakSettings& InSettings)
+	: World(InWorld)
+	, Settings(InSettings)
+	, RandomStream(InSettings.Seed)
+{
+	if (Settings.ItemClasses.Num() <= 0)
+	{
+		Settings.ItemClasses.Add(AItemParent::StaticClass());
+	}
+
+	// the collections of the engine are measured too
+	PreGarbageCollectHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddRaw(this, &FItemManagerSoakTest::OnPreGarbageCollect);
+	PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddRaw(this, &FItemManagerSoakTest::OnPostGarbageCollect);
+}
+
+FItemManagerSoakTest::~FItemManagerSoakTest()
+{
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGarbageCollectHandle);
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGarbageCollectHandle);
+}
+
+void FItemManagerSoakTest::OnPreGarbageCollect()
+{
+	GCStartTime = FPlatformTime::Seconds();
+}
+
+void FItemManagerSoakTest::OnPostGarbageCollect()
+{
+	const double Seconds = FPlatformTime::Seconds() - GCStartTime;
+
+	NumGarbageCollections++;
+	GCSeconds += Seconds;
+	MaxGCSeconds = FMath::Max(MaxGCSeconds, Seconds);
+}
+
+void FItemManagerSoakTest::Start()
+{
+	UWorld* SoakWorld = World.Get();
+	UItemManagerSubsystem* ItemManagerSubsystem = SoakWorld ? SoakWorld->GetSubsystem<UItemManagerSubsystem>() : nullptr;
+
+	if (!ItemManagerSubsystem)
+	{
+		return;
+	}
+
+	for (TActorIterator<AActor> It(SoakWorld); It; ++It)
+	{
+		ActorsBeforeStart.Add(*It);
+	}
+
+	const float BotsExtent = FMath::Sqrt(static_cast<float>(Settings.NumBots)) * ItemManagerSoak::ActorSpacing * 0.5f;
+	const float CollectablesExtent = FMath::Sqrt(static_cast<float>(Settings.NumCollectables)) * ItemManagerSoak::ActorSpacing * 0.5f;
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	for (int32 BotIndex = 0; BotIndex < Settings.NumBots; BotIndex++)
+	{
+		const FVector Location(RandomStream.FRandRange(-BotsExtent, BotsExtent), RandomStream.FRandRange(-BotsExtent, BotsExtent), 0.f);
+		APawn* Bot = SoakWorld->SpawnActor<APawn>(APawn::StaticClass(), FTransform(Location), SpawnParameters);
+
+		if (!Bot)
+		{
+			continue;
+		}
+
+		// the item actors are attached to the owner root
+		USceneComponent* Root = NewObject<USceneComponent>(Bot, TEXT("SoakRoot"));
+		Bot->SetRootComponent(Root);
+		Root->RegisterComponent();
+		Root->SetWorldLocation(Location);
+
+		UItemManagerComponent* Manager = NewObject<UItemManagerComponent>(Bot, TEXT("SoakItemManager"));
+		Manager->RegisterComponent();
+
+		Bots.Add(Bot);
+		Managers.Add(Manager);
+	}
+
+	for (int32 CollectableIndex = 0; CollectableIndex < Settings.NumCollectables; CollectableIndex++)
+	{
+		const TSubclassOf<AItemParent> ItemClass = Settings.ItemClasses[RandomStream.RandHelper(Settings.ItemClasses.Num())];
+		const FVector Location(RandomStream.FRandRange(-CollectablesExtent, CollectablesExtent), RandomStream.FRandRange(-CollectablesExtent, CollectablesExtent), 0.f);
+
+		// spawned by the scheduler, within its frame budget, and registered to every item manager
+		ItemManagerSubsystem->EnqueueSpawnCollectable(FItemConfigRegistry::Get().GetItemCollectableData(ItemClass), FTransform(Location), nullptr);
+	}
+
+	LastStepTime = FPlatformTime::Seconds();
+	NextGCTime = Settings.GCIntervalSeconds;
+	NextProgressTime = 60.f;
+}
+
+void FItemManagerSoakTest::Step(float DeltaSeconds)
+{
+	// wall time of the whole frame, the engine may clamp DeltaSeconds
+	const double Now = FPlatformTime::Seconds();
+	FrameMilliseconds.Add(static_cast<float>((Now - LastStepTime) * 1000.0));
+	LastStepTime = Now;
+
+	ElapsedSeconds += DeltaSeconds;
+
+	for (const TWeakObjectPtr<UItemManagerComponent>& WeakManager : Managers)
+	{
+		UItemManagerComponent* Manager = WeakManager.Get();
+
+		if (Manager && RandomStream.FRand() < Settings.ActionRate)
+		{
+			RunAction(Manager);
+		}
+	}
+
+	// memory and objects are compared to the state once the bots have settled
+	if (!bHasBaselineMemory && ElapsedSeconds >= Settings.DurationSeconds * 0.1f)
+	{
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+		BaselineMemory = FPlatformMemory::GetStats().UsedPhysical;
+		BaselineObjects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+		bHasBaselineMemory = true;
+	}
+	else if (Settings.GCIntervalSeconds > 0.f && ElapsedSeconds >= NextGCTime)
+	{
+		// dropped collectables and despawned item actors pile up between the collections of the engine
+		NextGCTime = ElapsedSeconds + Settings.GCIntervalSeconds;
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	if (ElapsedSeconds >= NextActorCountTime)
+	{
+		NextActorCountTime = ElapsedSeconds + 1.f;
+
+		int32 NumItemActors = 0;
+		int32 NumCollectables = 0;
+		CountActors(NumItemActors, NumCollectables);
+
+		MaxItemActors = FMath::Max(MaxItemActors, NumItemActors);
+		MaxCollectables = FMath::Max(MaxCollectables, NumCollectables);
+		MaxObjects = FMath::Max(MaxObjects, GUObjectArray.GetObjectArrayNumMinusAvailable());
+
+		if (UItemManagerSubsystem* ItemManagerSubsystem = World.IsValid() ? World->GetSubsystem<UItemManagerSubsystem>() : nullptr)
+		{
+			MaxScheduledRequests = FMath::Max(MaxScheduledRequests, ItemManagerSubsystem->GetNumScheduledRequests());
+		}
+	}
+
+	// long runs report their progress every minute
+	if (ElapsedSeconds >= NextProgressTime)
+	{
+		NextProgressTime = ElapsedSeconds + 60.f;
+
+		UE_LOG(ItemManager, Display, TEXT("Soak test %.0f / %.0f s: %d UObjects, %d garbage collections (max %.2f ms)"),
+			ElapsedSeconds, Settings.DurationSeconds, GUObjectArray.GetObjectArrayNumMinusAvailable(), NumGarbageCollections, MaxGCSeconds * 1000.0);
+	}
+}
+
+void FItemManagerSoakTest::RunAction(UItemManagerComponent* Manager)
+{
+	EItemTraceOp Op = static_cast<EItemTraceOp>(RandomStream.RandHelper(static_cast<int32>(EItemTraceOp::TO_Num)));
+	AItemCollectable* ItemCollectable = nullptr;
+
+	if (Op == EItemTraceOp::TO_CollectItem)
+	{
+		// walk on a random collectable of the world
+		const TArray<AItemCollectable*> ItemsCollectables = Manager->GetItemsCollectables();
+
+		if (ItemsCollectables.Num() <= 0)
+		{
+			Op = EItemTraceOp::TO_AddItem;
+		}
+		else
+		{
+			ItemCollectable = ItemsCollectables[RandomStream.RandHelper(ItemsCollectables.Num())];
+
+			if (!IsValid(ItemCollectable))
+			{
+				return;
+			}
+
+			Manager->OnPickableBeginOverlap(ItemCollectable);
+		}
+	}
+
+	uint64 const StartCycles = FPlatformTime::Cycles64();
+
+	switch (Op)
+	{
+		case EItemTraceOp::TO_AddItem:
+			Manager->AddItem(Settings.ItemClasses[RandomStream.RandHelper(Settings.ItemClasses.Num())]);
+			break;
+		case EItemTraceOp::TO_SwitchIndexItem:     Manager->SwitchIndexItem(RandomStream.RandHelper(FMath::Max(Manager->Items.Num(), 1))); break;
+		case EItemTraceOp::TO_SwitchNextItem:      Manager->SwitchNextItem(); break;
+		case EItemTraceOp::TO_SwitchPreviousItem:  Manager->SwitchPreviousItem(); break;
+		case EItemTraceOp::TO_CollectItem:         Manager->CollectItem(); break;
+		case EItemTraceOp::TO_DropItem:            Manager->DropItem(); break;
+		case EItemTraceOp::TO_UseItem:             Manager->UseItem(); break;
+		default: break;
+	}
+
+	OpHistograms[static_cast<int32>(Op)].Add(FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles));
+
+	if (ItemCollectable && IsValid(ItemCollectable))
+	{
+		Manager->OnPickableEndOverlap(ItemCollectable);
+	}
+}
+
+void FItemManagerSoakTest::CountActors(int32& OutItemActors, int32& OutCollectables) const
+{
+	OutItemActors = 0;
+	OutCollectables = 0;
+
+	if (!World.IsValid())
+	{
+		return;
+	}
+
+	for (TActorIterator<AItemParent> It(World.Get()); It; ++It)
+	{
+		OutItemActors++;
+	}
+
+	for (TActorIterator<AItemCollectable> It(World.Get()); It; ++It)
+	{
+		OutCollectables++;
+	}
+}
+
+bool FItemManagerSoakTest::Finish(FOutputDevice& Ar)
+{
+	bool bSucceeded = true;
+	UWorld* SoakWorld = World.Get();
+
+	if (!SoakWorld)
+	{
+		Ar.Logf(ELogVerbosity::Error, TEXT("Item manager soak test: the world has been destroyed"));
+		return false;
+	}
+
+	UItemManagerSubsystem* ItemManagerSubsystem = SoakWorld->GetSubsystem<UItemManagerSubsystem>();
+
+	// pending destroys and spawns must not be taken for leaks
+	if (ItemManagerSubsystem)
+	{
+		ItemManagerSubsystem->FlushScheduledRequests();
+	}
+
+	// garbage of the last actions is not a leak
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	const int32 NumObjects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+	const int32 ObjectGrowth = bHasBaselineMemory ? NumObjects - BaselineObjects : 0;
+
+	int32 NumItemActors = 0;
+	int32 NumCollectables = 0;
+	CountActors(NumItemActors, NumCollectables);
+
+	FrameMilliseconds.Sort();
+	auto GetFramePercentile = [this](float Percentile)
+	{
+		return FrameMilliseconds.Num() > 0 ? FrameMilliseconds[FMath::Min(FMath::FloorToInt(FrameMilliseconds.Num() * Percentile), FrameMilliseconds.Num() - 1)] : 0.f;
+	};
+
+	const float FrameP99 = GetFramePercentile(0.99f);
+	const double MemoryGrowthMB = bHasBaselineMemory ? (static_cast<double>(FPlatformMemory::GetStats().UsedPhysical) - static_cast<double>(BaselineMemory)) / (1024.0 * 1024.0) : 0.0;
+
+	Ar.Logf(TEXT("Item manager soak test: %d bots, %d collectables, %.0f s, seed %d"), Managers.Num(), Settings.NumCollectables, ElapsedSeconds, Settings.Seed);
+	Ar.Logf(TEXT("Frame (ms): p50 %.2f  p90 %.2f  p99 %.2f  max %.2f  (%d frames)"),
+		GetFramePercentile(0.5f), GetFramePercentile(0.9f), FrameP99, FrameMilliseconds.Num() > 0 ? FrameMilliseconds.Last() : 0.f, FrameMilliseconds.Num());
+	Ar.Logf(TEXT("%-20s %8s %10s %10s %10s %10s"), TEXT("Op"), TEXT("Count"), TEXT("Avg (us)"), TEXT("P50 (us)"), TEXT("P99 (us)"), TEXT("Max (us)"));
+
+	for (int32 Op = 0; Op < static_cast<int32>(EItemTraceOp::TO_Num); Op++)
+	{
+		const FItemTraceHistogram& Histogram = OpHistograms[Op];
+
+		if (Histogram.Count == 0)
+		{
+			continue;
+		}
+
+		Ar.Logf(TEXT("%-20s %8u %10.2f %10.0f %10.0f %10.2f"),
+			LexToString(static_cast<EItemTraceOp>(Op)),
+			Histogram.Count,
+			Histogram.TotalSeconds * 1000000.0 / Histogram.Count,
+			Histogram.GetPercentileMicroseconds(0.5f),
+			Histogram.GetPercentileMicroseconds(0.99f),
+			Histogram.MaxSeconds * 1000000.0);
+	}
+
+	Ar.Logf(TEXT("Item actors: %d (peak %d)  Collectables: %d (peak %d)  Scheduled requests peak: %d  Memory growth: %.1f MB"),
+		NumItemActors, MaxItemActors, NumCollectables, MaxCollectables, MaxScheduledRequests, MemoryGrowthMB);
+	Ar.Logf(TEXT("Garbage collection: %d collections  avg %.2f ms  max %.2f ms  total %.1f ms"),
+		NumGarbageCollections, NumGarbageCollections > 0 ? GCSeconds * 1000.0 / NumGarbageCollections : 0.0, MaxGCSeconds * 1000.0, GCSeconds * 1000.0);
+	Ar.Logf(TEXT("UObjects: %d (peak %d, baseline %d, growth %d)"), NumObjects, MaxObjects, BaselineObjects, ObjectGrowth);
+
+	// every manager must only know the collectables still alive
+	TSet<AItemParent*> ReferencedItemActors;
+
+	for (const TWeakObjectPtr<UItemManagerComponent>& WeakManager : ItemManagerSubsystem ? ItemManagerSubsystem->GetManagers() : Managers)
+	{
+		const UItemManagerComponent* Manager = WeakManager.Get();
+
+		if (!Manager)
+		{
+			continue;
+		}
+
+		int32 NumStaleEntries = 0;
+
+		for (const AItemCollectable* ItemCollectable : Manager->ItemsCollectable)
+		{
+			NumStaleEntries += IsValid(ItemCollectable) ? 0 : 1;
+		}
+
+		if (NumStaleEntries > 0 || Manager->ItemsCollectable.Num() > NumCollectables)
+		{
+			Ar.Logf(ELogVerbosity::Error, TEXT("%s: %d collectable entries for %d live collectables, %d stale"),
+				*GetNameSafe(Manager->GetOwner()), Manager->ItemsCollectable.Num(), NumCollectables, NumStaleEntries);
+			bSucceeded = false;
+		}
+
+		for (const FItemObject& ItemObject : Manager->Items)
+		{
+			ReferencedItemActors.Add(ItemObject.Actor);
+		}
+	}
+
+	// item actors owned by nobody will never be destroyed
+	int32 NumOrphanedItemActors = 0;
+
+	for (TActorIterator<AItemParent> It(SoakWorld); It; ++It)
+	{
+		// the pool is bounded, its actors are not leaked
+		if (!ReferencedItemActors.Contains(*It) && !ActorsBeforeStart.Contains(*It) && !(ItemManagerSubsystem && ItemManagerSubsystem->IsPooledItemActor(*It)))
+		{
+			NumOrphanedItemActors++;
+		}
+	}
+
+	if (NumOrphanedItemActors > 0)
+	{
+		Ar.Logf(ELogVerbosity::Error, TEXT("%d item actors are not referenced by any item manager"), NumOrphanedItemActors);
+		bSucceeded = false;
+	}
+
+	if (FrameP99 > Settings.FrameBudgetMs)
+	{
+		Ar.Logf(ELogVerbosity::Error, TEXT("Frame p99 %.2f ms is over the budget of %.2f ms"), FrameP99, Settings.FrameBudgetMs);
+		bSucceeded = false;
+	}
+
+	if (MaxScheduledRequests > Settings.MaxScheduledRequests)
+	{
+		Ar.Logf(ELogVerbosity::Error, TEXT("%d scheduled requests, more than %d"), MaxScheduledRequests, Settings.MaxScheduledRequests);
+		bSucceeded = false;
+	}
+
+	if (ObjectGrowth > Settings.MaxObjectGrowth)
+	{
+		Ar.Logf(ELogVerbosity::Error, TEXT("%d more UObjects than after settling, more than %d"), ObjectGrowth, Settings.MaxObjectGrowth);
+		bSucceeded = false;
+	}
+
+	if (MemoryGrowthMB > Settings.MaxMemoryGrowthMB)
+	{
+		Ar.Logf(ELogVerbosity::Error, TEXT("Memory grew by %.1f MB, more than %.1f MB"), MemoryGrowthMB, Settings.MaxMemoryGrowthMB);
+		bSucceeded = false;
+	}
+
+	Ar.Logf(TEXT("Item manager soak test %s"), bSucceeded ? TEXT("succeeded") : TEXT("failed"));
+
+	// the bots destroy their own item actors
+	for (const TWeakObjectPtr<AActor>& Bot : Bots)
+	{
+		if (Bot.IsValid())
+		{
+			Bot->Destroy();
+		}
+	}
+
+	for (TActorIterator<AItemCollectable> It(SoakWorld); It; ++It)
+	{
+		if (!ActorsBeforeStart.Contains(*It))
+		{
+			It->Destroy();
+		}
+	}
+
+	Bots.Empty();
+	Managers.Empty();
+
+	return bSucceeded;
+}
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice ItemManagerSoakCommand(
+	TEXT("ItemManager.Soak"),
+	TEXT("Run bots collecting, dropping, switching and using items in the current world and report frame times, operation costs, garbage collections and leaks.\n")
+	TEXT("Usage: ItemManager.Soak [-Bots=64] [-Collectables=1000] [-Duration=60] [-Seed=0] [-ActionRate=0.2] [-FrameBudgetMs=33.3] [-MaxMemoryGrowthMB=64] [-MaxScheduledRequests=1024] [-MaxObjectGrowth=5000] [-GCInterval=10] [-Items=/Game/Path.Class_C+...]"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		if (ItemManagerSoak::RunningTest.IsValid())
+		{
+			Ar.Log(TEXT("A soak test is already running"));
+			return;
+		}
+
+		FItemManagerSoakSettings Settings;
+		Settings.ParseParams(*FString::Join(Args, TEXT(" ")));
+
+		ItemManagerSoak::RunningTest = MakeShared<FItemManagerSoakTest>(World, Settings);
+		ItemManagerSoak::RunningTest->Start();
+
+		FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([](float DeltaTime)
+		{
+			ItemManagerSoak::RunningTest->Step(DeltaTime);
+
+			if (!ItemManagerSoak::RunningTest->IsDone())
+			{
+				return true;
+			}
+
+			ItemManagerSoak::RunningTest->Finish(*GLog);
+			ItemManagerSoak::RunningTest.Reset();
+			return false;
+		}));
+	}));
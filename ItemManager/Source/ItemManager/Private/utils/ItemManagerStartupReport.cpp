@@ -0,0 +1,91 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+
+#include "ItemCollectable.h"
+#include "ItemManagerSettings.h"
+#include "ItemManagerSubsystem.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/Package.h"
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice ItemStartupReportCommand(
+	TEXT("ItemManager.Startup.Report"),
+	TEXT("Report the time the plugin adds to a level load: shared assets preload, collectable construction and registration. Usage: ItemManager.Startup.Report [NumCollectables] [ItemClassPath]"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		if (!World)
+		{
+			Ar.Logf(TEXT("No world to run the report in"));
+			return;
+		}
+
+		const int32 NumCollectables = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10000;
+
+		FItemCollectableData ItemCollectableData;
+		if (Args.Num() > 1)
+		{
+			ItemCollectableData.Item = FSoftClassPath(Args[1]).TryLoadClass<AItemParent>();
+		}
+
+		const UItemManagerSettings* ItemManagerSettings = UItemManagerSettings::Get();
+
+		// what a level load pays per placed collectable before its properties are read
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < NumCollectables; Index++)
+		{
+			AItemCollectable* ItemCollectable = NewObject<AItemCollectable>(GetTransientPackage(), NAME_None, RF_Transient);
+			ItemCollectable->MarkAsGarbage();
+		}
+		const double ConstructSeconds = FPlatformTime::Seconds() - StartTime;
+
+		// the outline material used to be looked up by every constructor
+		double LookupSeconds = 0.0;
+		if (!UItemManagerSubsystem::IsServerModeEnabled())
+		{
+			StartTime = FPlatformTime::Seconds();
+			for (int32 Index = 0; Index < NumCollectables; Index++)
+			{
+				StaticLoadObject(UMaterialInstance::StaticClass(), nullptr, TEXT("/ItemManager/Materials/M_Outline_Inst.M_Outline_Inst"));
+			}
+			LookupSeconds = FPlatformTime::Seconds() - StartTime;
+		}
+
+		// components registration and begin play, as done once the level is loaded
+		TArray<AItemCollectable*> Collectables;
+		Collectables.Reserve(NumCollectables);
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < NumCollectables; Index++)
+		{
+			const FTransform Transform(FVector((Index % 100) * 200.f, (Index / 100) * 200.f, 0.f));
+			AItemCollectable* ItemCollectable = World->SpawnActorDeferred<AItemCollectable>(AItemCollectable::StaticClass(), Transform);
+
+			if (ItemCollectable)
+			{
+				ItemCollectable->Init(ItemCollectableData);
+				ItemCollectable->FinishSpawning(Transform);
+				Collectables.Add(ItemCollectable);
+			}
+		}
+		const double SpawnSeconds = FPlatformTime::Seconds() - StartTime;
+
+		for (AItemCollectable* ItemCollectable : Collectables)
+		{
+			ItemCollectable->Destroy();
+		}
+
+		Ar.Logf(TEXT("Item manager startup, %d collectables, server mode %s"), NumCollectables, UItemManagerSubsystem::IsServerModeEnabled() ? TEXT("on") : TEXT("off"));
+
+		if (ItemManagerSettings->IsSharedAssetsPreloaded())
+		{
+			Ar.Logf(TEXT("  Shared assets preload: %.2f ms, async"), ItemManagerSettings->GetSharedAssetsPreloadSeconds() * 1000.0);
+		}
+		else
+		{
+			Ar.Logf(TEXT("  Shared assets preload: not done, loaded on first use"));
+		}
+
+		Ar.Logf(TEXT("  Construction:          %.2f ms (%.2f us per collectable)"), ConstructSeconds * 1000.0, ConstructSeconds * 1000000.0 / NumCollectables);
+		Ar.Logf(TEXT("  Level load added:      %.2f ms (%.2f us per collectable, construction, registration and begin play)"), SpawnSeconds * 1000.0, SpawnSeconds * 1000000.0 / FMath::Max(Collectables.Num(), 1));
+		Ar.Logf(TEXT("  Saved outline lookups: %.2f ms, no longer done by the constructor"), LookupSeconds * 1000.0);
+	}));
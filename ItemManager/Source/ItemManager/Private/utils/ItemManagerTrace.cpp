@@ -0,0 +1,396 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+
+#include "utils/ItemManagerTrace.h"
+#include "ItemManagerComponent.h"
+#include "Containers/Ticker.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "UObject/UObjectIterator.h"
+
+namespace ItemManagerTrace
+{
+	static constexpr uint32 Magic = 0x52544D49; // 'IMTR'
+	static constexpr uint32 Version = 1;
+
+	static const TCHAR* OpNames[] =
+	{
+		TEXT("AddItem"),
+		TEXT("SwitchIndexItem"),
+		TEXT("SwitchNextItem"),
+		TEXT("SwitchPreviousItem"),
+		TEXT("CollectItem"),
+		TEXT("DropItem"),
+		TEXT("UseItem")
+	};
+	static_assert(UE_ARRAY_COUNT(OpNames) == static_cast<int32>(EItemTraceOp::TO_Num), "Missing op name");
+
+	// zigzag encoding, small negative values stay small once packed
+	uint32 EncodeValue(int32 Value)
+	{
+		return (static_cast<uint32>(Value) << 1) ^ static_cast<uint32>(Value >> 31);
+	}
+
+	int32 DecodeValue(uint32 Value)
+	{
+		return static_cast<int32>(Value >> 1) ^ -static_cast<int32>(Value & 1);
+	}
+
+	// a count read from a corrupt file must fit in what is left of it, each element taking at least MinElementSize bytes
+	bool IsValidCount(FArchive& Ar, int64 Count, int64 MinElementSize)
+	{
+		const int64 TotalSize = Ar.TotalSize();
+		return Count >= 0 && (TotalSize < 0 || Count * MinElementSize <= TotalSize - Ar.Tell());
+	}
+
+	TArray<UItemManagerComponent*> GetWorldManagers(UWorld* World)
+	{
+		TArray<UItemManagerComponent*> Managers;
+
+		for (TObjectIterator<UItemManagerComponent> It; It; ++It)
+		{
+			if (It->GetWorld() == World && !It->IsTemplate())
+			{
+				Managers.Add(*It);
+			}
+		}
+
+		return Managers;
+	}
+
+	TSharedPtr<FItemManagerTraceReplayer> RealTimeReplayer;
+	FTSTicker::FDelegateHandle RealTimeTickerHandle;
+}
+
+void FItemManagerTrace::Serialize(FArchive& Ar)
+{
+	uint32 Magic = ItemManagerTrace::Magic;
+	uint32 Version = ItemManagerTrace::Version;
+	Ar << Magic;
+	Ar << Version;
+
+	if (Ar.IsLoading() && (Magic != ItemManagerTrace::Magic || Version != ItemManagerTrace::Version))
+	{
+		Ar.SetError();
+		return;
+	}
+
+	int32 NumClasses = Classes.Num();
+	Ar << NumClasses;
+	if (Ar.IsLoading())
+	{
+		// a class path is at least its length
+		if (!ItemManagerTrace::IsValidCount(Ar, NumClasses, sizeof(int32)))
+		{
+			Ar.SetError();
+			return;
+		}
+
+		Classes.SetNum(NumClasses);
+	}
+
+	for (FSoftClassPath& Class : Classes)
+	{
+		FString ClassPath = Class.ToString();
+		Ar << ClassPath;
+		Class.SetPath(ClassPath);
+	}
+
+	uint32 NumEvents = Events.Num();
+	Ar.SerializeIntPacked(NumEvents);
+	if (Ar.IsLoading())
+	{
+		// an event is at least its op byte and two packed bytes
+		if (!ItemManagerTrace::IsValidCount(Ar, NumEvents, 3))
+		{
+			Ar.SetError();
+			return;
+		}
+
+		Events.SetNum(NumEvents);
+	}
+
+	uint32 PreviousFrame = 0;
+	for (FItemTraceEvent& Event : Events)
+	{
+		uint8 Op = static_cast<uint8>(Event.Op);
+		uint32 FrameDelta = Event.Frame - PreviousFrame;
+		uint32 Value = ItemManagerTrace::EncodeValue(Event.Value);
+
+		Ar << Op;
+		Ar.SerializeIntPacked(FrameDelta);
+		Ar.SerializeIntPacked(Value);
+
+		if (Ar.IsLoading())
+		{
+			if (Op >= static_cast<uint8>(EItemTraceOp::TO_Num))
+			{
+				Ar.SetError();
+				return;
+			}
+
+			Event.Op = static_cast<EItemTraceOp>(Op);
+			Event.Frame = PreviousFrame + FrameDelta;
+			Event.Value = ItemManagerTrace::DecodeValue(Value);
+		}
+
+		PreviousFrame = Event.Frame;
+	}
+}
+
+bool FItemManagerTrace::SaveToFile(const FString& FilePath)
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	Serialize(Writer);
+
+	return FFileHelper::SaveArrayToFile(Bytes, *FilePath);
+}
+
+bool FItemManagerTrace::LoadFromFile(const FString& FilePath)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *FilePath))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+	Serialize(Reader);
+
+	return !Reader.IsError();
+}
+
+FItemManagerTraceRecorder::FItemManagerTraceRecorder(uint64 InStartFrame)
+	: StartFrame(InStartFrame)
+{
+}
+
+void FItemManagerTraceRecorder::Record(EItemTraceOp Op, int32 Value)
+{
+	FItemTraceEvent& Event = Trace.Events.AddDefaulted_GetRef();
+	Event.Op = Op;
+	Event.Frame = static_cast<uint32>(GFrameCounter - StartFrame);
+	Event.Value = Value;
+}
+
+void FItemManagerTraceRecorder::RecordAddItem(TSubclassOf<AItemParent> Item)
+{
+	FSoftClassPath const ClassPath(Item.Get());
+	int32 ClassIndex = INDEX_NONE;
+
+	if (const int32* FoundIndex = ClassIndices.Find(ClassPath))
+	{
+		ClassIndex = *FoundIndex;
+	}
+	else
+	{
+		ClassIndex = Trace.Classes.Add(ClassPath);
+		ClassIndices.Add(ClassPath, ClassIndex);
+	}
+
+	Record(EItemTraceOp::TO_AddItem, ClassIndex);
+}
+
+const TCHAR* LexToString(EItemTraceOp Op)
+{
+	return Op < EItemTraceOp::TO_Num ? ItemManagerTrace::OpNames[static_cast<int32>(Op)] : TEXT("Unknown");
+}
+
+void FItemTraceHistogram::Add(double Seconds)
+{
+	double const Microseconds = Seconds * 1000000.0;
+	int32 const Bucket = FMath::Clamp(Microseconds < 1.0 ? 0 : FMath::FloorLog2(static_cast<uint32>(Microseconds)) + 1, 0, NumBuckets - 1);
+
+	Buckets[Bucket]++;
+	Count++;
+	TotalSeconds += Seconds;
+	MaxSeconds = FMath::Max(MaxSeconds, Seconds);
+}
+
+double FItemTraceHistogram::GetPercentileMicroseconds(float Percentile) const
+{
+	uint32 const Threshold = FMath::CeilToInt(Count * Percentile);
+	uint32 Accumulated = 0;
+
+	for (int32 Bucket = 0; Bucket < NumBuckets; Bucket++)
+	{
+		Accumulated += Buckets[Bucket];
+		if (Accumulated >= Threshold && Accumulated > 0)
+		{
+			return static_cast<double>(1ull << Bucket);
+		}
+	}
+
+	return MaxSeconds * 1000000.0;
+}
+
+FItemManagerTraceReplayer::FItemManagerTraceReplayer(const FItemManagerTrace& InTrace, const TArray<UItemManagerComponent*>& InManagers)
+	: Trace(InTrace)
+{
+	for (UItemManagerComponent* Manager : InManagers)
+	{
+		Managers.Add(Manager);
+	}
+
+	// classes are loaded up front so loading does not show in the timings
+	for (const FSoftClassPath& ClassPath : Trace.Classes)
+	{
+		LoadedClasses.Emplace(ClassPath.TryLoadClass<AItemParent>());
+	}
+}
+
+void FItemManagerTraceReplayer::ReplayAll()
+{
+	while (!IsDone())
+	{
+		ReplayEvent(Trace.Events[NextEvent++]);
+	}
+}
+
+bool FItemManagerTraceReplayer::ReplayUntilFrame(uint32 Frame)
+{
+	while (!IsDone() && Trace.Events[NextEvent].Frame <= Frame)
+	{
+		ReplayEvent(Trace.Events[NextEvent++]);
+	}
+
+	return !IsDone();
+}
+
+void FItemManagerTraceReplayer::ReplayEvent(const FItemTraceEvent& Event)
+{
+	FItemTraceHistogram& Histogram = Histograms[static_cast<int32>(Event.Op)];
+
+	for (const TWeakObjectPtr<UItemManagerComponent>& WeakManager : Managers)
+	{
+		UItemManagerComponent* Manager = WeakManager.Get();
+
+		if (!Manager)
+		{
+			continue;
+		}
+
+		uint64 const StartCycles = FPlatformTime::Cycles64();
+
+		switch (Event.Op)
+		{
+			case EItemTraceOp::TO_AddItem:
+				Manager->AddItem(LoadedClasses.IsValidIndex(Event.Value) ? LoadedClasses[Event.Value].Get() : nullptr);
+				break;
+			case EItemTraceOp::TO_SwitchIndexItem:     Manager->SwitchIndexItem(Event.Value); break;
+			case EItemTraceOp::TO_SwitchNextItem:      Manager->SwitchNextItem(); break;
+			case EItemTraceOp::TO_SwitchPreviousItem:  Manager->SwitchPreviousItem(); break;
+			case EItemTraceOp::TO_CollectItem:         Manager->CollectItem(); break;
+			case EItemTraceOp::TO_DropItem:            Manager->DropItem(); break;
+			case EItemTraceOp::TO_UseItem:             Manager->UseItem(); break;
+			default: break;
+		}
+
+		Histogram.Add(FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles));
+	}
+}
+
+void FItemManagerTraceReplayer::DumpReport(FOutputDevice& Ar) const
+{
+	Ar.Logf(TEXT("Item manager trace replay: %d events on %d managers"), NextEvent, Managers.Num());
+	Ar.Logf(TEXT("%-20s %8s %10s %10s %10s %10s %10s"), TEXT("Op"), TEXT("Count"), TEXT("Avg (us)"), TEXT("P50 (us)"), TEXT("P90 (us)"), TEXT("P99 (us)"), TEXT("Max (us)"));
+
+	for (int32 Op = 0; Op < static_cast<int32>(EItemTraceOp::TO_Num); Op++)
+	{
+		const FItemTraceHistogram& Histogram = Histograms[Op];
+
+		if (Histogram.Count == 0)
+		{
+			continue;
+		}
+
+		Ar.Logf(TEXT("%-20s %8u %10.2f %10.0f %10.0f %10.0f %10.2f"),
+			LexToString(static_cast<EItemTraceOp>(Op)),
+			Histogram.Count,
+			Histogram.TotalSeconds * 1000000.0 / Histogram.Count,
+			Histogram.GetPercentileMicroseconds(0.5f),
+			Histogram.GetPercentileMicroseconds(0.9f),
+			Histogram.GetPercentileMicroseconds(0.99f),
+			Histogram.MaxSeconds * 1000000.0);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs ItemManagerTraceStartCommand(
+	TEXT("ItemManager.Trace.Start"),
+	TEXT("Start recording the calls made to every item manager of the world."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		for (UItemManagerComponent* Manager : ItemManagerTrace::GetWorldManagers(World))
+		{
+			Manager->StartTraceRecording();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs ItemManagerTraceStopCommand(
+	TEXT("ItemManager.Trace.Stop"),
+	TEXT("Stop recording and save one trace per item manager. Usage: ItemManager.Trace.Stop [Directory]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		FString const Directory = Args.Num() > 0 ? Args[0] : FPaths::ProfilingDir() / TEXT("ItemManager");
+
+		for (UItemManagerComponent* Manager : ItemManagerTrace::GetWorldManagers(World))
+		{
+			FString const FilePath = Directory / FString::Printf(TEXT("%s_%s.imtrace"), *GetNameSafe(Manager->GetOwner()), *FDateTime::Now().ToString());
+
+			if (Manager->StopTraceRecording(FilePath))
+			{
+				UE_LOG(ItemManager, Display, TEXT("Trace saved to %s"), *FilePath);
+			}
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice ItemManagerTraceReplayCommand(
+	TEXT("ItemManager.Trace.Replay"),
+	TEXT("Replay a trace on every item manager of the world and report the timings of each op. Usage: ItemManager.Trace.Replay <File> [realtime]"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		FItemManagerTrace Trace;
+
+		if (Args.Num() < 1 || !Trace.LoadFromFile(Args[0]))
+		{
+			Ar.Logf(TEXT("Cannot load trace. Usage: ItemManager.Trace.Replay <File> [realtime]"));
+			return;
+		}
+
+		TSharedPtr<FItemManagerTraceReplayer> Replayer = MakeShared<FItemManagerTraceReplayer>(Trace, ItemManagerTrace::GetWorldManagers(World));
+
+		if (Args.Num() < 2 || Args[1] != TEXT("realtime"))
+		{
+			Replayer->ReplayAll();
+			Replayer->DumpReport(Ar);
+			return;
+		}
+
+		// follow the recorded frames, one engine frame at a time
+		FTSTicker::GetCoreTicker().RemoveTicker(ItemManagerTrace::RealTimeTickerHandle);
+		ItemManagerTrace::RealTimeReplayer = Replayer;
+
+		uint64 const StartFrame = GFrameCounter;
+		ItemManagerTrace::RealTimeTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([StartFrame](float DeltaTime)
+		{
+			TSharedPtr<FItemManagerTraceReplayer> ActiveReplayer = ItemManagerTrace::RealTimeReplayer;
+
+			if (ActiveReplayer && ActiveReplayer->ReplayUntilFrame(static_cast<uint32>(GFrameCounter - StartFrame)))
+			{
+				return true;
+			}
+
+			if (ActiveReplayer)
+			{
+				ActiveReplayer->DumpReport(*GLog);
+			}
+
+			ItemManagerTrace::RealTimeReplayer.Reset();
+			return false;
+		}));
+	}));
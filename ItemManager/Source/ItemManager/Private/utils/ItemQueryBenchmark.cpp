@@ -0,0 +1,163 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+
+#include "ItemManagerComponent.h"
+#include "utils/ItemManagerBenchmarkFixture.h"
+#include "HAL/IConsoleManager.h"
+
+class FItemQueryBenchmark
+{
+public:
+
+	static void Run(UWorld* World, int32 MaxItems, const TArray<TSubclassOf<AItemParent>>& ItemClasses, FOutputDevice& Ar)
+	{
+		// queried values, taken from the item classes
+		FGameplayTag Tag;
+		FString NamePrefix;
+		FString NameText;
+
+		for (const TSubclassOf<AItemParent>& ItemClass : ItemClasses)
+		{
+			const AItemParent* ItemDefaults = ItemClass.GetDefaultObject();
+
+			if (!Tag.IsValid() && !ItemDefaults->GetItemTags().IsEmpty())
+			{
+				Tag = ItemDefaults->GetItemTags().First();
+			}
+
+			const FString& FriendlyName = FItemConfigRegistry::Get().GetItemInfos(ItemClass)->FriendlyName;
+			if (NamePrefix.IsEmpty() && FriendlyName.Len() >= 3)
+			{
+				NamePrefix = FriendlyName.Left(2);
+				NameText = FriendlyName.Mid(1, 2);
+			}
+		}
+
+		// no item actor, only the queries are measured
+		UItemManagerComponent* Manager = ItemManagerBenchmarkFixture::SpawnManager(World);
+		if (!Manager)
+		{
+			Ar.Logf(TEXT("Cannot spawn the benchmark actor"));
+			return;
+		}
+
+		Ar.Logf(TEXT("Inventory queries, tag '%s', name prefix '%s', name text '%s'"), *Tag.ToString(), *NamePrefix, *NameText);
+		Ar.Logf(TEXT("%-28s %9s %12s %9s"), TEXT("Query"), TEXT("Items"), TEXT("us/query"), TEXT("Found"));
+
+		for (int32 NumItems = 100; NumItems <= MaxItems; NumItems *= 10)
+		{
+			if (!ItemManagerBenchmarkFixture::FillInventory(Manager, NumItems, ItemClasses))
+			{
+				Ar.Logf(TEXT("Cannot fill the inventory up to %d items"), NumItems);
+				break;
+			}
+
+			// the former way: copy the items and scan them
+			Measure(Ar, TEXT("Get Items + scan (tag)"), NumItems, [Manager, &Tag]()
+			{
+				int32 NumFound = 0;
+				for (const FItemObject& ItemObject : Manager->GetItems())
+				{
+					NumFound += ItemObject.Item && ItemObject.Item.GetDefaultObject()->GetItemTags().HasTag(Tag) ? 1 : 0;
+				}
+				return NumFound;
+			});
+
+			Measure(Ar, TEXT("Get Items + scan (name)"), NumItems, [Manager, &NameText]()
+			{
+				int32 NumFound = 0;
+				for (const FItemObject& ItemObject : Manager->GetItems())
+				{
+					NumFound += ItemObject.GetItemInfos().FriendlyName.Contains(NameText) ? 1 : 0;
+				}
+				return NumFound;
+			});
+
+			Measure(Ar, TEXT("Find Items With Tag"), NumItems, [Manager, &Tag]()
+			{
+				return Manager->FindItemsWithTag(Tag).Num();
+			});
+
+			Measure(Ar, TEXT("Find Droppable Items"), NumItems, [Manager]()
+			{
+				return Manager->FindDroppableItems().Num();
+			});
+
+			Measure(Ar, TEXT("Find Items By Name Prefix"), NumItems, [Manager, &NamePrefix]()
+			{
+				return Manager->FindItemsByNamePrefix(NamePrefix).Num();
+			});
+
+			Measure(Ar, TEXT("Find Items By Name"), NumItems, [Manager, &NameText]()
+			{
+				return Manager->FindItemsByName(NameText).Num();
+			});
+		}
+
+		ItemManagerBenchmarkFixture::DestroyManager(Manager);
+	}
+
+private:
+
+	// each query is repeated until it ran this long
+	static constexpr double MinSeconds = 0.02;
+
+	template <typename QueryType>
+	static void Measure(FOutputDevice& Ar, const TCHAR* Name, int32 NumItems, QueryType&& Query)
+	{
+		int32 NumQueries = 0;
+		int32 NumFound = 0;
+
+		const double StartTime = FPlatformTime::Seconds();
+		double Seconds = 0.0;
+
+		while (Seconds < MinSeconds)
+		{
+			NumFound = Query();
+			NumQueries++;
+			Seconds = FPlatformTime::Seconds() - StartTime;
+		}
+
+		Ar.Logf(TEXT("%-28s %9d %12.3f %9d"), Name, NumItems, Seconds * 1000000.0 / NumQueries, NumFound);
+	}
+};
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice ItemQueryBenchmarkCommand(
+	TEXT("ItemManager.Query.Benchmark"),
+	TEXT("Measure the inventory queries against a copy and scan of Get Items, from 100 items up to MaxItems. Use tagged and named item classes. Usage: ItemManager.Query.Benchmark [MaxItems=10000] [ItemClassPath+ItemClassPath...]"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		if (!World)
+		{
+			Ar.Logf(TEXT("No world to run the benchmark in"));
+			return;
+		}
+
+		const int32 MaxItems = Args.Num() > 0 ? FMath::Clamp(FCString::Atoi(*Args[0]), 100, 1000000) : 10000;
+
+		TArray<TSubclassOf<AItemParent>> ItemClasses;
+		if (Args.Num() > 1)
+		{
+			TArray<FString> Paths;
+			Args[1].ParseIntoArray(Paths, TEXT("+"));
+
+			for (const FString& Path : Paths)
+			{
+				if (UClass* ItemClass = FSoftClassPath(Path).TryLoadClass<AItemParent>())
+				{
+					ItemClasses.Add(ItemClass);
+				}
+				else
+				{
+					Ar.Logf(TEXT("Cannot load item class %s"), *Path);
+				}
+			}
+		}
+
+		if (ItemClasses.Num() <= 0)
+		{
+			ItemClasses.Add(AItemParent::StaticClass());
+		}
+
+		FItemQueryBenchmark::Run(World, MaxItems, ItemClasses, Ar);
+	}));
@@ -0,0 +1,306 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+
+#include "utils/ItemTimingWheel.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+#include "HAL/IConsoleManager.h"
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice ItemTimerBenchmarkCommand(
+	TEXT("ItemManager.Timers.Benchmark"),
+	TEXT("Compare the cost of the world timer manager and of the item timing wheel for switch timers. Usage: ItemManager.Timers.Benchmark [NumTimers]"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		const int32 NumTimers = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10000;
+
+		// same delays as switching items, one timer out of two cancelled by a new switch
+		FRandomStream RandomStream(0);
+		TArray<float> Delays;
+		Delays.SetNumUninitialized(NumTimers);
+		for (float& Delay : Delays)
+		{
+			Delay = RandomStream.FRandRange(0.1f, 2.f);
+		}
+
+		// the timer manager only ticks once per engine frame, only schedule and cancel are compared
+		FTimerManager TimerManager;
+		TArray<FTimerHandle> TimerHandles;
+		TimerHandles.SetNum(NumTimers);
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 TimerIndex = 0; TimerIndex < NumTimers; TimerIndex++)
+		{
+			TimerManager.SetTimer(TimerHandles[TimerIndex], FTimerDelegate::CreateLambda([]() {}), Delays[TimerIndex], false);
+		}
+		for (int32 TimerIndex = 0; TimerIndex < NumTimers; TimerIndex += 2)
+		{
+			TimerManager.ClearTimer(TimerHandles[TimerIndex]);
+		}
+		const double TimerManagerSeconds = FPlatformTime::Seconds() - StartTime;
+
+		FItemTimingWheel TimingWheel;
+		TArray<FItemTimerHandle> WheelHandles;
+		WheelHandles.SetNum(NumTimers);
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 TimerIndex = 0; TimerIndex < NumTimers; TimerIndex++)
+		{
+			WheelHandles[TimerIndex] = TimingWheel.Schedule(0.0, Delays[TimerIndex], FItemTimer());
+		}
+		for (int32 TimerIndex = 0; TimerIndex < NumTimers; TimerIndex += 2)
+		{
+			TimingWheel.Cancel(WheelHandles[TimerIndex]);
+		}
+		const double WheelSeconds = FPlatformTime::Seconds() - StartTime;
+
+		// dispatch of the remaining timers over 2.5 seconds at 60 fps
+		int32 NumFiredTimers = 0;
+		TArray<FItemTimerHandle> ExpiredTimers;
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 FrameIndex = 0; FrameIndex < 150; FrameIndex++)
+		{
+			ExpiredTimers.Reset();
+			TimingWheel.Advance((FrameIndex + 1) / 60.0, ExpiredTimers);
+
+			FItemTimer Timer;
+			for (const FItemTimerHandle& Handle : ExpiredTimers)
+			{
+				NumFiredTimers += TimingWheel.Consume(Handle, Timer) ? 1 : 0;
+			}
+		}
+		const double DispatchSeconds = FPlatformTime::Seconds() - StartTime;
+
+		Ar.Logf(TEXT("%d timers scheduled, half of them cancelled"), NumTimers);
+		Ar.Logf(TEXT("  Timer manager: %.3f ms"), TimerManagerSeconds * 1000.0);
+		Ar.Logf(TEXT("  Timing wheel:  %.3f ms"), WheelSeconds * 1000.0);
+		Ar.Logf(TEXT("  Timing wheel dispatch, 150 frames: %.3f ms (%d fired)"), DispatchSeconds * 1000.0, NumFiredTimers);
+
+		for (FTimerHandle& TimerHandle : TimerHandles)
+		{
+			TimerManager.ClearTimer(TimerHandle);
+		}
+	}));
+
+FItemTimingWheel::FItemTimingWheel(double InTickSeconds)
+	: TickSeconds(FMath::Max(InTickSeconds, UE_DOUBLE_KINDA_SMALL_NUMBER))
+{
+	for (int32 Bucket = 0; Bucket < NumLevels * NumSlots; Bucket++)
+	{
+		Heads[Bucket] = INDEX_NONE;
+		Tails[Bucket] = INDEX_NONE;
+	}
+}
+
+void FItemTimingWheel::Start(double Now)
+{
+	CurrentTick = static_cast<uint64>(FMath::Max(FMath::FloorToDouble(Now / TickSeconds), 0.0));
+	bIsStarted = true;
+}
+
+FItemTimerHandle FItemTimingWheel::Schedule(double Now, float Delay, const FItemTimer& Timer)
+{
+	if (!bIsStarted)
+	{
+		Start(Now);
+	}
+
+	int32 EntryIndex;
+	if (FreeEntries.Num() > 0)
+	{
+		EntryIndex = FreeEntries.Pop(EAllowShrinking::No);
+	}
+	else
+	{
+		EntryIndex = Entries.AddDefaulted();
+	}
+
+	FEntry& Entry = Entries[EntryIndex];
+	Entry.Timer = Timer;
+
+	// rounded up, a timer never fires early
+	const uint64 DueTick = static_cast<uint64>(FMath::Max(FMath::CeilToDouble((Now + FMath::Max(Delay, 0.f)) / TickSeconds), 0.0));
+	Entry.DueTick = FMath::Max(DueTick, CurrentTick + 1);
+
+	Link(EntryIndex);
+
+	FItemTimerHandle Handle;
+	Handle.Index = EntryIndex;
+	Handle.Serial = Entry.Serial;
+	return Handle;
+}
+
+bool FItemTimingWheel::Cancel(FItemTimerHandle& Handle)
+{
+	const bool bIsPending = IsPending(Handle);
+
+	if (bIsPending)
+	{
+		if (Entries[Handle.Index].Bucket != INDEX_NONE)
+		{
+			Unlink(Handle.Index);
+		}
+
+		Release(Handle.Index);
+	}
+
+	Handle.Invalidate();
+	return bIsPending;
+}
+
+bool FItemTimingWheel::IsPending(const FItemTimerHandle& Handle) const
+{
+	return Handle.IsValid() && Entries.IsValidIndex(Handle.Index) && Entries[Handle.Index].Serial == Handle.Serial;
+}
+
+void FItemTimingWheel::Advance(double Now, TArray<FItemTimerHandle>& OutExpired)
+{
+	if (!bIsStarted)
+	{
+		Start(Now);
+		return;
+	}
+
+	const uint64 TargetTick = static_cast<uint64>(FMath::Max(FMath::FloorToDouble(Now / TickSeconds), 0.0));
+
+	while (CurrentTick < TargetTick)
+	{
+		// nothing to visit, jump to the end
+		if (NumTimers <= 0)
+		{
+			CurrentTick = TargetTick;
+			break;
+		}
+
+		CurrentTick++;
+
+		// higher levels first, their timers may land in the lower slot cascaded right after
+		int32 CascadeLevel = 0;
+		while (CascadeLevel + 1 < NumLevels && (CurrentTick & ((uint64(1) << (SlotBits * (CascadeLevel + 1))) - 1)) == 0)
+		{
+			CascadeLevel++;
+		}
+
+		for (int32 Level = CascadeLevel; Level > 0; Level--)
+		{
+			CascadeBucket(Level * NumSlots + static_cast<int32>((CurrentTick >> (SlotBits * Level)) & SlotMask));
+		}
+
+		const int32 Bucket = static_cast<int32>(CurrentTick & SlotMask);
+		while (Heads[Bucket] != INDEX_NONE)
+		{
+			const int32 EntryIndex = Heads[Bucket];
+			Unlink(EntryIndex);
+
+			FItemTimerHandle Handle;
+			Handle.Index = EntryIndex;
+			Handle.Serial = Entries[EntryIndex].Serial;
+			OutExpired.Add(Handle);
+		}
+	}
+}
+
+bool FItemTimingWheel::Consume(const FItemTimerHandle& Handle, FItemTimer& OutTimer)
+{
+	if (!IsPending(Handle) || Entries[Handle.Index].Bucket != INDEX_NONE)
+	{
+		return false;
+	}
+
+	OutTimer = MoveTemp(Entries[Handle.Index].Timer);
+	Release(Handle.Index);
+	return true;
+}
+
+void FItemTimingWheel::Link(int32 EntryIndex)
+{
+	FEntry& Entry = Entries[EntryIndex];
+
+	// past the last level, parked in its farthest slot and cascaded again until close enough
+	const uint64 MaxDelta = (uint64(1) << (SlotBits * NumLevels)) - 1;
+	const uint64 Delta = Entry.DueTick > CurrentTick ? Entry.DueTick - CurrentTick : 0;
+	const uint64 SlotTick = CurrentTick + FMath::Min(Delta, MaxDelta);
+
+	int32 Level = 0;
+	while (Level + 1 < NumLevels && FMath::Min(Delta, MaxDelta) >= (uint64(1) << (SlotBits * (Level + 1))))
+	{
+		Level++;
+	}
+
+	const int32 Bucket = Level * NumSlots + static_cast<int32>((SlotTick >> (SlotBits * Level)) & SlotMask);
+
+	// appended, timers due on the same tick fire in schedule order
+	Entry.Bucket = Bucket;
+	Entry.Prev = Tails[Bucket];
+	Entry.Next = INDEX_NONE;
+
+	if (Tails[Bucket] != INDEX_NONE)
+	{
+		Entries[Tails[Bucket]].Next = EntryIndex;
+	}
+	else
+	{
+		Heads[Bucket] = EntryIndex;
+	}
+	Tails[Bucket] = EntryIndex;
+
+	NumTimers++;
+}
+
+void FItemTimingWheel::Unlink(int32 EntryIndex)
+{
+	FEntry& Entry = Entries[EntryIndex];
+
+	if (Entry.Prev != INDEX_NONE)
+	{
+		Entries[Entry.Prev].Next = Entry.Next;
+	}
+	else
+	{
+		Heads[Entry.Bucket] = Entry.Next;
+	}
+
+	if (Entry.Next != INDEX_NONE)
+	{
+		Entries[Entry.Next].Prev = Entry.Prev;
+	}
+	else
+	{
+		Tails[Entry.Bucket] = Entry.Prev;
+	}
+
+	Entry.Prev = INDEX_NONE;
+	Entry.Next = INDEX_NONE;
+	Entry.Bucket = INDEX_NONE;
+
+	NumTimers--;
+}
+
+void FItemTimingWheel::Release(int32 EntryIndex)
+{
+	FEntry& Entry = Entries[EntryIndex];
+	Entry.Timer = FItemTimer();
+
+	// outstanding handles of this entry become stale
+	Entry.Serial++;
+
+	FreeEntries.Add(EntryIndex);
+}
+
+void FItemTimingWheel::CascadeBucket(int32 Bucket)
+{
+	int32 EntryIndex = Heads[Bucket];
+
+	Heads[Bucket] = INDEX_NONE;
+	Tails[Bucket] = INDEX_NONE;
+
+	while (EntryIndex != INDEX_NONE)
+	{
+		const int32 NextIndex = Entries[EntryIndex].Next;
+
+		NumTimers--;
+		Link(EntryIndex);
+
+		EntryIndex = NextIndex;
+	}
+}
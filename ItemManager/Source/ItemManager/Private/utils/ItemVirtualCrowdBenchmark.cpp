@@ -0,0 +1,110 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+
+#include "ItemManagerComponent.h"
+#include "utils/ItemManagerBenchmarkFixture.h"
+#include "HAL/IConsoleManager.h"
+
+class FItemVirtualCrowdBenchmark
+{
+public:
+
+	static void Run(UWorld* World, int32 NumOwners, int32 NumSwitches, TSubclassOf<AItemParent> ItemClass, FOutputDevice& Ar)
+	{
+		Ar.Logf(TEXT("Item manager crowd: %d owners, %d switches each, item %s"), NumOwners, NumSwitches, *GetNameSafe(ItemClass));
+		Ar.Logf(TEXT("%-14s %14s %12s %12s %12s"), TEXT("Managers"), TEXT("us/switch"), TEXT("Actors"), TEXT("Ticking"), TEXT("Actors KB"));
+
+		RunCrowd(World, NumOwners, NumSwitches, ItemClass, false, Ar);
+		RunCrowd(World, NumOwners, NumSwitches, ItemClass, true, Ar);
+	}
+
+private:
+
+	// every owner holds this many items besides the empty item
+	static constexpr int32 NumItemsPerOwner = 3;
+
+	static void RunCrowd(UWorld* World, int32 NumOwners, int32 NumSwitches, TSubclassOf<AItemParent> ItemClass, bool bVirtual, FOutputDevice& Ar)
+	{
+		TArray<UItemManagerComponent*> Managers;
+
+		for (int32 OwnerIndex = 0; OwnerIndex < NumOwners; OwnerIndex++)
+		{
+			const FVector Location((OwnerIndex % 100) * 200.f, (OwnerIndex / 100) * 200.f, 0.f);
+
+			if (UItemManagerComponent* Manager = ItemManagerBenchmarkFixture::SpawnManager(World, Location, bVirtual))
+			{
+				ItemManagerBenchmarkFixture::FillInventory(Manager, Manager->GetNumItems() + NumItemsPerOwner, { ItemClass });
+				Managers.Add(Manager);
+			}
+		}
+
+		// switch traffic of the crowd, item delays of 0 switch right away
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 SwitchIndex = 0; SwitchIndex < NumSwitches; SwitchIndex++)
+		{
+			for (UItemManagerComponent* Manager : Managers)
+			{
+				Manager->SwitchNextItem();
+			}
+		}
+		const double SwitchSeconds = FPlatformTime::Seconds() - StartTime;
+
+		// what the crowd keeps alive once the switches are done
+		int32 NumActors = 0;
+		int32 NumTickingActors = 0;
+		int64 ActorBytes = 0;
+
+		for (UItemManagerComponent* Manager : Managers)
+		{
+			for (const FItemObject& ItemObject : Manager->GetItems())
+			{
+				if (IsValid(ItemObject.Actor))
+				{
+					NumActors++;
+					NumTickingActors += ItemObject.Actor->IsActorTickEnabled() ? 1 : 0;
+					ActorBytes += ItemManagerMemReport::GetActorResourceSize(ItemObject.Actor);
+				}
+			}
+		}
+
+		for (UItemManagerComponent* Manager : Managers)
+		{
+			ItemManagerBenchmarkFixture::DestroyManager(Manager);
+		}
+
+		const int32 NumTotalSwitches = FMath::Max(NumSwitches * Managers.Num(), 1);
+
+		Ar.Logf(TEXT("%-14s %14.3f %12d %12d %12lld"), bVirtual ? TEXT("Virtual") : TEXT("Materialized"), SwitchSeconds * 1000000.0 / NumTotalSwitches, NumActors, NumTickingActors, ActorBytes / 1024);
+	}
+};
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice ItemVirtualCrowdBenchmarkCommand(
+	TEXT("ItemManager.Virtual.Benchmark"),
+	TEXT("Compare a crowd of materialized item managers with the same crowd of virtual ones: switch cost, item actors kept alive and their memory. Usage: ItemManager.Virtual.Benchmark [NumOwners=300] [NumSwitches=100] [ItemClassPath]"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		if (!World)
+		{
+			Ar.Logf(TEXT("No world to run the benchmark in"));
+			return;
+		}
+
+		const int32 NumOwners = Args.Num() > 0 ? FMath::Clamp(FCString::Atoi(*Args[0]), 1, 10000) : 300;
+		const int32 NumSwitches = Args.Num() > 1 ? FMath::Clamp(FCString::Atoi(*Args[1]), 1, 100000) : 100;
+
+		TSubclassOf<AItemParent> ItemClass = AItemParent::StaticClass();
+		if (Args.Num() > 2)
+		{
+			if (UClass* LoadedClass = FSoftClassPath(Args[2]).TryLoadClass<AItemParent>())
+			{
+				ItemClass = LoadedClass;
+			}
+			else
+			{
+				Ar.Logf(TEXT("Cannot load item class %s"), *Args[2]);
+				return;
+			}
+		}
+
+		FItemVirtualCrowdBenchmark::Run(World, NumOwners, NumSwitches, ItemClass, Ar);
+	}));
@@ -72,13 +72,13 @@ struct FItemCollectableData
 
     TSubclassOf<AItemParent> Item;
     FVector Size{ 50.f, 50.f, 50.f };
-    EItemDisplay ItemDisplay;
+    EItemDisplay ItemDisplay = EItemDisplay::ID_None;
     FGroundTypeProperties GroundTypeProperties;
     FAnimatedItemProperties AnimatedItemProperties;
-    bool bEnableCollisions;
-    bool bEnableTransparency;
-    bool bEnableOutline;
-    UMaterialInstance* OutlineMaterial;
+    bool bEnableCollisions{ false };
+    bool bEnableTransparency{ false };
+    bool bEnableOutline{ true };
+    UMaterialInstance* OutlineMaterial = nullptr;
 };
 
 UCLASS()
@@ -93,7 +93,9 @@ public:
 
     virtual void Tick(float DeltaTime) override;
 
-    void Init(FItemCollectableData ItemCollectableData);
+    void Init(const FItemCollectableData& ItemCollectableData);
+
+    USkeletalMeshComponent* GetSkeletalMesh() const { return SkeletalMesh; }
 
     UFUNCTION(BlueprintPure, BlueprintCallable, meta = (DisplayName = "Get Item", ToolTip = "Get the collectable item"), Category = "Item")
     TSubclassOf<AItemParent> GetItem() const { return Item; }
@@ -131,11 +133,26 @@ public:
     UFUNCTION(BlueprintCallable, meta = (DisplayName = "Disable Transparency", ToolTip = ""), Category = "Item")
     void DisableTransparency();
 
+    // Resolve the mesh and the ground placement now and keep the result with the level.
+    // OnConstruction skips SetupMesh and PlaceMeshToTheGround while the actor and its settings are unchanged.
+    void BakePlacement();
+
+    bool HasBakedPlacement() const { return bHasBakedPlacement; }
+
+    UFUNCTION(BlueprintPure, BlueprintCallable, meta = (DisplayName = "Get Instance State", ToolTip = "State of the item instance on the ground, empty for the defaults of the item"), Category = "Item")
+    const FInstancedStruct& GetInstanceState() const { return InstanceState; }
+
+    // Given by the item manager dropping the item, handed back to the one collecting it
+    void SetInstanceState(const FInstancedStruct& InInstanceState) { InstanceState = InInstanceState; }
+
 private:
     
     UPROPERTY(EditAnywhere, meta = (DisplayName = "Item To Be Collected", ToolTip = "Select item you want to be collectable here."), Category = "Item")
     TSubclassOf<AItemParent> Item;
 
+    UPROPERTY(EditAnywhere, meta = (DisplayName = "Instance State", ToolTip = "State of this item instance (ammo, durability...). Leave empty to use the defaults of the item."), Category = "Item")
+    FInstancedStruct InstanceState;
+
     UPROPERTY(EditAnywhere, meta = (DisplayName = "Trigger Item Size", ToolTip = "Set the Size of the trigger box"), Category = "Item")
     FVector Size{ 50.f, 50.f, 50.f };
 
@@ -157,27 +174,49 @@ private:
     UPROPERTY(EditAnywhere, meta = (DisplayName = "Enable Outine", ToolTip = "Outline will appear when the actor overlap the trigger box "), Category = "Item")
     bool bEnableOutline{ true };
 
-    UPROPERTY(EditAnywhere,meta = (DisplayName = "Outline Material", ToolTip = "", EditCondition = "bEnableOutline"), Category = "Item")
+    UPROPERTY(EditAnywhere,meta = (DisplayName = "Outline Material", ToolTip = "Leave empty to use the outline material of the project settings", EditCondition = "bEnableOutline"), Category = "Item")
     UMaterialInstance* OutlineMaterial;
 
+    UPROPERTY(VisibleAnywhere, meta = (DisplayName = "Skeletal Mesh"), Category = "Item")
     USkeletalMeshComponent* SkeletalMesh;
+
+    UPROPERTY(VisibleAnywhere, meta = (DisplayName = "Scene Root"), Category = "Item")
     USceneComponent* SceneComponent;
+
+    UPROPERTY(VisibleAnywhere, meta = (DisplayName = "Trigger Box"), Category = "Item")
     UBoxComponent* TriggerBoxComponent;
-    UClass* ItemClass;
-    AItemParent* ItemInstance;
 
+    // written by BakePlacement, see the ItemCollectableAudit commandlet
+    UPROPERTY(VisibleAnywhere, AdvancedDisplay, meta = (DisplayName = "Has Baked Placement", ToolTip = "Mesh and ground placement have been baked. Moving the actor or changing its settings clears it."), Category = "Item")
+    bool bHasBakedPlacement = false;
+
+    UPROPERTY()
+    uint32 BakedPlacementHash = 0;
+
+    UPROPERTY()
+    FTransform BakedActorTransform;
+
+    UPROPERTY()
     float MeshHeight = 0.0f;
+
+    UPROPERTY()
     float MeshWidth = 0.0f;
+
     float AnimatedRunningTime = 0.0f;
     bool bAnimatedGoingUp = true;
     bool bCacheInvertGroundRotation = GroundTypeProperties.bInvertGroundRotation;
     
 	virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+    virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
     virtual void OnConstruction(const FTransform& Transform) override;
 
-    void SetItemInstance();
+    // Mesh and collect rules are read on the item class defaults, no item is instanced
+    AItemParent* GetItemDefaults() const { return Item ? Item.GetDefaultObject() : nullptr; }
     void SetupMesh();
     void PlaceMeshToTheGround();
+    uint32 GetPlacementHash() const;
+    bool IsPlacementBaked() const;
     void AnimatedMesh(float DeltaTime);
     void EnableCollisions();
     void DisableCollisions();
@@ -0,0 +1,144 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "GameplayTagContainer.h"
+#include "ItemParent.h"
+#include "ItemCollectable.h"
+#include "ItemLootTable.generated.h"
+
+class UItemLootTable;
+
+USTRUCT(BlueprintType)
+struct FItemLootEntry
+{
+    GENERATED_USTRUCT_BODY()
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (DisplayName = "Item", ToolTip = "Item given by this entry. Leave empty with no nested table to make a 'nothing' entry."), Category = "Loot")
+    TSubclassOf<AItemParent> Item;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (DisplayName = "Nested Table", ToolTip = "If set, the nested table is rolled instead of giving Item."), Category = "Loot")
+    TObjectPtr<UItemLootTable> NestedTable;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (DisplayName = "Weight", ClampMin = "0"), Category = "Loot")
+    float Weight{ 1.f };
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (DisplayName = "Min Quantity", ClampMin = "0"), Category = "Loot")
+    int32 MinQuantity{ 1 };
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (DisplayName = "Max Quantity", ClampMin = "0"), Category = "Loot")
+    int32 MaxQuantity{ 1 };
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (DisplayName = "Condition", ToolTip = "The entry can only be drawn if the loot context tags match this query. An empty query always matches."), Category = "Loot")
+    FGameplayTagQuery Condition;
+};
+
+/**
+ * Alias method sampling table (Vose). Built in O(n), each draw is O(1): one uniform column and one coin flip.
+ */
+struct ITEMMANAGER_API FItemLootAliasTable
+{
+    TArray<float> Probabilities;
+    TArray<int32> Aliases;
+
+    void Build(const TArray<float>& Weights);
+
+    int32 Sample(const FRandomStream& RandomStream) const;
+
+    bool IsEmpty() const { return Probabilities.Num() <= 0; }
+};
+
+/**
+ * A loot table compiled for one set of context tags. Immutable once built, so it can be sampled from any thread.
+ */
+class ITEMMANAGER_API FItemLootSampler
+{
+public:
+
+    // Draw the table rolls and append the results to OutLoot
+    void Draw(const FRandomStream& RandomStream, TArray<TSharedRef<const FItemCollectableData>>& OutLoot) const;
+
+private:
+
+    friend class UItemLootTable;
+
+    struct FCompiledEntry
+    {
+        TSharedPtr<const FItemCollectableData> ItemCollectableData;
+        TSharedPtr<const FItemLootSampler> NestedSampler;
+        int32 MinQuantity = 1;
+        int32 MaxQuantity = 1;
+    };
+
+    TArray<FCompiledEntry> Entries;
+    FItemLootAliasTable AliasTable;
+    int32 MinRolls = 1;
+    int32 MaxRolls = 1;
+};
+
+// Results of a batch, the loot of draw i is Loot[DrawOffsets[i], DrawOffsets[i + 1])
+struct FItemLootBatch
+{
+    TArray<TSharedRef<const FItemCollectableData>> Loot;
+    TArray<int32> DrawOffsets;
+
+    // optional, state of each loot entry when spilling existing items
+    TArray<FInstancedStruct> InstanceStates;
+
+    int32 GetNumDraws() const { return FMath::Max(DrawOffsets.Num() - 1, 0); }
+};
+
+/**
+ * Weighted loot table with nested tables, quantity ranges and tag conditions.
+ * The table is compiled into alias tables the first time it is drawn with a given set of context tags.
+ * Draws only depend on the seed: the same seed always gives the same loot, whatever the number of threads.
+ */
+UCLASS(BlueprintType)
+class ITEMMANAGER_API UItemLootTable : public UDataAsset
+{
+    GENERATED_BODY()
+
+public:
+
+    // Return the table compiled for ContextTags. Must be called from the game thread.
+    TSharedRef<const FItemLootSampler> GetSampler(const FGameplayTagContainer& ContextTags);
+
+    // Draw the table once
+    void GenerateLoot(int32 Seed, const FGameplayTagContainer& ContextTags, TArray<TSharedRef<const FItemCollectableData>>& OutLoot);
+
+    // Draw the table NumDraws times, in parallel. Draw i uses a seed derived from Seed and i.
+    void GenerateLootBatch(int32 Seed, int32 NumDraws, const FGameplayTagContainer& ContextTags, FItemLootBatch& OutBatch);
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Generate Loot", ToolTip = "Draw the loot table once. The same seed always gives the same items."), Category = "Item Manager|Loot")
+    TArray<TSubclassOf<AItemParent>> GenerateLootItems(int32 Seed, FGameplayTagContainer ContextTags);
+
+    // Release the compiled tables, they will be compiled again on the next draw
+    void InvalidateSamplers();
+
+#if WITH_EDITOR
+    virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+protected:
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (DisplayName = "Entries"), Category = "Loot")
+    TArray<FItemLootEntry> Entries;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (DisplayName = "Min Rolls", ToolTip = "Minimum number of entries drawn each time the table is rolled", ClampMin = "0"), Category = "Loot")
+    int32 MinRolls{ 1 };
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (DisplayName = "Max Rolls", ToolTip = "Maximum number of entries drawn each time the table is rolled", ClampMin = "0"), Category = "Loot")
+    int32 MaxRolls{ 1 };
+
+private:
+
+    // compiled tables by context tags, few different contexts are used per table
+    TArray<TPair<FGameplayTagContainer, TSharedRef<const FItemLootSampler>>> Samplers;
+
+    // guards against tables nesting themselves
+    bool bIsCompiling = false;
+
+    TSharedRef<const FItemLootSampler> Compile(const FGameplayTagContainer& ContextTags);
+};
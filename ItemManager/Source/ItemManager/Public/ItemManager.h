@@ -12,4 +12,13 @@ public:
 	/** IModuleInterface implementation */
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
+
+private:
+
+	FDelegateHandle PostEngineInitHandle;
+
+#if WITH_EDITOR
+	FDelegateHandle ObjectsReinstancedHandle;
+	FDelegateHandle ObjectPropertyChangedHandle;
+#endif
 };
@@ -0,0 +1,61 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "Materials/MaterialInstance.h"
+#include "ItemManagerSettings.generated.h"
+
+struct FStreamableHandle;
+
+/**
+ * Assets shared by every collectable and post process volume of the plugin, in Project Settings > Plugins > Item Manager.
+ * They are loaded asynchronously once, after engine init and when a world starts, and kept loaded by the preload handle,
+ * so no constructor has to load them while a level is loading.
+ */
+UCLASS(Config = Game, DefaultConfig, meta = (DisplayName = "Item Manager"))
+class ITEMMANAGER_API UItemManagerSettings : public UDeveloperSettings
+{
+    GENERATED_BODY()
+
+public:
+
+    UItemManagerSettings();
+
+    static UItemManagerSettings* Get() { return GetMutableDefault<UItemManagerSettings>(); }
+
+    virtual FName GetCategoryName() const override { return TEXT("Plugins"); }
+
+#if WITH_EDITOR
+    virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+    // Start the async load of the shared assets, does nothing if already requested. Visual assets are skipped in server mode.
+    void RequestSharedAssetsPreload();
+
+    // Loaded shared assets, loaded synchronously if the preload is not done yet
+    UMaterialInstance* GetOutlineMaterial() const;
+    UMaterialInstance* GetTransparencyPostProcessMaterial() const;
+
+    bool HasOutlineMaterial() const { return !OutlineMaterial.IsNull(); }
+
+    bool IsSharedAssetsPreloaded() const { return PreloadSeconds > 0.0; }
+
+    // Time from the preload request to the loaded assets
+    double GetSharedAssetsPreloadSeconds() const { return PreloadSeconds; }
+
+private:
+
+    UPROPERTY(Config, EditAnywhere, meta = (DisplayName = "Outline Material", ToolTip = "Overlay material of the collectables overlapped by an item manager, unless a collectable sets its own"), Category = "Materials")
+    TSoftObjectPtr<UMaterialInstance> OutlineMaterial;
+
+    UPROPERTY(Config, EditAnywhere, meta = (DisplayName = "Transparency Post Process Material", ToolTip = "Blendable added by the Item Manager Post Process Volume"), Category = "Materials")
+    TSoftObjectPtr<UMaterialInstance> TransparencyPostProcessMaterial;
+
+    TSharedPtr<FStreamableHandle> PreloadHandle;
+    double PreloadStartTime = 0.0;
+    double PreloadSeconds = 0.0;
+
+    void OnSharedAssetsPreloaded();
+};
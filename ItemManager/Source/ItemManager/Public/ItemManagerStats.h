@@ -0,0 +1,9 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+// 'stat ItemManager' in the console to display every counter of the plugin
+DECLARE_STATS_GROUP(TEXT("ItemManager"), STATGROUP_ItemManager, STATCAT_Advanced);
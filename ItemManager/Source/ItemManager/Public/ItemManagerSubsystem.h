@@ -0,0 +1,166 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ItemCollectable.h"
+#include "ItemLootTable.h"
+#include "utils/ItemManagerEventBus.h"
+#include "utils/ItemTimingWheel.h"
+#include "ItemManagerSubsystem.generated.h"
+
+class UItemManagerComponent;
+
+enum class EItemScheduledRequest : uint8
+{
+    SR_SpawnCollectable,
+    SR_DestroyActor,
+    SR_PrewarmItemActor
+};
+
+struct FItemScheduledRequest
+{
+    EItemScheduledRequest Type = EItemScheduledRequest::SR_SpawnCollectable;
+
+    // spawn request
+    TSharedPtr<const FItemCollectableData> ItemCollectableData;
+    FInstancedStruct InstanceState;
+    FTransform Transform;
+    TWeakObjectPtr<UItemManagerComponent> Requester;
+
+    // destroy request
+    TWeakObjectPtr<AActor> Actor;
+
+    // prewarm request
+    TSubclassOf<AItemParent> ItemClass;
+
+    // squared distance to the closest player, refreshed every frame
+    float Priority = 0.f;
+
+    // queue order, breaks the priority ties
+    uint64 Sequence = 0;
+};
+
+struct FItemActorPoolStats
+{
+    // spawns served by a pooled actor
+    int32 Hits = 0;
+    int32 Misses = 0;
+
+    // components registered by the missed spawns, none for a hit
+    int32 RegisteredComponents = 0;
+
+    double SpawnSeconds = 0.0;
+    double ReuseSeconds = 0.0;
+};
+
+/**
+ * World level services shared by every Item Manager.
+ * Spawns and destroys of item actors are queued here and processed within a per-frame budget,
+ * closest to the players first, so loot bursts do not spike the frame.
+ * The switch, spawn and despawn delays of the item managers share one timing wheel, dispatched once per frame.
+ * Despawned item actors are pooled by class, so picking up, dropping and switching items do not spawn new actors.
+ */
+UCLASS()
+class ITEMMANAGER_API UItemManagerSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+    // Queue an ItemCollectable spawn. The collectable is registered to Requester once spawned.
+    void EnqueueSpawnCollectable(const TSharedRef<const FItemCollectableData>& ItemCollectableData, const FTransform& Transform, UItemManagerComponent* Requester, const FInstancedStruct& InstanceState = FInstancedStruct());
+
+    // Queue an actor destroy. The actor is hidden right away, the destroy itself happens later.
+    void EnqueueDestroyActor(AActor* Actor);
+
+    // Draw a loot table and queue its collectables, spread on a circle of Radius around Origin
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Spawn Loot", ToolTip = "Draw a loot table and spawn its items as collectables around Origin.\nThe same seed always gives the same items. Return the number of collectables queued."), Category = "Item Manager|Loot")
+    int32 SpawnLoot(UItemLootTable* LootTable, FTransform Origin, float Radius, int32 Seed, FGameplayTagContainer ContextTags);
+
+    // Queue the collectables of a batch, draw i is spawned around Origins[i]
+    void SpawnLootBatch(const FItemLootBatch& Batch, const TArray<FTransform>& Origins, float Radius);
+
+    // Process every queued request, ignoring the budget
+    void FlushScheduledRequests();
+
+    int32 GetNumScheduledRequests() const { return ScheduledRequests.Num(); }
+
+    // Fire a lifecycle timer of an item manager after Delay seconds of game time
+    FItemTimerHandle ScheduleItemTimer(const FItemTimer& Timer, float Delay);
+
+    // Remove a pending timer and invalidate its handle
+    void CancelItemTimer(FItemTimerHandle& Handle);
+
+    int32 GetNumItemTimers() const { return TimingWheel.Num(); }
+
+    // Spawn an item actor, or take a pooled one of the same class
+    AItemParent* SpawnItemActor(TSubclassOf<AItemParent> Item, const FTransform& Transform);
+
+    // Keep a despawned item actor hidden and dormant for the next spawn of its class, destroyed if the pool is full
+    void ReleaseItemActor(AItemParent* ItemActor);
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Prewarm Item Actors", ToolTip = "Spawn hidden actors of Item within the scheduler budget, so the next equips of this item do not spawn anything.\nCount is the number of pooled actors wanted, limited by ItemManager.Pool.MaxPerClass."), Category = "Item Manager|Pool")
+    void PrewarmItemActors(TSubclassOf<AItemParent> Item, int32 Count = 1);
+
+    UFUNCTION(BlueprintPure, meta = (DisplayName = "Get Num Pooled Item Actors"), Category = "Item Manager|Pool")
+    int32 GetNumPooledItemActors(TSubclassOf<AItemParent> Item) const;
+
+    bool IsPooledItemActor(const AItemParent* ItemActor) const;
+    const FItemActorPoolStats& GetItemActorPoolStats() const { return PoolStats; }
+
+    // Publish the inventory snapshot of Manager at the next tick, see UItemManagerComponent::GetInventorySnapshot
+    void RequestSnapshotPublish(UItemManagerComponent* Manager);
+
+    void RegisterManager(UItemManagerComponent* Manager);
+    void UnregisterManager(UItemManagerComponent* Manager);
+
+    // Remove a collectable leaving the world from every item manager
+    void UnregisterItemCollectable(AItemCollectable* ItemCollectable);
+    const TArray<TWeakObjectPtr<UItemManagerComponent>>& GetManagers() const { return Managers; }
+
+    UFUNCTION(BlueprintPure, meta = (DisplayName = "Get Num Virtual Managers", ToolTip = "Number of item managers only keeping their data-side inventory"), Category = "Item Manager")
+    int32 GetNumVirtualManagers() const;
+
+    UFUNCTION(BlueprintPure, meta = (DisplayName = "Get Num Materialized Managers", ToolTip = "Number of item managers with spawned item actors"), Category = "Item Manager")
+    int32 GetNumMaterializedManagers() const;
+
+    UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Memory Usage (KB)", ToolTip = "Estimated memory of every inventory, item actor and collectable of the world. See ItemManager.MemReport for the details."), Category = "Item Manager")
+    int32 GetMemoryUsageKB() const;
+
+    static bool IsSchedulerEnabled();
+
+    // True on dedicated servers (see ItemManager.ServerMode): visuals are not set up and cosmetic ticks are disabled
+    static bool IsServerModeEnabled();
+
+    // Native events of every item manager of the world
+    FItemManagerEventBus& GetEventBus() { return EventBus; }
+
+private:
+
+    TArray<FItemScheduledRequest> ScheduledRequests;
+    uint64 NextRequestSequence = 0;
+    TArray<TWeakObjectPtr<UItemManagerComponent>> Managers;
+    FItemManagerEventBus EventBus;
+
+    FItemTimingWheel TimingWheel;
+    TArray<FItemTimerHandle> ExpiredItemTimers;
+
+    TArray<TWeakObjectPtr<UItemManagerComponent>> SnapshotPublishRequests;
+
+    TMap<TSubclassOf<AItemParent>, TArray<TWeakObjectPtr<AItemParent>>> PooledItemActors;
+    TMap<TSubclassOf<AItemParent>, int32> PendingPrewarms;
+    FItemActorPoolStats PoolStats;
+
+    void DispatchItemTimers();
+    void PublishInventorySnapshots();
+    FItemScheduledRequest& AddScheduledRequest(EItemScheduledRequest Type);
+    void UpdatePriorities();
+    void ProcessRequest(FItemScheduledRequest& Request);
+};
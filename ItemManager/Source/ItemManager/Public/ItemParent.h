@@ -4,6 +4,8 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "GameplayTagContainer.h"
+#include "StructUtils/InstancedStruct.h"
 #include "ItemParent.generated.h"
 
 UENUM(BlueprintType)
@@ -87,6 +89,29 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ToolTip = "If true, the item will despawn when switch. If not, the item will be re-attach to the skeletal mesh owner with the 'detach' socket."), Category = "Item")
 	bool bDespawnItemWhenSwitched = false;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ToolTip = "Tags used by the item manager queries (e.g. Item.Ammo). Parent tags are matched too."), Category = "Item")
+	FGameplayTagContainer ItemTags;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ToolTip = "If true, the item is made dormant while holstered on its detach socket: no tick, no collision, no overlap events and no pose update.", EditCondition = "!bDespawnItemWhenSwitched"), Category = "Item|Holstered")
+	bool bEnableHolsteredDormancy = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ToolTip = "LOD forced on the skeletal mesh while holstered, plus one like Set Forced LOD: 1 forces LOD 0, 2 forces LOD 1... Its pose keeps updating at a reduced rate.\nIf set to 0, the pose is frozen.", EditCondition = "bEnableHolsteredDormancy", ClampMin = "0"), Category = "Item|Holstered")
+	int32 HolsteredForcedLOD = 0;
+
+	// Called when the item becomes dormant or wakes up. Override to keep a visual effect running while holstered.
+	UFUNCTION(BlueprintImplementableEvent, meta = (DisplayName = "On Enter Holstered Dormancy"), Category = "Item")
+	void OnEnterHolsteredDormancy_BP();
+	virtual void OnEnterHolsteredDormancy();
+
+	UFUNCTION(BlueprintImplementableEvent, meta = (DisplayName = "On Exit Holstered Dormancy"), Category = "Item")
+	void OnExitHolsteredDormancy_BP();
+	virtual void OnExitHolsteredDormancy();
+
+	// Called when a pooled actor is handed to a new slot instead of spawning one. Reset here the state set by its previous holder.
+	UFUNCTION(BlueprintImplementableEvent, meta = (DisplayName = "On Item Reused"), Category = "Item")
+	void OnItemReused_BP();
+	virtual void OnItemReused();
+
 	UFUNCTION(BlueprintImplementableEvent, meta = (DisplayName = "On Item Used"), Category = "Item")
 	void OnItemUsed_BP();
 	virtual void OnItemUsed();
@@ -95,7 +120,20 @@ protected:
 	void CannotUseItem_BP();
 	virtual void CannotUseItem();
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ToolTip = "Uses per second while the item is held in use (Begin Use Item). If set to 0, Begin Use Item uses the item once.", ClampMin = "0"), Category = "Item")
+	float UseRate = 0.f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (ToolTip = "Initial state of each instance of the item (ammo, durability, charges).\nEvery slot gets its own copy the first time it is written, kept through despawns, drops and pickups."), Category = "Item|Instance State")
+	FInstancedStruct DefaultInstanceState;
+
+	// Called with the uses accumulated since the last tick while the item is held in use.
+	// By default each use calls On Item Used, override it to handle the whole batch at once.
+	UFUNCTION(BlueprintImplementableEvent, meta = (DisplayName = "On Item Used Batch"), Category = "Item")
+	void OnItemUsedBatch_BP(int32 NumUses);
+	virtual void OnItemUsedBatch(int32 NumUses);
+
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:	
 	
@@ -119,11 +157,50 @@ public:
 	UFUNCTION(BlueprintPure, BlueprintCallable, meta = (DisplayName = "Is Despawning Item When Switched"), Category = "Get Item")
 	bool IsItemDespawnWhenSwitched() const { return bDespawnItemWhenSwitched; }
 
+	UFUNCTION(BlueprintPure, BlueprintCallable, meta = (DisplayName = "Get Item Tags"), Category = "Get Item")
+	FGameplayTagContainer GetItemTags() const { return ItemTags; }
+
+	UFUNCTION(BlueprintPure, BlueprintCallable, meta = (DisplayName = "Is Holstered Dormant"), Category = "Get Item")
+	bool IsHolsteredDormant() const { return bIsHolsteredDormant; }
+
+	UFUNCTION(BlueprintPure, BlueprintCallable, meta = (DisplayName = "Get Use Rate"), Category = "Get Item")
+	float GetUseRate() const { return UseRate; }
+
+	const FInstancedStruct& GetDefaultInstanceState() const { return DefaultInstanceState; }
+
 	USkeletalMeshComponent* GetSkeletalMesh() { return SkeletalMesh; }
 	void UseItem(UItemManagerComponent* ItemManagerComponent);
 
+	// Held use path, called by the item manager: no check nor log, Blueprint events are only called when implemented
+	void ProcessUses(int32 NumUses);
+
+	// Called by the item manager when the item is switched out/in. bForce ignores bEnableHolsteredDormancy and HolsteredForcedLOD (hidden resident or pooled items),
+	// an item already holstered at its forced LOD is then fully frozen.
+	void EnterHolsteredDormancy(bool bForce = false);
+	void ExitHolsteredDormancy();
+
+	// Called by the item actor pool of the subsystem
+	void NotifyReused();
+
 	virtual void Tick(float DeltaTime) override;
 
+private:
+
+	// state restored when leaving the dormancy
+	bool bIsHolsteredDormant = false;
+	bool bWasActorTickEnabled = true;
+	bool bWasMeshTickEnabled = true;
+	bool bWasCollisionEnabled = true;
+	bool bWasGeneratingOverlapEvents = false;
+	bool bWasSkeletonUpdateDisabled = false;
+	int32 PreviousForcedLOD = 0;
+	bool bIsAtHolsteredForcedLOD = false;
+
+	// looked up on the first held use
+	bool bAreUseEventsCached = false;
+	bool bImplementsOnItemUsed_BP = false;
+	bool bImplementsOnItemUsedBatch_BP = false;
+
 };
 
 
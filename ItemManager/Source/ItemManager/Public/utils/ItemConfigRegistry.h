@@ -0,0 +1,59 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+#include "ItemParent.h"
+#include "ItemCollectable.h"
+
+/**
+ * Interned, immutable item config records.
+ * Every slot holding the same FItemInfos / FItemCollectableData points to the same record,
+ * so inventories only pay for the configs that actually differ.
+ */
+class ITEMMANAGER_API FItemConfigRegistry : public FGCObject
+{
+public:
+
+	static FItemConfigRegistry& Get();
+
+	// Return the shared record equal to ItemInfos, creating it if needed
+	TSharedRef<const FItemInfos> Intern(const FItemInfos& ItemInfos);
+	TSharedRef<const FItemCollectableData> Intern(const FItemCollectableData& ItemCollectableData);
+
+	// Shared records of the item class defaults
+	TSharedRef<const FItemInfos> GetItemInfos(TSubclassOf<AItemParent> Item);
+	TSharedRef<const FItemCollectableData> GetItemCollectableData(TSubclassOf<AItemParent> Item);
+
+	// Forget the records of ItemClass and its children, or of every class, so their defaults are read again.
+	// Slots already holding a record keep it.
+	void InvalidateClassRecords(const UClass* ItemClass = nullptr);
+
+	// Release the records no slot is using anymore
+	void Prune();
+
+	// Log records count, references and the memory saved by sharing them
+	void DumpStats(FOutputDevice& Ar) const;
+
+	// Memory used by the tables and the records they hold
+	int64 GetAllocatedSize() const;
+
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override { return TEXT("FItemConfigRegistry"); }
+
+private:
+
+	template<typename T>
+	struct TInternTable
+	{
+		TMultiMap<uint32, TSharedRef<const T>> Records;
+		int32 NumRecordsAtLastPrune = 0;
+	};
+
+	TInternTable<FItemInfos> ItemInfosTable;
+	TInternTable<FItemCollectableData> ItemCollectableDataTable;
+
+	TMap<TWeakObjectPtr<UClass>, TSharedRef<const FItemInfos>> ItemInfosByClass;
+	TMap<TWeakObjectPtr<UClass>, TSharedRef<const FItemCollectableData>> ItemCollectableDataByClass;
+};
@@ -0,0 +1,124 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "UObject/ObjectKey.h"
+#include "ItemParent.h"
+
+class UItemManagerComponent;
+class AItemCollectable;
+
+// Events raised by the item managers, one per Blueprint delegate of the component
+enum class EItemManagerEvent : uint8
+{
+	IE_Switched,
+	IE_FailedToSwitch,
+	IE_Spawned,
+	IE_Despawned,
+	IE_Collected,
+	IE_CannotCollect,
+	IE_BeginOverlap,
+	IE_EndOverlap,
+	IE_Added,
+	IE_ItemsAdded,
+	IE_ItemsRemoved,
+	IE_Used,
+	IE_Num
+};
+
+struct FItemManagerEvent
+{
+	EItemManagerEvent Type = EItemManagerEvent::IE_Switched;
+
+	TWeakObjectPtr<UItemManagerComponent> Manager;
+	TWeakObjectPtr<AActor> Owner;
+
+	// item of the slot, or of the collectable for overlap events
+	TSubclassOf<AItemParent> Item;
+	int32 ItemIndex = INDEX_NONE;
+
+	// error code of the matching Blueprint delegate, number of uses for IE_Used
+	int32 Value = 0;
+
+	TWeakObjectPtr<AItemCollectable> ItemCollectable;
+};
+
+DECLARE_DELEGATE_OneParam(FOnItemManagerEvent, const FItemManagerEvent&);
+
+struct FItemManagerEventFilter
+{
+	// bit per EItemManagerEvent, see GetTypeBit
+	uint32 Types = MAX_uint32;
+
+	// only events on this class or its children
+	TSubclassOf<AItemParent> ItemClass;
+
+	// only events on items having one of these tags
+	FGameplayTagContainer ItemTags;
+
+	// only events of the item manager of this actor
+	TWeakObjectPtr<AActor> Owner;
+
+	// deliver only the last event of each type and manager, once per frame
+	bool bCoalesce = false;
+
+	static constexpr uint32 GetTypeBit(EItemManagerEvent Type) { return 1u << static_cast<uint32>(Type); }
+
+	FItemManagerEventFilter& OnlyType(EItemManagerEvent Type) { Types = GetTypeBit(Type); return *this; }
+	FItemManagerEventFilter& AddType(EItemManagerEvent Type) { Types = (Types == MAX_uint32 ? 0u : Types) | GetTypeBit(Type); return *this; }
+};
+
+/**
+ * Native event dispatch for C++ listeners, next to the Blueprint delegates of the item managers.
+ * Subscribers are sorted by event type and owner when subscribing, so a broadcast only visits the interested ones.
+ * A callback may subscribe or unsubscribe, removed entries are only freed once no broadcast is running.
+ * Game thread only.
+ */
+class ITEMMANAGER_API FItemManagerEventBus
+{
+public:
+
+	FDelegateHandle Subscribe(const FItemManagerEventFilter& Filter, FOnItemManagerEvent Delegate);
+	void Unsubscribe(FDelegateHandle Handle);
+
+	// Cheap check done by the item managers before building an event
+	bool HasSubscribers(EItemManagerEvent Type) const { return SubscriberCounts[static_cast<int32>(Type)] > 0; }
+
+	void Broadcast(const FItemManagerEvent& Event);
+
+	// Deliver the coalesced events, called once per frame by the subsystem
+	void FlushCoalescedEvents();
+
+	int32 GetNumSubscribers() const { return Subscribers.Num(); }
+
+private:
+
+	struct FSubscriber
+	{
+		FDelegateHandle Handle;
+		FItemManagerEventFilter Filter;
+		FOnItemManagerEvent Delegate;
+		TArray<FItemManagerEvent> PendingEvents;
+		bool bIsRemoved = false;
+	};
+
+	struct FTypeSubscribers
+	{
+		TArray<int32> AnyOwner;
+		TMap<TObjectKey<AActor>, TArray<int32>> ByOwner;
+	};
+
+	TSparseArray<FSubscriber> Subscribers;
+	FTypeSubscribers TypeSubscribers[static_cast<int32>(EItemManagerEvent::IE_Num)];
+	int32 SubscriberCounts[static_cast<int32>(EItemManagerEvent::IE_Num)] = {};
+
+	TArray<int32> SubscribersWithPendingEvents;
+	TArray<int32> PendingRemovals;
+	int32 BroadcastDepth = 0;
+
+	bool PassesFilter(const FItemManagerEventFilter& Filter, const FItemManagerEvent& Event) const;
+	void Deliver(int32 SubscriberIndex, const FItemManagerEvent& Event);
+	void ReleasePendingRemovals();
+};
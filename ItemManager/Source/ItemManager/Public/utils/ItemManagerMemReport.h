@@ -0,0 +1,65 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+struct FResourceSizeEx;
+
+// How an item is represented in the world
+enum class EItemRepresentation : uint8
+{
+	IR_Actor,		// spawned item actor, current item or kept on its detach socket
+	IR_Resident,	// switched out actor kept hidden and dormant by the residency budget
+	IR_Virtual,		// data-side record only, no actor
+	IR_Collectable,	// ItemCollectable lying in the world
+	IR_Num
+};
+
+ITEMMANAGER_API const TCHAR* LexToString(EItemRepresentation Representation);
+
+namespace ItemManagerMemReport
+{
+	// Add the actor and its components, whether they are registered or not
+	ITEMMANAGER_API void GetActorResourceSizeEx(AActor* Actor, FResourceSizeEx& CumulativeResourceSize);
+	ITEMMANAGER_API int64 GetActorResourceSize(AActor* Actor, EResourceSizeMode::Type Mode = EResourceSizeMode::Exclusive);
+}
+
+struct FItemMemoryRecord
+{
+	// owner of the item manager, empty for collectables
+	FString Manager;
+	const UClass* ItemClass = nullptr;
+	EItemRepresentation Representation = EItemRepresentation::IR_Virtual;
+
+	// inventory record and owned collectable data
+	int64 RecordBytes = 0;
+
+	// actor and its components, 0 if there is no actor
+	int64 ActorBytes = 0;
+};
+
+/**
+ * Memory used by the inventories and the collectables of a world, by manager, item class and representation.
+ * Sizes are the ones reported by GetResourceSizeEx (Exclusive), plus the records of the item managers.
+ */
+struct ITEMMANAGER_API FItemManagerMemReport
+{
+	TArray<FItemMemoryRecord> Records;
+
+	// item managers containers (indices, journal, spare capacity), not per item
+	TMap<FString, int64> ManagerOverheadBytes;
+
+	// interned configs shared by every slot, see FItemConfigRegistry
+	int64 SharedConfigBytes = 0;
+
+	static FItemManagerMemReport Gather(UWorld* World);
+
+	int64 GetTotalBytes() const;
+
+	void Dump(FOutputDevice& Ar) const;
+
+	// one row per manager, item class and representation
+	bool SaveToCsv(const FString& FilePath) const;
+};
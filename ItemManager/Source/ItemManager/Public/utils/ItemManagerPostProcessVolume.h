@@ -4,12 +4,10 @@
 
 #include "CoreMinimal.h"
 #include "Engine/PostProcessVolume.h"
-#include "Materials/MaterialInstance.h"
-#include "UObject/ConstructorHelpers.h"
 #include "ItemManagerPostProcessVolume.generated.h"
 
 /**
- * 
+ * Unbound volume blending the transparency material of the Item Manager project settings
  */
 UCLASS()
 class ITEMMANAGER_API AItemManagerPostProcessVolume : public APostProcessVolume
@@ -20,10 +18,6 @@ class ITEMMANAGER_API AItemManagerPostProcessVolume : public APostProcessVolume
 public:
 	AItemManagerPostProcessVolume();
 
-private:
-
-	UMaterialInstance* PostProcessMaterialInstance = nullptr;
-
-	void setupPostProcess();
+	virtual void PostInitializeComponents() override;
 	
 };
@@ -0,0 +1,102 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ItemParent.h"
+#include "utils/ItemManagerTrace.h"
+
+class UItemManagerComponent;
+class AItemCollectable;
+
+struct ITEMMANAGER_API FItemManagerSoakSettings
+{
+	int32 NumBots = 64;
+	int32 NumCollectables = 1000;
+	float DurationSeconds = 60.f;
+	int32 Seed = 0;
+
+	// chance for each bot to act each frame
+	float ActionRate = 0.2f;
+
+	// fail thresholds
+	float FrameBudgetMs = 33.3f;
+	float MaxMemoryGrowthMB = 64.f;
+	int32 MaxScheduledRequests = 1024;
+	int32 MaxObjectGrowth = 5000;
+
+	// period of the forced garbage collections, 0 to only measure the ones of the engine
+	float GCIntervalSeconds = 10.f;
+
+	// items added to the bots and scattered on the ground, AItemParent if empty
+	TArray<TSubclassOf<AItemParent>> ItemClasses;
+
+	// -Bots= -Collectables= -Duration= -Seed= -ActionRate= -FrameBudgetMs= -MaxMemoryGrowthMB= -MaxScheduledRequests= -MaxObjectGrowth= -GCInterval= -Items=Path1+Path2
+	void ParseParams(const TCHAR* Params);
+};
+
+/**
+ * Bots collecting, dropping, switching and using items with a seeded random mix.
+ * Reports frame time percentiles, per-operation costs, live actor counts, memory growth,
+ * garbage collection times and UObject counts, and fails on leaked collectable entries,
+ * orphaned item actors or budget overruns. Use -Duration=3600 for an hour of play.
+ */
+class ITEMMANAGER_API FItemManagerSoakTest
+{
+public:
+
+	FItemManagerSoakTest(UWorld* InWorld, const FItemManagerSoakSettings& InSettings);
+	~FItemManagerSoakTest();
+
+	// Spawn the bots and scatter the collectables
+	void Start();
+
+	// Run one frame of bot actions, called once per world tick
+	void Step(float DeltaSeconds);
+
+	bool IsDone() const { return ElapsedSeconds >= Settings.DurationSeconds; }
+
+	// Log the report, destroy the spawned actors and return false if the run failed
+	bool Finish(FOutputDevice& Ar);
+
+private:
+
+	TWeakObjectPtr<UWorld> World;
+	FItemManagerSoakSettings Settings;
+	FRandomStream RandomStream;
+
+	TArray<TWeakObjectPtr<AActor>> Bots;
+	TArray<TWeakObjectPtr<UItemManagerComponent>> Managers;
+	TSet<TWeakObjectPtr<AActor>> ActorsBeforeStart;
+
+	FItemTraceHistogram OpHistograms[static_cast<int32>(EItemTraceOp::TO_Num)];
+	TArray<float> FrameMilliseconds;
+	double LastStepTime = 0.0;
+	float ElapsedSeconds = 0.f;
+
+	uint64 BaselineMemory = 0;
+	bool bHasBaselineMemory = false;
+
+	int32 MaxItemActors = 0;
+	int32 MaxCollectables = 0;
+	int32 MaxScheduledRequests = 0;
+	float NextActorCountTime = 0.f;
+
+	// counted after a full collection, live objects only
+	int32 BaselineObjects = 0;
+	int32 MaxObjects = 0;
+
+	int32 NumGarbageCollections = 0;
+	double GCSeconds = 0.0;
+	double MaxGCSeconds = 0.0;
+	double GCStartTime = 0.0;
+	float NextGCTime = 0.f;
+	float NextProgressTime = 0.f;
+	FDelegateHandle PreGarbageCollectHandle;
+	FDelegateHandle PostGarbageCollectHandle;
+
+	void RunAction(UItemManagerComponent* Manager);
+	void OnPreGarbageCollect();
+	void OnPostGarbageCollect();
+	void CountActors(int32& OutItemActors, int32& OutCollectables) const;
+};
@@ -0,0 +1,116 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ItemParent.h"
+#include "UObject/StrongObjectPtr.h"
+
+class UItemManagerComponent;
+
+// Public calls of the item manager that can be recorded
+enum class EItemTraceOp : uint8
+{
+	TO_AddItem,
+	TO_SwitchIndexItem,
+	TO_SwitchNextItem,
+	TO_SwitchPreviousItem,
+	TO_CollectItem,
+	TO_DropItem,
+	TO_UseItem,
+	TO_Num
+};
+
+ITEMMANAGER_API const TCHAR* LexToString(EItemTraceOp Op);
+
+struct FItemTraceEvent
+{
+	EItemTraceOp Op = EItemTraceOp::TO_UseItem;
+
+	// frames since the start of the recording
+	uint32 Frame = 0;
+
+	// switch index, or index in the trace class table for AddItem
+	int32 Value = 0;
+};
+
+/**
+ * Compact binary trace of the calls made to an item manager.
+ * Each event is an op byte, a packed frame delta and a packed value. Item classes are stored once in a table.
+ */
+class ITEMMANAGER_API FItemManagerTrace
+{
+public:
+
+	TArray<FItemTraceEvent> Events;
+	TArray<FSoftClassPath> Classes;
+
+	void Serialize(FArchive& Ar);
+
+	bool SaveToFile(const FString& FilePath);
+	bool LoadFromFile(const FString& FilePath);
+};
+
+class ITEMMANAGER_API FItemManagerTraceRecorder
+{
+public:
+
+	explicit FItemManagerTraceRecorder(uint64 InStartFrame);
+
+	void Record(EItemTraceOp Op, int32 Value = 0);
+	void RecordAddItem(TSubclassOf<AItemParent> Item);
+
+	const FItemManagerTrace& GetTrace() const { return Trace; }
+
+private:
+
+	FItemManagerTrace Trace;
+	uint64 StartFrame;
+	TMap<FSoftClassPath, int32> ClassIndices;
+};
+
+// Timings of one op, bucketed by power of two of microseconds
+struct FItemTraceHistogram
+{
+	static constexpr int32 NumBuckets = 24;
+
+	uint32 Buckets[NumBuckets] = {};
+	uint32 Count = 0;
+	double TotalSeconds = 0.0;
+	double MaxSeconds = 0.0;
+
+	void Add(double Seconds);
+
+	// upper bound of the bucket holding the percentile, in microseconds
+	double GetPercentileMicroseconds(float Percentile) const;
+};
+
+/**
+ * Drive one or many item managers from a trace, either as fast as possible or following the recorded frames.
+ */
+class ITEMMANAGER_API FItemManagerTraceReplayer
+{
+public:
+
+	FItemManagerTraceReplayer(const FItemManagerTrace& InTrace, const TArray<UItemManagerComponent*>& InManagers);
+
+	// Replay every event right away
+	void ReplayAll();
+
+	// Replay the events recorded up to Frame (relative to the start of the replay). Return false once done.
+	bool ReplayUntilFrame(uint32 Frame);
+
+	bool IsDone() const { return NextEvent >= Trace.Events.Num(); }
+
+	void DumpReport(FOutputDevice& Ar) const;
+
+private:
+
+	const FItemManagerTrace Trace;
+	TArray<TWeakObjectPtr<UItemManagerComponent>> Managers;
+	TArray<TStrongObjectPtr<UClass>> LoadedClasses;
+	FItemTraceHistogram Histograms[static_cast<int32>(EItemTraceOp::TO_Num)];
+	int32 NextEvent = 0;
+
+	void ReplayEvent(const FItemTraceEvent& Event);
+};
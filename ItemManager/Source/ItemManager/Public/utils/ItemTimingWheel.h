@@ -0,0 +1,103 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UItemManagerComponent;
+
+// Lifecycle events of the item managers, delayed by the timing wheel of the subsystem
+enum class EItemTimerType : uint8
+{
+	IT_SpawnItem,
+	IT_DestroyItem,
+	IT_EndSwitching,
+	IT_Significance
+};
+
+struct FItemTimer
+{
+	TWeakObjectPtr<UItemManagerComponent> Manager;
+	EItemTimerType Type = EItemTimerType::IT_SpawnItem;
+
+	// slot index of IT_DestroyItem
+	int32 Value = INDEX_NONE;
+};
+
+// Cleared by the wheel users when the timer fires or is cancelled, a stale handle is ignored
+struct FItemTimerHandle
+{
+	int32 Index = INDEX_NONE;
+	uint32 Serial = 0;
+
+	bool IsValid() const { return Index != INDEX_NONE; }
+	void Invalidate() { Index = INDEX_NONE; }
+};
+
+/**
+ * Hierarchical timing wheel: 4 levels of 64 slots, a timer is linked in the slot of its due tick
+ * and moved down a level when the lower wheel wraps around. Schedule and cancel are O(1),
+ * advancing visits one slot per elapsed tick. Timers are pooled, no allocation once warmed up.
+ * Game thread only.
+ */
+class ITEMMANAGER_API FItemTimingWheel
+{
+public:
+
+	explicit FItemTimingWheel(double InTickSeconds = 1.0 / 120.0);
+
+	// Fire Timer once Delay seconds after Now. Never fires in the Advance call of the current tick.
+	FItemTimerHandle Schedule(double Now, float Delay, const FItemTimer& Timer);
+
+	// Remove a pending timer, also valid on the expired timers not consumed yet. Invalidate the handle.
+	bool Cancel(FItemTimerHandle& Handle);
+
+	bool IsPending(const FItemTimerHandle& Handle) const;
+
+	// Append the timers due at Now to OutExpired, in due order. Consume each of them to get its payload.
+	void Advance(double Now, TArray<FItemTimerHandle>& OutExpired);
+
+	// Release an expired timer, false if it was cancelled since Advance
+	bool Consume(const FItemTimerHandle& Handle, FItemTimer& OutTimer);
+
+	int32 Num() const { return NumTimers; }
+
+	SIZE_T GetAllocatedSize() const { return Entries.GetAllocatedSize() + FreeEntries.GetAllocatedSize(); }
+
+private:
+
+	static constexpr int32 NumLevels = 4;
+	static constexpr int32 SlotBits = 6;
+	static constexpr int32 NumSlots = 1 << SlotBits;
+	static constexpr uint64 SlotMask = NumSlots - 1;
+
+	struct FEntry
+	{
+		FItemTimer Timer;
+		uint64 DueTick = 0;
+		uint32 Serial = 0;
+		int32 Prev = INDEX_NONE;
+		int32 Next = INDEX_NONE;
+
+		// INDEX_NONE once expired or free
+		int32 Bucket = INDEX_NONE;
+	};
+
+	double TickSeconds;
+	uint64 CurrentTick = 0;
+	bool bIsStarted = false;
+	int32 NumTimers = 0;
+
+	TArray<FEntry> Entries;
+	TArray<int32> FreeEntries;
+
+	// first and last entry of each slot, level major
+	int32 Heads[NumLevels * NumSlots];
+	int32 Tails[NumLevels * NumSlots];
+
+	void Start(double Now);
+	void Link(int32 EntryIndex);
+	void Unlink(int32 EntryIndex);
+	void Release(int32 EntryIndex);
+	void CascadeBucket(int32 Bucket);
+};
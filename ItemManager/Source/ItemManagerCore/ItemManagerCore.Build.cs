@@ -0,0 +1,19 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+using UnrealBuildTool;
+
+// Inventory rules of the item manager, without UObject nor world, so they can be benchmarked and tested in isolation
+public class ItemManagerCore : ModuleRules
+{
+	public ItemManagerCore(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core"
+			}
+			);
+	}
+}
@@ -0,0 +1,249 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+
+#include "ItemInventoryCore.h"
+
+EItemAddError FItemInventoryCore::CanAddItem(const FItemInventoryRules& Rules, const void* ItemKey) const
+{
+	if (!ItemKey)
+	{
+		return EItemAddError::AE_InvalidItem;
+	}
+
+	if (Rules.ItemLimit > 0 && Slots.Num() >= Rules.ItemLimit)
+	{
+		return EItemAddError::AE_LimitReached;
+	}
+
+	if (!Rules.bAllowsDuplicates && ItemKeyCounts.Contains(ItemKey))
+	{
+		return EItemAddError::AE_Duplicate;
+	}
+
+	return EItemAddError::AE_None;
+}
+
+EItemAddError FItemInventoryCore::CanAddItems(const FItemInventoryRules& Rules, TConstArrayView<const void*> ItemKeys, int32& OutFailedEntry) const
+{
+	OutFailedEntry = INDEX_NONE;
+
+	if (Rules.ItemLimit > 0 && Slots.Num() + ItemKeys.Num() > Rules.ItemLimit)
+	{
+		OutFailedEntry = FMath::Max(Rules.ItemLimit - Slots.Num(), 0);
+		return EItemAddError::AE_LimitReached;
+	}
+
+	TSet<const void*> NewItemKeys;
+	if (!Rules.bAllowsDuplicates)
+	{
+		NewItemKeys.Reserve(ItemKeys.Num());
+	}
+
+	for (int32 EntryIndex = 0; EntryIndex < ItemKeys.Num(); EntryIndex++)
+	{
+		const void* ItemKey = ItemKeys[EntryIndex];
+
+		if (!ItemKey)
+		{
+			OutFailedEntry = EntryIndex;
+			return EItemAddError::AE_InvalidItem;
+		}
+
+		if (!Rules.bAllowsDuplicates)
+		{
+			bool bIsAlreadyInSet = false;
+			NewItemKeys.Add(ItemKey, &bIsAlreadyInSet);
+
+			if (bIsAlreadyInSet || ItemKeyCounts.Contains(ItemKey))
+			{
+				OutFailedEntry = EntryIndex;
+				return EItemAddError::AE_Duplicate;
+			}
+		}
+	}
+
+	return EItemAddError::AE_None;
+}
+
+int32 FItemInventoryCore::AddSlot(const FItemCoreSlot& Slot)
+{
+	ItemKeyCounts.FindOrAdd(Slot.ItemKey)++;
+	return Slots.Add(Slot);
+}
+
+void FItemInventoryCore::RemoveSlot(int32 SlotIndex)
+{
+	int32& ItemKeyCount = ItemKeyCounts.FindChecked(Slots[SlotIndex].ItemKey);
+	if (--ItemKeyCount <= 0)
+	{
+		ItemKeyCounts.Remove(Slots[SlotIndex].ItemKey);
+	}
+
+	Slots.RemoveAt(SlotIndex);
+
+	if (SlotIndex == CurrentIndex)
+	{
+		bIsCurrentRemoved = true;
+	}
+	else if (SlotIndex < CurrentIndex)
+	{
+		RemovedBeforeCurrent++;
+	}
+}
+
+bool FItemInventoryCore::FinishRemoval()
+{
+	const bool bWasCurrentRemoved = bIsCurrentRemoved;
+
+	CurrentIndex = bIsCurrentRemoved ? 0 : CurrentIndex - RemovedBeforeCurrent;
+	Phase = Slots.Num() <= 0 ? EItemSwitchPhase::SP_None : Phase;
+
+	RemovedBeforeCurrent = 0;
+	bIsCurrentRemoved = false;
+
+	return bWasCurrentRemoved;
+}
+
+void FItemInventoryCore::SwapSlots(int32 FirstIndex, int32 SecondIndex)
+{
+	Slots.Swap(FirstIndex, SecondIndex);
+
+	if (CurrentIndex == FirstIndex)
+	{
+		CurrentIndex = SecondIndex;
+	}
+	else if (CurrentIndex == SecondIndex)
+	{
+		CurrentIndex = FirstIndex;
+	}
+}
+
+FItemSwitchSelection FItemInventoryCore::SelectNextItem(const FItemInventoryRules& Rules) const
+{
+	FItemSwitchSelection Selection;
+	const int32 NumSlots = Slots.Num();
+	int32 NextIndex = CurrentIndex;
+
+	if (NextIndex < 0 || NextIndex >= NumSlots)
+	{
+		Selection.Error = EItemSwitchError::SE_InvalidIndex;
+		return Selection;
+	}
+
+	int32 SlotCount = 0;
+	do
+	{
+		NextIndex++;
+
+		if (Rules.bLoopSwitching && NextIndex >= NumSlots)
+		{
+			NextIndex = 0;
+		}
+
+		// past the last slot without looping
+		if (NextIndex >= NumSlots)
+		{
+			Selection.Error = EItemSwitchError::SE_InvalidIndex;
+			return Selection;
+		}
+
+		if (!Slots[NextIndex].ItemKey)
+		{
+			return Selection;
+		}
+
+		SlotCount++;
+	} while (NextIndex < NumSlots - 1 && SlotCount < NumSlots && !Slots[NextIndex].bCanBeSwitched);
+
+	// went around without finding another item
+	if (SlotCount == NumSlots && Phase != EItemSwitchPhase::SP_None)
+	{
+		Selection.Error = EItemSwitchError::SE_SameItem;
+		return Selection;
+	}
+
+	Selection.Index = NextIndex;
+	return Selection;
+}
+
+FItemSwitchSelection FItemInventoryCore::SelectPreviousItem(const FItemInventoryRules& Rules) const
+{
+	FItemSwitchSelection Selection;
+	const int32 NumSlots = Slots.Num();
+	int32 PreviousIndex = CurrentIndex;
+
+	if (NumSlots <= 0 || PreviousIndex < 0)
+	{
+		Selection.Error = EItemSwitchError::SE_InvalidIndex;
+		return Selection;
+	}
+
+	int32 SlotCount = 0;
+	do
+	{
+		PreviousIndex--;
+
+		if (Rules.bLoopSwitching && PreviousIndex < 0)
+		{
+			PreviousIndex = NumSlots - 1;
+		}
+
+		// before the first slot without looping
+		if (PreviousIndex < 0 || PreviousIndex >= NumSlots)
+		{
+			Selection.Error = EItemSwitchError::SE_InvalidIndex;
+			return Selection;
+		}
+
+		if (!Slots[PreviousIndex].ItemKey)
+		{
+			return Selection;
+		}
+
+		SlotCount++;
+	} while (PreviousIndex >= 0 && SlotCount < NumSlots && !Slots[PreviousIndex].bCanBeSwitched);
+
+	if (SlotCount == NumSlots && Phase != EItemSwitchPhase::SP_None)
+	{
+		Selection.Error = EItemSwitchError::SE_SameItem;
+		return Selection;
+	}
+
+	Selection.Index = PreviousIndex;
+	return Selection;
+}
+
+EItemSwitchError FItemInventoryCore::BeginSwitch(int32 NewIndex, FItemSwitchTransition& OutTransition)
+{
+	if (!Slots.IsValidIndex(NewIndex))
+	{
+		return EItemSwitchError::SE_InvalidIndex;
+	}
+
+	if (CurrentIndex == NewIndex && Phase != EItemSwitchPhase::SP_None)
+	{
+		return EItemSwitchError::SE_SameItem;
+	}
+
+	if (bIsSwitching)
+	{
+		return EItemSwitchError::SE_Switching;
+	}
+
+	// the new item spawns once the old one is gone
+	OutTransition.OldIndex = CurrentIndex;
+	OutTransition.NewIndex = NewIndex;
+	OutTransition.DespawnDelay = Slots.IsValidIndex(CurrentIndex) ? Slots[CurrentIndex].TimeBeforeDespawn : 0.f;
+	OutTransition.SpawnDelay = Slots[NewIndex].TimeBeforeSpawn + OutTransition.DespawnDelay;
+
+	bIsSwitching = true;
+	CurrentIndex = NewIndex;
+	Phase = EItemSwitchPhase::SP_Switching;
+
+	return EItemSwitchError::SE_None;
+}
+
+bool FItemInventoryCore::CanDropCurrentItem(bool bHasItemActor) const
+{
+	return !bIsSwitching && Slots.IsValidIndex(CurrentIndex) && bHasItemActor && Slots[CurrentIndex].bIsDropable;
+}
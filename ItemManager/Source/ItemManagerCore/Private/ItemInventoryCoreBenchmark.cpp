@@ -0,0 +1,204 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+
+#include "ItemInventoryCoreBenchmark.h"
+#include "ItemInventoryCore.h"
+#include "HAL/IConsoleManager.h"
+
+namespace ItemInventoryCoreBenchmark
+{
+	// each case is repeated until it ran this long, like a benchmark library would
+	static constexpr double MinSeconds = 0.02;
+
+	static const void* MakeItemKey(int32 Index)
+	{
+		return reinterpret_cast<const void*>(static_cast<UPTRINT>(Index + 1));
+	}
+
+	static void MakeInventory(FItemInventoryCore& Inventory, int32 NumItems, bool bCanBeSwitched)
+	{
+		for (int32 Index = 0; Index < NumItems; Index++)
+		{
+			FItemCoreSlot Slot;
+			Slot.ItemKey = MakeItemKey(Index);
+			Slot.bCanBeSwitched = bCanBeSwitched;
+			Inventory.AddSlot(Slot);
+		}
+	}
+
+	static void Report(FOutputDevice& Ar, const TCHAR* Name, int32 NumItems, double Seconds, int64 NumOps)
+	{
+		Seconds = FMath::Max(Seconds, UE_DOUBLE_SMALL_NUMBER);
+		NumOps = FMath::Max<int64>(NumOps, 1);
+
+		Ar.Logf(TEXT("%-26s %9d %12.1f %16.0f %12lld"), Name, NumItems, Seconds * 1000000000.0 / NumOps, NumOps / Seconds, NumOps);
+	}
+
+	// Body returns the number of operations it timed and adds its time to Seconds
+	template <typename BodyType>
+	static void Run(FOutputDevice& Ar, const TCHAR* Name, int32 NumItems, BodyType&& Body)
+	{
+		double Seconds = 0.0;
+		int64 NumOps = 0;
+
+		while (Seconds < MinSeconds)
+		{
+			NumOps += Body(Seconds);
+		}
+
+		Report(Ar, Name, NumItems, Seconds, NumOps);
+	}
+
+	void RunAll(FOutputDevice& Ar, int32 MaxItems)
+	{
+		FItemInventoryRules Rules;
+		Rules.bAllowsDuplicates = false;
+		Rules.bLoopSwitching = true;
+
+		Ar.Logf(TEXT("%-26s %9s %12s %16s %12s"), TEXT("Benchmark"), TEXT("Items"), TEXT("ns/op"), TEXT("ops/s"), TEXT("Ops"));
+
+		for (int32 NumItems = 1000; NumItems <= MaxItems; NumItems *= 10)
+		{
+			// add checks with duplicates refused, then the add itself
+			Run(Ar, TEXT("BM_AddItem"), NumItems, [NumItems, &Rules](double& Seconds)
+			{
+				FItemInventoryCore Inventory;
+				int32 NumAdded = 0;
+
+				const double StartTime = FPlatformTime::Seconds();
+				for (int32 Index = 0; Index < NumItems; Index++)
+				{
+					const void* ItemKey = MakeItemKey(Index);
+
+					if (Inventory.CanAddItem(Rules, ItemKey) == EItemAddError::AE_None)
+					{
+						FItemCoreSlot Slot;
+						Slot.ItemKey = ItemKey;
+						Inventory.AddSlot(Slot);
+						NumAdded++;
+					}
+				}
+				Seconds += FPlatformTime::Seconds() - StartTime;
+
+				return static_cast<int64>(NumAdded);
+			});
+
+			FItemInventoryCore FullInventory;
+			MakeInventory(FullInventory, NumItems, true);
+
+			Run(Ar, TEXT("BM_CanAddItem_Duplicate"), NumItems, [NumItems, &Rules, &FullInventory](double& Seconds)
+			{
+				int32 NumDuplicates = 0;
+
+				const double StartTime = FPlatformTime::Seconds();
+				for (int32 Index = 0; Index < NumItems; Index++)
+				{
+					NumDuplicates += FullInventory.CanAddItem(Rules, MakeItemKey(Index)) == EItemAddError::AE_Duplicate ? 1 : 0;
+				}
+				Seconds += FPlatformTime::Seconds() - StartTime;
+
+				check(NumDuplicates == NumItems);
+				return static_cast<int64>(NumItems);
+			});
+
+			TArray<const void*> ItemKeys;
+			ItemKeys.SetNumUninitialized(NumItems);
+			for (int32 Index = 0; Index < NumItems; Index++)
+			{
+				ItemKeys[Index] = MakeItemKey(NumItems + Index);
+			}
+
+			Run(Ar, TEXT("BM_CanAddItems_Batch"), NumItems, [NumItems, &Rules, &FullInventory, &ItemKeys](double& Seconds)
+			{
+				int32 FailedEntry = INDEX_NONE;
+
+				const double StartTime = FPlatformTime::Seconds();
+				FullInventory.CanAddItems(Rules, ItemKeys, FailedEntry);
+				Seconds += FPlatformTime::Seconds() - StartTime;
+
+				return static_cast<int64>(NumItems);
+			});
+
+			// every slot switchable, one step per selection
+			Run(Ar, TEXT("BM_SelectNextItem"), NumItems, [NumItems, &Rules, &FullInventory](double& Seconds)
+			{
+				FullInventory.SetCurrentIndex(0);
+
+				const double StartTime = FPlatformTime::Seconds();
+				for (int32 Index = 0; Index < NumItems; Index++)
+				{
+					FullInventory.SetCurrentIndex(FullInventory.SelectNextItem(Rules).Index);
+				}
+				Seconds += FPlatformTime::Seconds() - StartTime;
+
+				return static_cast<int64>(NumItems);
+			});
+
+			// no slot switchable, every selection walks the whole inventory
+			FItemInventoryCore LockedInventory;
+			MakeInventory(LockedInventory, NumItems, false);
+
+			Run(Ar, TEXT("BM_SelectNextItem_Locked"), NumItems, [&Rules, &LockedInventory](double& Seconds)
+			{
+				const double StartTime = FPlatformTime::Seconds();
+				LockedInventory.SelectNextItem(Rules);
+				Seconds += FPlatformTime::Seconds() - StartTime;
+
+				return static_cast<int64>(1);
+			});
+
+			// full switch: start, lock released, new item spawned
+			Run(Ar, TEXT("BM_SwitchTransition"), NumItems, [NumItems, &FullInventory](double& Seconds)
+			{
+				FItemSwitchTransition Transition;
+				int32 NumTransitions = 0;
+
+				const double StartTime = FPlatformTime::Seconds();
+				for (int32 Index = 0; Index < NumItems; Index++)
+				{
+					const int32 NewIndex = FullInventory.GetCurrentIndex() + 1 < NumItems ? FullInventory.GetCurrentIndex() + 1 : 0;
+
+					if (FullInventory.BeginSwitch(NewIndex, Transition) == EItemSwitchError::SE_None)
+					{
+						FullInventory.EndSwitching();
+						FullInventory.MarkSpawned();
+						NumTransitions++;
+					}
+				}
+				Seconds += FPlatformTime::Seconds() - StartTime;
+
+				return static_cast<int64>(NumTransitions);
+			});
+
+			// drop the current item, the first slot is current again after each drop. Each drop shifts the whole inventory.
+			const int32 NumDrops = FMath::Clamp(10000000 / NumItems, 1, NumItems);
+
+			Run(Ar, TEXT("BM_DropCurrentItem"), NumItems, [NumItems, NumDrops](double& Seconds)
+			{
+				FItemInventoryCore Inventory;
+				MakeInventory(Inventory, NumItems, true);
+				Inventory.MarkSpawned();
+
+				const double StartTime = FPlatformTime::Seconds();
+				for (int32 Index = 0; Index < NumDrops; Index++)
+				{
+					Inventory.RemoveSlot(Inventory.GetCurrentIndex());
+					Inventory.FinishRemoval();
+				}
+				Seconds += FPlatformTime::Seconds() - StartTime;
+
+				return static_cast<int64>(NumDrops);
+			});
+		}
+	}
+}
+
+static FAutoConsoleCommandWithArgsAndOutputDevice ItemInventoryCoreBenchmarkCommand(
+	TEXT("ItemManager.Core.Benchmark"),
+	TEXT("Measure the inventory rules of the item manager (add checks, switch selection and transitions, drops) from 1e3 items up to MaxItems. Usage: ItemManager.Core.Benchmark [MaxItems=1000000]"),
+	FConsoleCommandWithArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, FOutputDevice& Ar)
+	{
+		const int32 MaxItems = Args.Num() > 0 ? FMath::Clamp(FCString::Atoi(*Args[0]), 1000, 10000000) : 1000000;
+
+		ItemInventoryCoreBenchmark::RunAll(Ar, MaxItems);
+	}));
@@ -0,0 +1,5 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+#include "Modules/ModuleManager.h"
+
+IMPLEMENT_MODULE(FDefaultModuleImpl, ItemManagerCore)
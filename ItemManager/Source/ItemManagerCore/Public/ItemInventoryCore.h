@@ -0,0 +1,136 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Same values as the errors broadcast by OnAddingItem
+enum class EItemAddError : uint8
+{
+	AE_None,
+	AE_InvalidItem,
+	AE_LimitReached,
+	AE_Duplicate
+};
+
+// Same values as the errors broadcast by OnFailedtoSwitchItem
+enum class EItemSwitchError : uint8
+{
+	SE_None,
+	SE_InvalidIndex,
+	SE_SameItem,
+	SE_Switching
+};
+
+// Same order as EItemState
+enum class EItemSwitchPhase : uint8
+{
+	SP_None,
+	SP_Switching,
+	SP_Idle
+};
+
+struct FItemInventoryRules
+{
+	// 0 for no limit
+	int32 ItemLimit = 0;
+	bool bAllowsDuplicates = true;
+	bool bLoopSwitching = true;
+};
+
+// A slot as seen by the rules, the item is an opaque key compared by address
+struct FItemCoreSlot
+{
+	const void* ItemKey = nullptr;
+	bool bCanBeSwitched = true;
+	bool bIsDropable = true;
+	float TimeBeforeSpawn = 0.f;
+	float TimeBeforeDespawn = 0.f;
+};
+
+// Slot picked by SelectNextItem/SelectPreviousItem. No index and no error: nothing to do.
+struct FItemSwitchSelection
+{
+	int32 Index = INDEX_NONE;
+	EItemSwitchError Error = EItemSwitchError::SE_None;
+};
+
+// Delays the owner has to schedule for a switch started by BeginSwitch
+struct FItemSwitchTransition
+{
+	int32 OldIndex = INDEX_NONE;
+	int32 NewIndex = INDEX_NONE;
+
+	// the old item is destroyed after DespawnDelay, the new one spawned after SpawnDelay
+	float DespawnDelay = 0.f;
+	float SpawnDelay = 0.f;
+};
+
+/**
+ * Inventory rules and switch state machine of the item manager: add checks, next/previous selection,
+ * switching and drop bookkeeping. Plain C++ on Core only, the item manager mirrors its slots here and
+ * runs the timers and actors around it. See ItemManager.Core.Benchmark.
+ */
+class ITEMMANAGERCORE_API FItemInventoryCore
+{
+public:
+
+	int32 Num() const { return Slots.Num(); }
+	const FItemCoreSlot& GetSlot(int32 SlotIndex) const { return Slots[SlotIndex]; }
+	bool ContainsItem(const void* ItemKey) const { return ItemKeyCounts.Contains(ItemKey); }
+
+	EItemAddError CanAddItem(const FItemInventoryRules& Rules, const void* ItemKey) const;
+
+	// Check a whole batch before adding any of it, null keys are invalid items
+	EItemAddError CanAddItems(const FItemInventoryRules& Rules, TConstArrayView<const void*> ItemKeys, int32& OutFailedEntry) const;
+
+	// Append a slot, no rule is checked
+	int32 AddSlot(const FItemCoreSlot& Slot);
+
+	// Remove slots last first, then call FinishRemoval once
+	void RemoveSlot(int32 SlotIndex);
+
+	// Move the current index over the removed slots, back to the first slot if the current one was removed.
+	// Return true if the current slot was removed.
+	bool FinishRemoval();
+
+	void SwapSlots(int32 FirstIndex, int32 SecondIndex);
+
+	int32 GetCurrentIndex() const { return CurrentIndex; }
+	void SetCurrentIndex(int32 NewIndex) { CurrentIndex = NewIndex; }
+	EItemSwitchPhase GetPhase() const { return Phase; }
+
+	// True while the switch lock is held, no other switch, swap or removal can start
+	bool IsSwitching() const { return bIsSwitching; }
+
+	FItemSwitchSelection SelectNextItem(const FItemInventoryRules& Rules) const;
+	FItemSwitchSelection SelectPreviousItem(const FItemInventoryRules& Rules) const;
+
+	// Make NewIndex the current slot and take the switch lock
+	EItemSwitchError BeginSwitch(int32 NewIndex, FItemSwitchTransition& OutTransition);
+
+	// Release the switch lock
+	void EndSwitching() { bIsSwitching = false; }
+
+	// The current item is spawned
+	void MarkSpawned() { Phase = EItemSwitchPhase::SP_Idle; }
+
+	bool CanDropCurrentItem(bool bHasItemActor) const;
+
+	SIZE_T GetAllocatedSize() const { return Slots.GetAllocatedSize() + ItemKeyCounts.GetAllocatedSize(); }
+
+private:
+
+	TArray<FItemCoreSlot> Slots;
+
+	// duplicate checks in O(1)
+	TMap<const void*, int32> ItemKeyCounts;
+
+	int32 CurrentIndex = 0;
+	EItemSwitchPhase Phase = EItemSwitchPhase::SP_None;
+	bool bIsSwitching = false;
+
+	// removal in progress, see FinishRemoval
+	int32 RemovedBeforeCurrent = 0;
+	bool bIsCurrentRemoved = false;
+};
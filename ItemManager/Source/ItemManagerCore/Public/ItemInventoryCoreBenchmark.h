@@ -0,0 +1,12 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace ItemInventoryCoreBenchmark
+{
+	// Run every case from 1e3 items up to MaxItems, ten times more at each step. One line per case and size.
+	// Used by the ItemManager.Core.Benchmark console command and the ItemManagerCoreBenchmark program.
+	ITEMMANAGERCORE_API void RunAll(FOutputDevice& Ar, int32 MaxItems);
+}
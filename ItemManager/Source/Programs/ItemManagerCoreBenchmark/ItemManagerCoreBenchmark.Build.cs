@@ -0,0 +1,20 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class ItemManagerCoreBenchmark : ModuleRules
+{
+	public ItemManagerCoreBenchmark(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PublicIncludePathModuleNames.Add("Launch");
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+				"Projects",
+				"ItemManagerCore"
+			}
+			);
+	}
+}
@@ -0,0 +1,28 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+using UnrealBuildTool;
+
+// Console program running the inventory rules benchmark on Core only, no engine, no UObject, no world
+[SupportedPlatforms(UnrealPlatformClass.Desktop)]
+public class ItemManagerCoreBenchmarkTarget : TargetRules
+{
+	public ItemManagerCoreBenchmarkTarget(TargetInfo Target) : base(Target)
+	{
+		Type = TargetType.Program;
+		LinkType = TargetLinkType.Monolithic;
+		LaunchModuleName = "ItemManagerCoreBenchmark";
+		DefaultBuildSettings = BuildSettingsVersion.Latest;
+		IncludeOrderVersion = EngineIncludeOrderVersion.Latest;
+
+		// ItemManagerCore is a RuntimeAndProgram module of the plugin, the other modules are left out
+		EnablePlugins.Add("ItemManager");
+
+		bBuildDeveloperTools = false;
+		bBuildWithEditorOnlyData = false;
+		bCompileAgainstEngine = false;
+		bCompileAgainstCoreUObject = false;
+		bCompileAgainstApplicationCore = false;
+		bCompileICU = false;
+		bIsBuildingConsoleApplication = true;
+	}
+}
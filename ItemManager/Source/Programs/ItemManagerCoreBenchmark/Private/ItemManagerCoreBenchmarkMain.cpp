@@ -0,0 +1,34 @@
+// Copyright Ryckbosch Arthur 2024. All Rights Reserved.
+
+
+#include "ItemInventoryCoreBenchmark.h"
+#include "RequiredProgramMainCPPInclude.h"
+
+IMPLEMENT_APPLICATION(ItemManagerCoreBenchmark, "ItemManagerCoreBenchmark");
+
+// Usage: ItemManagerCoreBenchmark [-MaxItems=1000000]
+INT32_MAIN_INT32_ARGC_TCHAR_ARGV()
+{
+	FTaskTagScope Scope(ETaskTag::EGameThread);
+	ON_SCOPE_EXIT
+	{
+		RequestEngineExit(TEXT("Benchmark done"));
+		FEngineLoop::AppPreExit();
+		FModuleManager::Get().UnloadModulesAtShutdown();
+		FEngineLoop::AppExit();
+	};
+
+	// Core and the modules of the program only
+	if (const int32 Result = GEngineLoop.PreInit(ArgC, ArgV))
+	{
+		return Result;
+	}
+
+	int32 MaxItems = 1000000;
+	FParse::Value(FCommandLine::Get(), TEXT("MaxItems="), MaxItems);
+
+	ItemInventoryCoreBenchmark::RunAll(*GLog, FMath::Clamp(MaxItems, 1000, 10000000));
+	GLog->Flush();
+
+	return 0;
+}